@@ -36,8 +36,13 @@
 #include "browser.h"
 #include "ui.h"
 
+enum {
+    /// Maximum number of objects in the visibility list
+    BROWSER_VISIBILITY_ROWS = 100,
+};
+
 /// Create a new ObjectBrowser
-void object_browser_make(ObjectBrowser *browser, Settings *settings) {
+void object_browser_make(ObjectBrowser *browser, Settings *settings, JobPool *pool) {
     browser->catalog = catalog_acquire();
     browser->arena = memory_arena_identity(ALIGNMENT8);
     browser->selected = (ObjectEntry) {
@@ -59,14 +64,114 @@ void object_browser_make(ObjectBrowser *browser, Settings *settings) {
         browser->heatmap.declinations[i] = object->position.declination;
     }
 
+    visibility_index_make(&browser->visibility.index, &browser->catalog, pool);
+    browser->visibility.results = (u32 *) memory_arena_alloc(&browser->arena, sizeof(u32) * object_count);
+    browser->visibility.threshold = 10.0;
+    browser->visibility.order = VISIBILITY_ORDER_ALTITUDE;
+    browser->visibility.above_only = true;
+
     browser->settings = settings;
 }
 
 /// Destroys the ObjectBrowser
 void object_browser_destroy(ObjectBrowser *browser) {
+    visibility_index_destroy(&browser->visibility.index);
     memory_arena_destroy(&browser->arena);
 }
 
+/// Formats the time until an event of the visibility index
+static void object_browser_format_offset(StringBuffer *buffer, f64 seconds) {
+    if (seconds < 0.0) {
+        snprintf(buffer->data, buffer->size, "-");
+        return;
+    }
+    u32 const minutes = (u32) (seconds / 60.0 + 0.5);
+    snprintf(buffer->data, buffer->size, "in %uh %02um", minutes / 60, minutes % 60);
+}
+
+/// Render the objects of the catalog that are visible, sorted in the selected order
+static void object_browser_render_visibility(ObjectBrowser *browser) {
+    static const char *orders[VISIBILITY_ORDER_COUNT] = { "Altitude", "Rise", "Transit", "Set", "Time Above" };
+    ui_combobox("Order", &browser->visibility.order, orders, VISIBILITY_ORDER_COUNT);
+    ui_property_real("Threshold", &browser->visibility.threshold, "%.1f °");
+    ui_tooltip_hovered("Altitude the rise, set and time above refer to");
+
+    bool above_only = browser->visibility.above_only;
+    igCheckbox("Above threshold only", &above_only);
+    browser->visibility.above_only = above_only;
+
+    VisibilitySnapshot const *snapshot = visibility_index_snapshot(&browser->visibility.index);
+    if (snapshot == nil) {
+        ui_note("Computing visibility...");
+        return;
+    }
+
+    VisibilityQuery query = {
+        .order = (VisibilityOrder) browser->visibility.order,
+        .min_altitude = browser->visibility.above_only ? snapshot->threshold : -90.0,
+        .min_duration = 0.0,
+    };
+    u32 *results = browser->visibility.results;
+    usize const count = visibility_snapshot_query(snapshot, &query, results, snapshot->count);
+    usize const rows = count < BROWSER_VISIBILITY_ROWS ? count : BROWSER_VISIBILITY_ROWS;
+    ui_note("%zu objects, showing %zu", count, rows);
+
+    ImGuiTableFlags const flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp;
+    if (!igBeginTable("##Visibility", 7, flags, (ImVec2) { 0.0f, 300.0f }, 0.0f)) {
+        return;
+    }
+    igTableSetupScrollFreeze(0, 1);
+    igTableSetupColumn("Object", ImGuiTableColumnFlags_None, 0, 0);
+    igTableSetupColumn("Alt", ImGuiTableColumnFlags_None, 0, 0);
+    igTableSetupColumn("Az", ImGuiTableColumnFlags_None, 0, 0);
+    igTableSetupColumn("Rise", ImGuiTableColumnFlags_None, 0, 0);
+    igTableSetupColumn("Transit", ImGuiTableColumnFlags_None, 0, 0);
+    igTableSetupColumn("Set", ImGuiTableColumnFlags_None, 0, 0);
+    igTableSetupColumn("Above", ImGuiTableColumnFlags_None, 0, 0);
+    igTableHeadersRow();
+
+    for (usize row = 0; row < rows; ++row) {
+        usize const index = results[row];
+        Object *object = browser->catalog.objects + index;
+        VisibilityEntry const *entry = snapshot->entries + index;
+
+        igTableNextRow(ImGuiTableRowFlags_None, 0);
+        igTableNextColumn();
+
+        // The objects follow the planets in the tree
+        ssize const tree_index = (ssize) (browser->catalog.planet_count + index);
+        b8 selected = browser->selected.tree_index == tree_index;
+
+        char object_name[128] = { 0 };
+        sprintf(object_name, "%" PRIu64 " (%s)", object->designation.index,
+                catalog_string(object->designation.catalog));
+        if (ui_tree_item_drag_drop_source(object_name, nil, selected, &browser->selected, sizeof browser->selected)) {
+            browser->selected.tree_index = tree_index;
+            browser->selected.classification = object->classification;
+            browser->selected.object = object;
+        }
+
+        char time_buffer[32] = { 0 };
+        StringBuffer time = { time_buffer, sizeof time_buffer };
+        igTableNextColumn();
+        ui_text("%.1f °", entry->altitude);
+        igTableNextColumn();
+        ui_text("%.1f °", entry->azimuth);
+        igTableNextColumn();
+        object_browser_format_offset(&time, entry->rise);
+        ui_text("%s", time_buffer);
+        igTableNextColumn();
+        object_browser_format_offset(&time, entry->transit);
+        ui_text("%s", time_buffer);
+        igTableNextColumn();
+        object_browser_format_offset(&time, entry->set);
+        ui_text("%s", time_buffer);
+        igTableNextColumn();
+        ui_text("%.1f h", entry->duration / 3600.0);
+    }
+    igEndTable();
+}
+
 /// Render the catalog map
 static void render_catalog_map(ObjectBrowser *browser, b8 fill_region) {
     ImVec2 region = { 0 };
@@ -99,6 +204,10 @@ static void object_browser_render_tree(ObjectBrowser *browser) {
         render_catalog_map(browser, false);
     }
 
+    if (igCollapsingHeader_BoolPtr("Visible Now", nil, ImGuiTreeNodeFlags_None)) {
+        object_browser_render_visibility(browser);
+    }
+
     if (igCollapsingHeader_BoolPtr("Objects", nil, ImGuiTreeNodeFlags_DefaultOpen)) {
         StringBuffer buffer = { browser->search_buffer, sizeof browser->search_buffer };
         ui_searchbar(&buffer, "##ObjectBrowserSearch", ICON_FA_MAGNIFYING_GLASS " Search for object...", true);
@@ -193,6 +302,30 @@ static void object_browser_render_properties_live_position(Horizontal *position)
             "North in degrees, ranging from 0° to 360°.");
 }
 
+static void object_browser_render_properties_visibility(ObjectBrowser *browser, Object *object) {
+    VisibilitySnapshot const *snapshot = visibility_index_snapshot(&browser->visibility.index);
+    if (snapshot == nil) {
+        return;
+    }
+    VisibilityEntry const *entry = snapshot->entries + (object - browser->catalog.objects);
+
+    ui_note("Visibility (next day)");
+    char time_buffer[32] = { 0 };
+    StringBuffer time = { time_buffer, sizeof time_buffer };
+    object_browser_format_offset(&time, entry->rise);
+    ui_property_text_readonly("Rise", time_buffer);
+    object_browser_format_offset(&time, entry->transit);
+    ui_property_text_readonly("Transit", time_buffer);
+    object_browser_format_offset(&time, entry->set);
+    ui_property_text_readonly("Set", time_buffer);
+    ui_tooltip_hovered("Rise and set refer to the threshold of the visibility list, they are empty if the object "
+                       "stays above or below it.");
+
+    ui_property_real_readonly("Culm", entry->culmination, "%f °");
+    ui_tooltip_hovered("Culmination (Culm) is the highest altitude the object reaches, at its transit.");
+    ui_property_real_readonly("Above", entry->duration / 3600.0, "%.2f h");
+}
+
 static void object_browser_render_properties_planet(ObjectBrowser *browser, Planet *planet) {
     if (ui_tree_node_begin(ICON_FA_BOOK " General", nil, false)) {
         Geographic observer = { 0 };
@@ -280,6 +413,7 @@ static void object_browser_render_properties_object(ObjectBrowser *browser, Obje
         ui_property_text_readonly("Const", constellation_string(object->constellation));
 
         object_browser_render_properties_live_position(&position_horizontal);
+        object_browser_render_properties_visibility(browser, object);
 
         ui_note("Observation Data (now)");
         ui_property_real_readonly("Ra", position.right_ascension, "%f °");
@@ -334,6 +468,12 @@ static void object_browser_render_properties(ObjectBrowser *browser) {
 
 /// Render the ObjectBrowser
 void object_browser_render(ObjectBrowser *browser) {
+    // The index refreshes in the background, the list is always at most one refresh behind
+    Geographic observer = { 0 };
+    observer.latitude = browser->settings->location.latitude;
+    observer.longitude = browser->settings->location.longitude;
+    visibility_index_update(&browser->visibility.index, &observer, browser->visibility.threshold);
+
     object_browser_render_tree(browser);
     object_browser_render_properties(browser);
 }
@@ -27,6 +27,7 @@
 #include <solaris/catalog.h>
 
 #include "settings.h"
+#include "visibility.h"
 
 typedef struct ObjectEntry {
     /// The classification is used to decide which type is stored here.
@@ -59,6 +60,23 @@ typedef struct ObjectBrowser {
         f64 *declinations;
     } heatmap;
 
+    /// Visibility of the whole catalog
+    struct {
+        VisibilityIndex index;
+
+        /// Catalog indices of the listed objects
+        u32 *results;
+
+        /// The horizon threshold in degrees
+        f64 threshold;
+
+        /// The order of the list, see VisibilityOrder
+        s32 order;
+
+        /// Whether only objects above the threshold are listed
+        b8 above_only;
+    } visibility;
+
     /// Selected object from the tree
     ObjectEntry selected;
 
@@ -78,7 +96,8 @@ typedef struct ObjectBrowser {
 /// Create a new ObjectBrowser
 /// @param browser The browser
 /// @param settings The settings
-void object_browser_make(ObjectBrowser *browser, Settings *settings);
+/// @param pool The job pool for the visibility index
+void object_browser_make(ObjectBrowser *browser, Settings *settings, JobPool *pool);
 
 /// Destroys the ObjectBrowser
 /// @param browser The browser
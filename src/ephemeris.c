@@ -0,0 +1,135 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <solaris/arena.h>
+#include <solaris/planet.h>
+
+#include "ephemeris.h"
+
+/// A contiguous part of a curve that is computed by one job
+typedef struct EphemerisChunk {
+    EphemerisCurve *curve;
+    usize offset;
+    usize steps;
+} EphemerisChunk;
+
+/// Drops a reference to the curve, the last one frees it
+static void ephemeris_curve_unref(EphemerisCurve *curve) {
+    if (__atomic_sub_fetch(&curve->references, 1, __ATOMIC_ACQ_REL) == 0) {
+        memory_arena_destroy(&curve->arena);
+        free(curve);
+    }
+}
+
+/// Builds the pyramids and publishes the curve, called once all positions are computed
+static void ephemeris_curve_finish(EphemerisCurve *curve) {
+    series_pyramid_make(&curve->azimuth_pyramid, &curve->arena, curve->xs, curve->azimuths, curve->count);
+    series_pyramid_make(&curve->altitude_pyramid, &curve->arena, curve->xs, curve->altitudes, curve->count);
+    __atomic_store_n(&curve->ready, true, __ATOMIC_RELEASE);
+}
+
+/// Computes the positions of one chunk and copies them into the curve
+static void ephemeris_chunk_compute(void *arg) {
+    EphemerisChunk *chunk = (EphemerisChunk *) arg;
+    EphemerisCurve *curve = chunk->curve;
+    EphemerisRequest const *request = &curve->request;
+
+    ComputeSpecification compute = { 0 };
+    compute.date = request->start;
+    time_add(&compute.date, (f64) (chunk->offset * request->step_size), request->unit);
+    compute.unit = request->unit;
+    compute.steps = chunk->steps;
+    compute.step_size = request->step_size;
+    compute.observer = request->observer;
+
+    // Solaris allocates the result, each chunk uses a short lived arena of its own
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+    ComputeResult result = { 0 };
+    if (request->object.classification == CLASSIFICATION_PLANET) {
+        compute_geographic_planet(&arena, &result, request->object.planet, &compute);
+    } else {
+        compute_geographic_fixed(&arena, &result, request->object.object, &compute);
+    }
+    memcpy(curve->azimuths + chunk->offset, result.azimuths, sizeof(f64) * chunk->steps);
+    memcpy(curve->altitudes + chunk->offset, result.altitudes, sizeof(f64) * chunk->steps);
+    memory_arena_destroy(&arena);
+    for (usize i = 0; i < chunk->steps; ++i) {
+        curve->xs[chunk->offset + i] = request->offset + (f64) (chunk->offset + i) * curve->step;
+    }
+
+    // The chunk that finishes last prepares the curve for plotting
+    if (__atomic_sub_fetch(&curve->remaining, 1, __ATOMIC_ACQ_REL) == 0) {
+        ephemeris_curve_finish(curve);
+    }
+    ephemeris_curve_unref(curve);
+}
+
+/// Requests the positions of an object
+EphemerisCurve *ephemeris_curve_request(JobPool *pool, EphemerisRequest const *request) {
+    usize const chunk_count = (request->steps + EPHEMERIS_CHUNK_STEPS - 1) / EPHEMERIS_CHUNK_STEPS;
+
+    // The curve, its chunks and the positions share a single allocation
+    usize const size = sizeof(EphemerisCurve) + sizeof(EphemerisChunk) * chunk_count + 3 * sizeof(f64) * request->steps;
+    EphemerisCurve *curve = (EphemerisCurve *) malloc(size);
+    EphemerisChunk *chunks = (EphemerisChunk *) (curve + 1);
+    curve->request = *request;
+    curve->xs = (f64 *) (chunks + chunk_count);
+    curve->azimuths = curve->xs + request->steps;
+    curve->altitudes = curve->azimuths + request->steps;
+    curve->count = request->steps;
+    curve->arena = memory_arena_identity(ALIGNMENT8);
+    curve->remaining = (u32) chunk_count;
+    curve->references = (u32) chunk_count + 1;
+    curve->ready = false;
+
+    Time next = request->start;
+    time_add(&next, (f64) request->step_size, request->unit);
+    curve->step = time_difference(&request->start, &next);
+    if (chunk_count == 0) {
+        ephemeris_curve_finish(curve);
+    }
+
+    for (usize i = 0; i < chunk_count; ++i) {
+        chunks[i].curve = curve;
+        chunks[i].offset = i * EPHEMERIS_CHUNK_STEPS;
+        chunks[i].steps = request->steps - chunks[i].offset < EPHEMERIS_CHUNK_STEPS ? request->steps - chunks[i].offset
+                                                                                   : EPHEMERIS_CHUNK_STEPS;
+    }
+    for (usize i = 0; i < chunk_count; ++i) {
+        job_pool_submit(pool, ephemeris_chunk_compute, chunks + i);
+    }
+    return curve;
+}
+
+/// Checks whether all positions of the curve were computed
+b8 ephemeris_curve_ready(EphemerisCurve const *curve) {
+    return __atomic_load_n(&curve->ready, __ATOMIC_ACQUIRE);
+}
+
+/// Releases the curve
+void ephemeris_curve_release(EphemerisCurve *curve) {
+    ephemeris_curve_unref(curve);
+}
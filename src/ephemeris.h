@@ -0,0 +1,109 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef KOPERNIKUS_EPHEMERIS_H
+#define KOPERNIKUS_EPHEMERIS_H
+
+#include <libcore/jobs.h>
+#include <libcore/series.h>
+#include <solaris/object.h>
+
+#include "browser.h"
+
+enum {
+    /// Maximum number of positions that are computed by a single job, longer spans are
+    /// split into chunks that are computed in parallel
+    EPHEMERIS_CHUNK_STEPS = 512,
+};
+
+/// The positions of an object that should be computed
+typedef struct EphemerisRequest {
+    /// The object or planet
+    ObjectEntry object;
+
+    /// The time of the first position
+    Time start;
+
+    /// The unit of the time between two positions
+    TimeUnit unit;
+
+    /// The time between two positions in units
+    usize step_size;
+
+    /// The number of positions
+    usize steps;
+
+    /// The x value of the first position, the x values of the curve advance in seconds from there
+    f64 offset;
+
+    /// The location of the observer
+    Geographic observer;
+} EphemerisRequest;
+
+/// Horizontal positions of an object over time, they are computed in the background
+typedef struct EphemerisCurve {
+    /// The request the curve was computed for
+    EphemerisRequest request;
+
+    /// The positions and their x values, only valid once the curve is ready
+    f64 *xs;
+    f64 *azimuths;
+    f64 *altitudes;
+    usize count;
+
+    /// The time between two positions in seconds
+    f64 step;
+
+    /// Decimation pyramids of the positions for plotting, only valid once the curve is ready
+    SeriesPyramid azimuth_pyramid;
+    SeriesPyramid altitude_pyramid;
+
+    /// Arena of the pyramids
+    MemoryArena arena;
+
+    /// The number of chunks that are not computed yet
+    u32 remaining;
+
+    /// Whether all positions and the pyramids are computed
+    b8 ready;
+
+    /// The chunks and the owner that still refer to the curve
+    u32 references;
+} EphemerisCurve;
+
+/// Requests the positions of an object, the chunks of the curve are computed by the job pool
+/// @param pool The job pool
+/// @param request The request
+/// @return The curve, it must be released by the caller
+EphemerisCurve *ephemeris_curve_request(JobPool *pool, EphemerisRequest const *request);
+
+/// Checks whether all positions of the curve were computed
+/// @param curve The curve
+/// @return Whether the curve is ready
+b8 ephemeris_curve_ready(EphemerisCurve const *curve);
+
+/// Releases the curve, it is freed once the chunks that are still being computed are done
+/// @param curve The curve
+void ephemeris_curve_release(EphemerisCurve *curve);
+
+#endif// KOPERNIKUS_EPHEMERIS_H
@@ -21,105 +21,867 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
 #include <cimgui.h>
+#include <cimplot.h>
 #include <libcore/arch/thread.h>
 #include <libcore/timer.h>
 
 #include "gear.h"
 #include "ui.h"
 
-/// Performs the actual data sample for a telescope device
-static void gear_sample_task_perform_telescope(MemoryArena *arena, AlpacaDevice *device) {
-    // TODO: handle results
-    alpaca_telescope_altitude(device, arena, &device->payload.altitude);
-    alpaca_telescope_azimuth(device, arena, &device->payload.azimuth);
-}
-
-/// Performs the actual data sample for a observing conditions devie
-static void gear_sample_task_perform_observing_conds(MemoryArena *arena, AlpacaDevice *device) {
-    // TODO: handle results
-    alpaca_observing_conds_average_period(device, arena, &device->payload.average_period);
-    alpaca_observing_conds_cloud_cover(device, arena, &device->payload.cloud_cover);
-    alpaca_observing_conds_dew_point(device, arena, &device->payload.dew_point);
-    alpaca_observing_conds_humidity(device, arena, &device->payload.humidity);
-    alpaca_observing_conds_pressure(device, arena, &device->payload.pressure);
-    alpaca_observing_conds_rain_rate(device, arena, &device->payload.rain_rate);
-    alpaca_observing_conds_sky_brightness(device, arena, &device->payload.sky_brightness);
-    alpaca_observing_conds_sky_quality(device, arena, &device->payload.sky_quality);
-    alpaca_observing_conds_sky_temperature(device, arena, &device->payload.sky_temperature);
-    alpaca_observing_conds_star_fwhm(device, arena, &device->payload.star_fwhm);
-    alpaca_observing_conds_temperature(device, arena, &device->payload.temperature);
-    alpaca_observing_conds_wind_direction(device, arena, &device->payload.wind_direction);
-    alpaca_observing_conds_wind_gust(device, arena, &device->payload.wind_gust);
-    alpaca_observing_conds_wind_speed(device, arena, &device->payload.wind_speed);
-}
-
-/// Performs the actual data sample
-static void gear_sample_task_perform(Gear *gear) {
+enum {
+    /// Upper bound for a single sleep of the sample thread, keeps it responsive to stops and new devices
+    GEAR_SCHEDULE_MAX_SLEEP = 250,
+
+    /// Height of the history plots
+    GEAR_HISTORY_PLOT_HEIGHT = 120,
+
+    /// Default speed-up of telemetry replays
+    GEAR_REPLAY_SPEED = 60,
+
+    /// Time (ms) the discovery gets to collect responses before the found servers are connected
+    GEAR_DISCOVERY_GRACE = 1500,
+
+    /// Number of workers that perform the requests of all servers
+    GEAR_WORKER_COUNT = 4,
+
+    /// Maximum number of jobs per server that are performed at once, a dead server never
+    /// occupies more workers than this
+    GEAR_SERVER_CONCURRENCY = 2,
+
+    /// Maximum number of jobs that are queued or performed at once
+    GEAR_JOB_CAPACITY = 64,
+
+    /// Interval (ms) in which a stop checks whether the threads exited
+    GEAR_STOP_POLL = 1,
+
+    /// Delay (ms) of due fields whose device or server is still busy
+    GEAR_SCHEDULE_DEFER = 5,
+};
+
+/// The sampling rate of a payload field, the bounds are multiples of the sampling interval
+typedef struct GearSampleRate {
+    /// The shortest interval, used while the value is changing
+    f64 min;
+
+    /// The longest interval, approached while the value is stable
+    f64 max;
+
+    /// Changes up to this magnitude are considered stable
+    f64 epsilon;
+} GearSampleRate;
+
+/// Rates of the observing conditions fields
+static const GearSampleRate gear_observing_conds_rates[ALPACA_FIELD_OBSERVING_CONDS_COUNT] = {
+    [ALPACA_FIELD_AVERAGE_PERIOD] = { 1.0, 60.0, 0.0 },   [ALPACA_FIELD_CLOUD_COVER] = { 1.0, 10.0, 0.5 },
+    [ALPACA_FIELD_DEW_POINT] = { 1.0, 10.0, 0.05 },       [ALPACA_FIELD_HUMIDITY] = { 1.0, 10.0, 0.5 },
+    [ALPACA_FIELD_PRESSURE] = { 1.0, 10.0, 0.1 },         [ALPACA_FIELD_RAIN_RATE] = { 1.0, 10.0, 0.01 },
+    [ALPACA_FIELD_SKY_BRIGHTNESS] = { 1.0, 10.0, 0.01 },  [ALPACA_FIELD_SKY_QUALITY] = { 1.0, 10.0, 0.01 },
+    [ALPACA_FIELD_SKY_TEMPERATURE] = { 1.0, 10.0, 0.05 }, [ALPACA_FIELD_STAR_FWHM] = { 1.0, 10.0, 0.01 },
+    [ALPACA_FIELD_TEMPERATURE] = { 1.0, 10.0, 0.05 },     [ALPACA_FIELD_WIND_DIRECTION] = { 1.0, 5.0, 1.0 },
+    [ALPACA_FIELD_WIND_GUST] = { 1.0, 5.0, 0.1 },         [ALPACA_FIELD_WIND_SPEED] = { 1.0, 5.0, 0.1 },
+};
+
+/// Rates of the telescope fields, a slewing mount is polled ten times per sampling interval
+static const GearSampleRate gear_telescope_rates[ALPACA_FIELD_TELESCOPE_COUNT] = {
+    [ALPACA_FIELD_ALTITUDE] = { 0.1, 1.0, 0.001 },       [ALPACA_FIELD_AZIMUTH] = { 0.1, 1.0, 0.001 },
+    [ALPACA_FIELD_RIGHT_ASCENSION] = { 0.1, 1.0, 0.0001 }, [ALPACA_FIELD_DECLINATION] = { 0.1, 1.0, 0.001 },
+    [ALPACA_FIELD_SIDEREAL_TIME] = { 1.0, 10.0, 0.01 },  [ALPACA_FIELD_TRACKING] = { 1.0, 5.0, 0.0 },
+    [ALPACA_FIELD_SLEWING] = { 0.1, 1.0, 0.0 },          [ALPACA_FIELD_AT_PARK] = { 1.0, 10.0, 0.0 },
+};
+
+/// Retrieves the sampling rate of a payload field
+static GearSampleRate gear_sample_rate(AlpacaDevice const *device, usize field) {
+    switch (device->type) {
+        case ALPACA_DEVICE_TYPE_OBSERVING_CONDITIONS:
+            return gear_observing_conds_rates[field];
+        case ALPACA_DEVICE_TYPE_TELESCOPE:
+            return gear_telescope_rates[field];
+        default:
+            break;
+    }
+    return (GearSampleRate) { 1.0, 1.0, 0.0 };
+}
+
+/// A payload field of a device that is due at a specific time
+typedef struct GearScheduleEntry {
+    /// Monotonic time (ms) at which the field is sampled next
+    f64 due;
+
+    /// The current interval (ms) of the field
+    f64 interval;
+
+    /// The index of the device within the device list
+    usize device;
+
+    /// The index of the field within the device payload
+    usize field;
+} GearScheduleEntry;
+
+/// Priority queue of payload fields, ordered by their due time
+typedef struct GearSchedule {
+    MemoryArena arena;
+    GearScheduleEntry *entries;
+    usize count;
+
+    /// The device list the schedule was built for
+    AlpacaDevice *devices;
+    usize device_count;
+
+    /// The server index of every device
+    usize *servers;
+
+    /// Whether a job of the device is queued or performed
+    b8 *busy;
+
+    /// Whether the device was connected, its fields are not sampled before
+    b8 *connected;
+
+    /// The number of jobs per server that are queued or performed
+    usize in_flight[GEAR_MAX_CLIENTS];
+
+    /// The health of every server, jobs of unreachable servers are held back
+    AlpacaHealth health[GEAR_MAX_CLIENTS];
+
+    /// The workers that perform the jobs
+    struct GearPool *pool;
+
+    /// Receives every sample, may be nil
+    TelemetryWriter *telemetry;
+} GearSchedule;
+
+/// The kinds of jobs that are performed by the workers
+typedef enum GearJobKind {
+    /// Connects consecutive devices of one server
+    GEAR_JOB_CONNECT,
+
+    /// Samples the due fields of one device
+    GEAR_JOB_SAMPLE,
+} GearJobKind;
+
+/// A unit of work that is performed by one of the workers, everything but the results
+/// is written by the scheduler before the job is submitted
+typedef struct GearJob {
+    GearJobKind kind;
+
+    /// The server the job talks to
+    usize server;
+
+    /// The index of the first device within the device list
+    usize device;
+
+    /// The first device of the job
+    AlpacaDevice *devices;
+
+    /// The number of devices of a connect job
+    usize device_count;
+
+    /// The schedule entries, fields, previous values and timestamps of a sample job
+    GearScheduleEntry entries[ALPACA_DEVICE_PAYLOAD_CAPACITY];
+    usize fields[ALPACA_DEVICE_PAYLOAD_CAPACITY];
+    f64 previous[ALPACA_DEVICE_PAYLOAD_CAPACITY];
+    f64 stamped[ALPACA_DEVICE_PAYLOAD_CAPACITY];
+    usize count;
+
+    /// The results of a sample job, written by the worker
+    AlpacaResult results[ALPACA_DEVICE_PAYLOAD_CAPACITY];
+
+    /// Whether the server responded to the requests of the job, written by the worker
+    b8 reachable;
+
+    /// Monotonic time (ms) at which the worker started the job
+    f64 started;
+
+    /// Monotonic time (ms) at which the worker finished the job
+    f64 finished;
+} GearJob;
+
+/// First in, first out queue of job slots
+typedef struct GearJobQueue {
+    usize slots[GEAR_JOB_CAPACITY];
+    usize head;
+    usize count;
+} GearJobQueue;
+
+/// Fixed set of workers that is shared by all servers, each worker drives its own multi engine
+typedef struct GearPool {
+    GearJob jobs[GEAR_JOB_CAPACITY];
+
+    /// Slots that are not in use, only touched by the scheduler
+    usize free[GEAR_JOB_CAPACITY];
+    usize free_count;
+
+    /// Guards the pending and the finished queue
+    Mutex *mutex;
+    GearJobQueue pending;
+    GearJobQueue finished;
+
+    /// Posted for every pending job and once per worker when the pool stops, idle workers block on it
+    Semaphore *pending_jobs;
+
+    /// Posted for every finished job, the scheduler blocks on it until the next field is due
+    Semaphore *finished_jobs;
+
+    /// Controls whether the workers should continue
+    b8 running;
+
+    /// The number of workers that did not exit yet
+    u32 workers;
+} GearPool;
+
+/// Appends a slot to the queue, the queue never overflows as there are only as many slots as it holds
+static void gear_job_queue_push(GearJobQueue *queue, usize slot) {
+    queue->slots[(queue->head + queue->count) % GEAR_JOB_CAPACITY] = slot;
+    queue->count++;
+}
+
+/// Removes the oldest slot from the queue
+static b8 gear_job_queue_pop(GearJobQueue *queue, usize *slot) {
+    if (queue->count == 0) {
+        return false;
+    }
+    *slot = queue->slots[queue->head];
+    queue->head = (queue->head + 1) % GEAR_JOB_CAPACITY;
+    queue->count--;
+    return true;
+}
+
+/// Performs a job on the calling worker
+static void gear_job_perform(GearJob *job, HttpMulti *multi, MemoryArena *arena) {
+    job->started = timer_now();
+    switch (job->kind) {
+        case GEAR_JOB_CONNECT:
+            alpaca_device_connect_many(job->devices, job->device_count, multi);
+            job->reachable = false;
+            for (usize i = 0; i < job->device_count; ++i) {
+                job->reachable |= job->devices[i].state == ALPACA_DEVICE_STATE_READY;
+            }
+            break;
+        case GEAR_JOB_SAMPLE: {
+            // Requests that failed without a status never reached the server
+            AlpacaResult const result =
+                    alpaca_device_sample_fields(job->devices, multi, arena, job->fields, job->results, job->count);
+            job->reachable = result.ok || result.status != 0;
+            break;
+        }
+    }
+    job->finished = timer_now();
+}
+
+static void *gear_worker_task(void *args) {
+    GearPool *pool = (GearPool *) args;
+    HttpMulti multi = { 0 };
+    http_multi_make(&multi);
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+
+    for (;;) {
+        semaphore_wait(pool->pending_jobs);
+        if (!__atomic_load_n(&pool->running, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        usize slot = 0;
+        mutex_lock(pool->mutex);
+        b8 const found = gear_job_queue_pop(&pool->pending, &slot);
+        mutex_unlock(pool->mutex);
+        if (!found) {
+            continue;
+        }
+
+        gear_job_perform(pool->jobs + slot, &multi, &arena);
+        memory_arena_clear(&arena);
+
+        mutex_lock(pool->mutex);
+        gear_job_queue_push(&pool->finished, slot);
+        mutex_unlock(pool->mutex);
+        semaphore_post(pool->finished_jobs);
+    }
+
+    memory_arena_destroy(&arena);
+    http_multi_destroy(&multi);
+    __atomic_sub_fetch(&pool->workers, 1, __ATOMIC_RELEASE);
+    return nil;
+}
+
+/// Creates the pool and starts its workers
+static GearPool *gear_pool_new(void) {
+    GearPool *pool = (GearPool *) calloc(1, sizeof(GearPool));
+    pool->mutex = mutex_new();
+    pool->pending_jobs = semaphore_new(0);
+    pool->finished_jobs = semaphore_new(0);
+    for (usize i = 0; i < GEAR_JOB_CAPACITY; ++i) {
+        pool->free[i] = GEAR_JOB_CAPACITY - 1 - i;
+    }
+    pool->free_count = GEAR_JOB_CAPACITY;
+    pool->running = true;
+    pool->workers = GEAR_WORKER_COUNT;
+    for (usize i = 0; i < GEAR_WORKER_COUNT; ++i) {
+        thread_create(gear_worker_task, pool);
+    }
+    return pool;
+}
+
+/// Stops the workers and frees the pool once the jobs they are performing are done
+static void gear_pool_free(GearPool *pool) {
+    __atomic_store_n(&pool->running, false, __ATOMIC_RELEASE);
+    for (usize i = 0; i < GEAR_WORKER_COUNT; ++i) {
+        semaphore_post(pool->pending_jobs);
+    }
+    while (__atomic_load_n(&pool->workers, __ATOMIC_ACQUIRE) > 0) {
+        thread_sleep(GEAR_STOP_POLL);
+    }
+    semaphore_free(pool->finished_jobs);
+    semaphore_free(pool->pending_jobs);
+    mutex_free(pool->mutex);
+    free(pool);
+}
+
+/// Takes an unused job from the pool, nil if all jobs are in use
+static GearJob *gear_pool_acquire(GearPool *pool) {
+    if (pool->free_count == 0) {
+        return nil;
+    }
+    GearJob *job = pool->jobs + pool->free[--pool->free_count];
+    memset(job, 0, sizeof(GearJob));
+    return job;
+}
+
+/// Hands a job to the workers
+static void gear_pool_submit(GearPool *pool, GearJob *job) {
+    mutex_lock(pool->mutex);
+    gear_job_queue_push(&pool->pending, (usize) (job - pool->jobs));
+    mutex_unlock(pool->mutex);
+    semaphore_post(pool->pending_jobs);
+}
+
+/// Blocks until a job finished or the timeout (ms) elapsed
+static void gear_pool_wait(GearPool *pool, f64 timeout) {
+    semaphore_wait_timeout(pool->finished_jobs, (u64) fmax(timeout, 0.0));
+}
+
+/// Takes a finished job from the pool, it must be released once its results were processed
+static GearJob *gear_pool_finished(GearPool *pool) {
+    usize slot = 0;
+    mutex_lock(pool->mutex);
+    b8 const found = gear_job_queue_pop(&pool->finished, &slot);
+    mutex_unlock(pool->mutex);
+    return found ? pool->jobs + slot : nil;
+}
+
+/// Returns a job to the pool
+static void gear_pool_release(GearPool *pool, GearJob *job) {
+    pool->free[pool->free_count++] = (usize) (job - pool->jobs);
+}
+
+/// Whether jobs are queued or performed
+static b8 gear_pool_busy(GearPool const *pool) {
+    return pool->free_count < GEAR_JOB_CAPACITY;
+}
+
+/// Moves the entry at the specified index up until the heap property holds
+static void gear_schedule_sift_up(GearSchedule *schedule, usize index) {
+    GearScheduleEntry *entries = schedule->entries;
+    while (index > 0) {
+        usize parent = (index - 1) / 2;
+        if (entries[parent].due <= entries[index].due) {
+            break;
+        }
+        GearScheduleEntry swap = entries[parent];
+        entries[parent] = entries[index];
+        entries[index] = swap;
+        index = parent;
+    }
+}
+
+/// Moves the entry at the specified index down until the heap property holds
+static void gear_schedule_sift_down(GearSchedule *schedule, usize index) {
+    GearScheduleEntry *entries = schedule->entries;
+    for (;;) {
+        usize smallest = index;
+        usize left = 2 * index + 1;
+        usize right = left + 1;
+        if (left < schedule->count && entries[left].due < entries[smallest].due) {
+            smallest = left;
+        }
+        if (right < schedule->count && entries[right].due < entries[smallest].due) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        GearScheduleEntry swap = entries[smallest];
+        entries[smallest] = entries[index];
+        entries[index] = swap;
+        index = smallest;
+    }
+}
+
+/// Inserts an entry into the schedule
+static void gear_schedule_push(GearSchedule *schedule, GearScheduleEntry const *entry) {
+    schedule->entries[schedule->count] = *entry;
+    schedule->count++;
+    gear_schedule_sift_up(schedule, schedule->count - 1);
+}
+
+/// Removes the entry that is due first from the schedule
+static GearScheduleEntry gear_schedule_pop(GearSchedule *schedule) {
+    GearScheduleEntry entry = schedule->entries[0];
+    schedule->count--;
+    schedule->entries[0] = schedule->entries[schedule->count];
+    gear_schedule_sift_down(schedule, 0);
+    return entry;
+}
+
+/// Retrieves the index of the server the device at the specified index belongs to
+static usize gear_device_server(Gear const *gear, usize device) {
+    usize server = 0;
+    for (usize i = 1; i < gear->client_count; ++i) {
+        if (gear->client_devices[i] <= device) {
+            server = i;
+        }
+    }
+    return server;
+}
+
+/// Submits a connect job for every run of consecutive devices of the same server that is not
+/// connected yet, runs of unreachable servers are retried as their circuit breaker allows
+static void gear_schedule_connect(GearSchedule *schedule, f64 now) {
+    usize first = 0;
+    while (first < schedule->device_count) {
+        usize last = first + 1;
+        while (last < schedule->device_count && schedule->servers[last] == schedule->servers[first]) {
+            last++;
+        }
+
+        usize const server = schedule->servers[first];
+        usize const run = first;
+        first = last;
+        if (schedule->connected[run] || schedule->busy[run] || schedule->in_flight[server] >= GEAR_SERVER_CONCURRENCY) {
+            continue;
+        }
+
+        GearJob *job = gear_pool_acquire(schedule->pool);
+        if (job == nil) {
+            break;
+        }
+        if (!alpaca_health_allow(schedule->health + server, now)) {
+            gear_pool_release(schedule->pool, job);
+            continue;
+        }
+
+        job->kind = GEAR_JOB_CONNECT;
+        job->server = server;
+        job->device = run;
+        job->devices = schedule->devices + run;
+        job->device_count = last - run;
+        for (usize i = run; i < last; ++i) {
+            schedule->busy[i] = true;
+        }
+        schedule->in_flight[server]++;
+        gear_pool_submit(schedule->pool, job);
+    }
+}
+
+/// Rebuilds the schedule if the device list has changed, all fields become due immediately
+/// and are sampled once their device is connected
+/// @return Whether the schedule matches the device list, jobs of the previous list are drained first
+static b8 gear_schedule_sync(GearSchedule *schedule, Gear *gear, f64 now) {
+    if (schedule->devices == gear->devices.devices && schedule->device_count == gear->devices.count) {
+        return true;
+    }
+    if (gear_pool_busy(schedule->pool)) {
+        return false;
+    }
+
+    memory_arena_clear(&schedule->arena);
+    schedule->devices = gear->devices.devices;
+    schedule->device_count = gear->devices.count;
+    schedule->count = 0;
+    usize const capacity = ALPACA_DEVICE_PAYLOAD_CAPACITY * (schedule->device_count + 1);
+    schedule->entries =
+            (GearScheduleEntry *) memory_arena_alloc(&schedule->arena, sizeof(GearScheduleEntry) * capacity);
+    schedule->servers = (usize *) memory_arena_alloc(&schedule->arena, sizeof(usize) * (schedule->device_count + 1));
+    schedule->busy = (b8 *) memory_arena_alloc(&schedule->arena, sizeof(b8) * (schedule->device_count + 1));
+    schedule->connected = (b8 *) memory_arena_alloc(&schedule->arena, sizeof(b8) * (schedule->device_count + 1));
+    memset(schedule->in_flight, 0, sizeof schedule->in_flight);
+    for (usize i = 0; i < GEAR_MAX_CLIENTS; ++i) {
+        alpaca_health_make(schedule->health + i);
+    }
+    for (usize i = 0; i < schedule->device_count; ++i) {
+        schedule->servers[i] = gear_device_server(gear, i);
+        schedule->busy[i] = false;
+        schedule->connected[i] = false;
+    }
+
+    f64 const base = 1000.0 * gear->sampling_interval;
+    for (usize i = 0; i < schedule->device_count; ++i) {
+        AlpacaDevice const *device = schedule->devices + i;
+        usize const field_count = alpaca_device_field_count(device);
+        for (usize field = 0; field < field_count; ++field) {
+            GearSampleRate const rate = gear_sample_rate(device, field);
+            GearScheduleEntry entry = { .due = now, .interval = rate.min * base, .device = i, .field = field };
+            gear_schedule_push(schedule, &entry);
+        }
+        if (schedule->telemetry != nil) {
+            telemetry_writer_schema(schedule->telemetry, (u16) i, device);
+        }
+    }
+    return true;
+}
+
+/// Adapts the interval of an entry after it was sampled, changing values are polled at the
+/// minimum rate, stable values and failing reads back off towards the maximum rate
+static void gear_schedule_adapt(GearScheduleEntry *entry, GearSampleRate const *rate, f64 base, f64 change, b8 ok) {
+    f64 const min = rate->min * base;
+    f64 const max = rate->max * base;
+    if (!ok) {
+        entry->interval *= 2.0;
+    } else if (change > rate->epsilon) {
+        entry->interval = min;
+    } else {
+        entry->interval *= 1.5;
+    }
+    entry->interval = fmin(fmax(entry->interval, min), max);
+}
+
+/// Hands all due fields to the workers, the fields of one device form a single job. Fields of
+/// devices that are busy or whose server reached its concurrency limit are deferred, so a slow
+/// server only delays its own devices.
+static void gear_schedule_dispatch(GearSchedule *schedule, Gear *gear, f64 now) {
     MemoryArena *arena = &gear->sample_arena;
 
-    // Telescope sample
-    for (usize i = 0; i < gear->devices.count; ++i) {
-        AlpacaDevice *device = gear->devices.devices + i;
-        switch (device->type) {
-            case ALPACA_DEVICE_TYPE_NONE:
-                break;
-            case ALPACA_DEVICE_TYPE_OBSERVING_CONDITIONS:
-                gear_sample_task_perform_observing_conds(arena, device);
-                break;
-            case ALPACA_DEVICE_TYPE_TELESCOPE:
-                gear_sample_task_perform_telescope(arena, device);
-                break;
-            default:
-                break;
+    // Collect the due entries
+    usize due_count = 0;
+    GearScheduleEntry *due =
+            (GearScheduleEntry *) memory_arena_alloc(arena, sizeof(GearScheduleEntry) * schedule->count);
+    while (schedule->count > 0 && schedule->entries[0].due <= now) {
+        due[due_count++] = gear_schedule_pop(schedule);
+    }
+
+    b8 *dispatched = (b8 *) memory_arena_alloc(arena, sizeof(b8) * due_count);
+    for (usize i = 0; i < due_count; ++i) {
+        dispatched[i] = false;
+    }
+
+    for (usize i = 0; i < due_count; ++i) {
+        if (dispatched[i]) {
+            continue;
+        }
+
+        usize const index = due[i].device;
+        usize const server = schedule->servers[index];
+        b8 const available = schedule->connected[index] && !schedule->busy[index] &&
+                             schedule->in_flight[server] < GEAR_SERVER_CONCURRENCY;
+        GearJob *job = available ? gear_pool_acquire(schedule->pool) : nil;
+        if (job != nil && !alpaca_health_allow(schedule->health + server, now)) {
+            gear_pool_release(schedule->pool, job);
+            job = nil;
+        }
+
+        // Fields of an unreachable server wait for its next probe instead of being polled
+        AlpacaHealth const *health = schedule->health + server;
+        f64 const deferred = health->state == ALPACA_HEALTH_OPEN ? fmax(health->retry, now + GEAR_SCHEDULE_DEFER)
+                                                                  : now + GEAR_SCHEDULE_DEFER;
+
+        // Batch all due fields of this device, other threads may write the payload meanwhile so
+        // the previous values are taken from the published snapshot
+        AlpacaDevice *device = schedule->devices + index;
+        AlpacaDeviceSnapshot snapshot = { 0 };
+        alpaca_device_snapshot(device, &snapshot);
+        for (usize j = i; j < due_count; ++j) {
+            if (dispatched[j] || due[j].device != index) {
+                continue;
+            }
+            dispatched[j] = true;
+            if (job == nil) {
+                due[j].due = deferred;
+                gear_schedule_push(schedule, due + j);
+                continue;
+            }
+            job->entries[job->count] = due[j];
+            job->fields[job->count] = due[j].field;
+            job->previous[job->count] = snapshot.payload.values[due[j].field];
+            job->stamped[job->count] = snapshot.stamps[due[j].field].timestamp;
+            job->count++;
+        }
+
+        if (job != nil) {
+            job->kind = GEAR_JOB_SAMPLE;
+            job->server = server;
+            job->device = index;
+            job->devices = device;
+            schedule->busy[index] = true;
+            schedule->in_flight[server]++;
+            gear_pool_submit(schedule->pool, job);
         }
     }
 }
 
-/// The thread runner for the gear sample
+/// Processes the jobs the workers finished, the history, the telemetry and the schedule are
+/// only touched by the scheduler
+static void gear_schedule_complete(GearSchedule *schedule, Gear *gear) {
+    f64 const base = 1000.0 * gear->sampling_interval;
+    GearJob *job = nil;
+    while ((job = gear_pool_finished(schedule->pool)) != nil) {
+        schedule->in_flight[job->server]--;
+        alpaca_health_record(schedule->health + job->server, job->reachable, job->finished - job->started,
+                             job->finished);
+        if (job->kind == GEAR_JOB_CONNECT) {
+            for (usize i = 0; i < job->device_count; ++i) {
+                schedule->busy[job->device + i] = false;
+                schedule->connected[job->device + i] = job->reachable;
+            }
+            gear_pool_release(schedule->pool, job);
+            continue;
+        }
+
+        AlpacaDevice *device = job->devices;
+        schedule->busy[job->device] = false;
+        AlpacaDeviceSnapshot snapshot = { 0 };
+        alpaca_device_snapshot(device, &snapshot);
+        for (usize j = 0; j < job->count; ++j) {
+            GearScheduleEntry *entry = job->entries + j;
+            GearSampleRate const rate = gear_sample_rate(device, entry->field);
+
+            // Only actual reads enter the history, values served from the cache do not
+            AlpacaDeviceStamp const *stamp = snapshot.stamps + entry->field;
+            if (stamp->valid && stamp->timestamp != job->stamped[j]) {
+                f64 const value = snapshot.payload.values[entry->field];
+                time_series_push(device->history + entry->field, stamp->timestamp / 1000.0, value);
+                if (schedule->telemetry != nil) {
+                    telemetry_writer_push(schedule->telemetry, (u16) entry->device, (u8) entry->field,
+                                          stamp->timestamp / 1000.0, value);
+                }
+            }
+
+            f64 const change = fabs(snapshot.payload.values[entry->field] - job->previous[j]);
+            gear_schedule_adapt(entry, &rate, base, change, job->results[j].ok);
+            entry->due = job->finished + entry->interval;
+            gear_schedule_push(schedule, entry);
+        }
+        gear_pool_release(schedule->pool, job);
+    }
+}
+
+/// Publishes the health of the servers for the devices window
+static void gear_schedule_publish_health(GearSchedule const *schedule, Gear *gear) {
+    seqlock_write_begin(&gear->health_lock);
+    memcpy(gear->health, schedule->health, sizeof gear->health);
+    seqlock_write_end(&gear->health_lock);
+}
+
 static void *gear_sample_task(void *args) {
     Gear *gear = (Gear *) args;
 
-    Timer timer = { 0 };
-    timer_make(&timer);
+    // The schedule and the workers are bound to the sampling thread
+    GearSchedule schedule = { 0 };
+    schedule.arena = memory_arena_identity(ALIGNMENT8);
+    schedule.pool = gear_pool_new();
+
+    schedule.telemetry = gear->telemetry_path[0] != 0 ? telemetry_writer_open(gear->telemetry_path) : nil;
+
+    while (__atomic_load_n(&gear->sample, __ATOMIC_ACQUIRE)) {
+        gear_schedule_complete(&schedule, gear);
+
+        f64 const now = timer_now();
+        // The schedule is only rebuilt for changed devices once the jobs in flight finished
+        if (!gear_schedule_sync(&schedule, gear, now)) {
+            gear_pool_wait(schedule.pool, GEAR_SCHEDULE_MAX_SLEEP);
+            continue;
+        }
+
+        // The devices are connected by the workers, each one is shown as ready once its own requests are done
+        gear_schedule_connect(&schedule, now);
+        gear_schedule_publish_health(&schedule, gear);
 
-    while (gear->sample) {
-        // Start the timer
-        timer_start(&timer);
+        // Sleep until the next field is due, finished jobs wake the thread right away
+        f64 const wait = schedule.count > 0 ? schedule.entries[0].due - now : GEAR_SCHEDULE_MAX_SLEEP;
+        if (wait > 0.0) {
+            gear_pool_wait(schedule.pool, fmin(wait, GEAR_SCHEDULE_MAX_SLEEP) + 1.0);
+            continue;
+        }
 
-        // Clear the arena before sample
+        // Clear the arena before dispatch
         memory_arena_clear(&gear->sample_arena);
-        gear_sample_task_perform(gear);
+        gear_schedule_dispatch(&schedule, gear, now);
+        gear_schedule_publish_health(&schedule, gear);
+    }
+
+    gear_pool_free(schedule.pool);
+    if (schedule.telemetry != nil) {
+        telemetry_writer_close(schedule.telemetry);
+    }
+    memory_arena_destroy(&schedule.arena);
+    __atomic_store_n(&gear->sampling, false, __ATOMIC_RELEASE);
+    return gear;
+}
+
+/// Stops the sample thread and waits until it and its workers exited, afterwards the devices may be destroyed
+static void gear_stop_sample(Gear *gear) {
+    __atomic_store_n(&gear->sample, false, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&gear->sampling, __ATOMIC_ACQUIRE)) {
+        thread_sleep(GEAR_STOP_POLL);
+    }
+}
+
+/// Applies the samples of a replayed block, paced by the replay speed
+static void gear_replay_block(Gear *gear, AlpacaDevice *device, TelemetryRecord const *record, f64 start, f64 origin) {
+    for (usize i = 0; i < record->count && gear->replay; ++i) {
+        // Wait until the replay clock reaches the sample
+        for (;;) {
+            f64 const speed = fmax(gear->replay_speed, 1.0);
+            f64 const elapsed = (timer_now() - start) / 1000.0 * speed;
+            f64 const wait = (record->timestamps[i] - origin - elapsed) / speed * 1000.0;
+            if (wait <= 0.0 || !gear->replay) {
+                break;
+            }
+            thread_sleep((u64) fmin(wait, GEAR_SCHEDULE_MAX_SLEEP) + 1);
+        }
+        alpaca_device_update_field(device, record->field, record->values[i], 0);
+        time_series_push(device->history + record->field, record->timestamps[i], record->values[i]);
+    }
+}
+
+/// Replays a telemetry log into the devices that were created from its schema records
+static void *gear_replay_task(void *args) {
+    Gear *gear = (Gear *) args;
+    TelemetryLog *log = &gear->replay_log;
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
 
-        // End the timer
-        timer_end(&timer);
+    // Log devices are mapped onto the device list in the order of their schema records,
+    // the mapping stores the list index plus one so that zero marks unknown devices
+    usize *mapping = (usize *) calloc(UINT16_MAX + 1, sizeof(usize));
+    usize schema_count = 0;
+    f64 const start = timer_now();
+    f64 origin = -1.0;
 
-        // Check whether a sleep is necessary to hit the sampling interval
-        f64 const sleep_time = 1000.0 * gear->sampling_interval - timer_elapsed(&timer);
-        if (sleep_time > 0.0) {
-            thread_sleep((u64) sleep_time);
+    TelemetryRecord record = { 0 };
+    while (gear->replay && telemetry_log_next(log, &arena, &record)) {
+        if (record.kind == TELEMETRY_RECORD_SCHEMA) {
+            mapping[record.device] = ++schema_count;
+        } else if (record.kind == TELEMETRY_RECORD_BLOCK) {
+            usize const index = mapping[record.device];
+            if (index > 0 && index <= gear->devices.count) {
+                origin = origin < 0.0 ? record.timestamps[0] : origin;
+                gear_replay_block(gear, gear->devices.devices + index - 1, &record, start, origin);
+            }
         }
+        memory_arena_clear(&arena);
     }
 
+    free(mapping);
+    memory_arena_destroy(&arena);
+    telemetry_log_close(log);
+    __atomic_store_n(&gear->replay, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&gear->replaying, false, __ATOMIC_RELEASE);
     return gear;
 }
 
+/// Stops the replay thread and waits until it exited, afterwards the devices may be destroyed
+static void gear_stop_replay(Gear *gear) {
+    __atomic_store_n(&gear->replay, false, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&gear->replaying, __ATOMIC_ACQUIRE)) {
+        thread_sleep(GEAR_STOP_POLL);
+    }
+}
+
+/// Destroys the devices, the sample and replay threads must be stopped already
+static void gear_clear_devices(Gear *gear) {
+    // The guider and the command queue refer to the devices until they are stopped
+    guider_stop(&gear->guider);
+    alpaca_telescope_queue_clear(gear->commands);
+    alpaca_device_list_clear(&gear->devices);
+}
+
+/// Starts the replay of a telemetry log, the devices of the log replace the current devices
+static void gear_replay(Gear *gear, const char *path) {
+    if (gear->replay) {
+        return;
+    }
+    gear_stop_replay(gear);
+    if (!telemetry_log_open(&gear->replay_log, path)) {
+        return;
+    }
+
+    // Create the devices from the schema records
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+    usize schema_count = 0;
+    TelemetryRecord record = { 0 };
+    while (telemetry_log_next(&gear->replay_log, &arena, &record)) {
+        schema_count += record.kind == TELEMETRY_RECORD_SCHEMA;
+        memory_arena_clear(&arena);
+    }
+
+    gear_clear_devices(gear);
+    alpaca_device_list_reserve(&gear->devices, schema_count);
+    telemetry_log_rewind(&gear->replay_log);
+    StringView address = string_view_from_native("replay");
+    while (telemetry_log_next(&gear->replay_log, &arena, &record)) {
+        if (record.kind == TELEMETRY_RECORD_SCHEMA) {
+            AlpacaDevice device = { 0 };
+            alpaca_device_make(&device, record.type, &address, &record.name, record.device);
+            alpaca_device_set_state(&device, ALPACA_DEVICE_STATE_READY);
+            alpaca_device_list_append(&gear->devices, &device);
+        }
+        memory_arena_clear(&arena);
+    }
+    memory_arena_destroy(&arena);
+
+    telemetry_log_rewind(&gear->replay_log);
+    gear->replay = true;
+    gear->replaying = true;
+    thread_create(gear_replay_task, gear);
+}
+
 /// Creates a new gear instance
-void gear_make(Gear *gear, f64 const sampling_interval) {
-    gear->client = nil;
+void gear_make(Gear *gear, f64 const sampling_interval, Settings *settings) {
+    gear->client_count = 0;
+    for (usize i = 0; i < GEAR_MAX_CLIENTS; ++i) {
+        alpaca_health_make(gear->health + i);
+    }
+    gear->health_lock = (SeqLock) { 0 };
+    gear->discovery = alpaca_discovery_start(nil);
+    gear->discovery_connected = false;
     gear->arena = memory_arena_identity(ALIGNMENT1);
     alpaca_device_list_make(&gear->devices);
     gear->sampling_interval = sampling_interval;
     gear->sample_arena = memory_arena_identity(ALIGNMENT1);
     gear->sample = false;
+    gear->sampling = false;
+    gear->replay = false;
+    gear->replaying = false;
+    gear->replay_speed = GEAR_REPLAY_SPEED;
     gear->show_properties = true;
+    gear->commands = alpaca_telescope_queue_new();
+    guider_make(&gear->guider);
+    gear->settings = settings;
+    gear->telemetry_path[0] = 0;
+}
+
+/// Destroys the clients of all servers
+static void gear_destroy_clients(Gear *gear) {
+    for (usize i = 0; i < gear->client_count; ++i) {
+        alpaca_client_destroy(gear->clients + i);
+    }
+    gear->client_count = 0;
 }
 
 /// Destroys the gear
 void gear_destroy(Gear *gear) {
+    gear_stop_sample(gear);
+    gear_stop_replay(gear);
+    guider_destroy(&gear->guider);
+    alpaca_telescope_queue_free(gear->commands);
     alpaca_device_list_destroy(&gear->devices);
-    if (gear->client) {
-        alpaca_client_destroy(gear->client);
+    gear_destroy_clients(gear);
+    if (gear->discovery != nil) {
+        alpaca_discovery_stop(gear->discovery);
     }
     memory_arena_destroy(&gear->sample_arena);
     memory_arena_destroy(&gear->arena);
@@ -131,15 +893,56 @@ void gear_start_sample(Gear *gear) {
         return;
     }
 
+    // A thread that is still shutting down is waited for, there is never more than one sample thread
+    gear_stop_sample(gear);
+
+    // Recorded sessions get their own telemetry log, the settings are only read here so that
+    // they can be edited while sampling
+    gear->telemetry_path[0] = 0;
+    if (gear->settings->telemetry) {
+        snprintf(gear->telemetry_path, sizeof gear->telemetry_path, "%s/kopernikus-%lld.ktlm",
+                 gear->settings->telemetry_directory, (long long) time(nil));
+    }
+
     gear->sample = true;
+    gear->sampling = true;
     thread_create(gear_sample_task, gear);
 }
 
+/// Adds the specified alpaca server, its devices are connected once the sample thread starts
+static void gear_add_server(Gear *gear, StringView *server) {
+    if (gear->client_count >= GEAR_MAX_CLIENTS) {
+        return;
+    }
+
+    // Devices of a previous replay are not part of the live session, they would be sampled as devices
+    // of the first server
+    if (gear->client_count == 0) {
+        gear_stop_replay(gear);
+        gear_clear_devices(gear);
+    }
+
+    usize const index = gear->client_count++;
+    AlpacaClient *client = gear->clients + index;
+    alpaca_client_make(client, server);
+
+    // The devices are shown right away, the sample thread connects them
+    gear->client_devices[index] = gear->devices.count;
+    alpaca_client_discover(client, &gear->devices);
+}
+
 /// Connects to the specified alpaca server
 static void gear_connect(Gear *gear, StringView *server) {
-    gear->client = (AlpacaClient *) memory_arena_alloc(&gear->arena, sizeof(AlpacaClient));
-    alpaca_client_make(gear->client, server);
-    alpaca_client_devices(gear->client, &gear->devices);
+    gear_add_server(gear, server);
+    gear_start_sample(gear);
+}
+
+/// Connects to all alpaca servers that answered the discovery
+static void gear_connect_discovered(Gear *gear, AlpacaServer const *servers, usize count) {
+    for (usize i = 0; i < count; ++i) {
+        StringView server = string_view_from_native(servers[i].url);
+        gear_add_server(gear, &server);
+    }
     gear_start_sample(gear);
 }
 
@@ -157,32 +960,247 @@ static void gear_render_connect(Gear *gear) {
     if (ui_button_light("Connect", true)) {
         StringView server = string_view_make(buffer.data, buffer.size);
         gear_connect(gear, &server);
+        return;
+    }
+
+    if (gear->discovery == nil) {
+        return;
+    }
+
+    AlpacaServer servers[ALPACA_DISCOVERY_CAPACITY];
+    usize count = alpaca_discovery_servers(gear->discovery, servers, ALPACA_DISCOVERY_CAPACITY);
+
+    // The servers found by the first discovery rounds are connected without asking
+    if (!gear->discovery_connected && count > 0 && alpaca_discovery_elapsed(gear->discovery) >= GEAR_DISCOVERY_GRACE) {
+        gear->discovery_connected = true;
+        gear_connect_discovered(gear, servers, count);
+        return;
+    }
+
+    if (count == 0) {
+        ui_note("Searching the local network for ASCOM Alpaca servers...");
+        return;
+    }
+
+    ui_note("Found %zu ASCOM Alpaca server(s) in the local network:", count);
+    for (usize i = 0; i < count; ++i) {
+        char label[32];
+        snprintf(label, sizeof label, "Connect##AlpacaServer%zu", i);
+        ui_text("%s", servers[i].url);
+        ui_keep_line();
+        if (ui_button_light(label, false)) {
+            StringView server = string_view_from_native(servers[i].url);
+            gear_connect(gear, &server);
+            return;
+        }
+    }
+    if (ui_button("Connect all", false)) {
+        gear_connect_discovered(gear, servers, count);
+    }
+    ui_keep_line();
+    if (ui_button("Search again", false)) {
+        alpaca_discovery_refresh(gear->discovery);
+    }
+}
+
+/// Render the telemetry replay prompt
+static void gear_render_replay(Gear *gear) {
+    if (gear->replay) {
+        ui_note("Replaying a telemetry log at %.0fx real time.", gear->replay_speed);
+        if (ui_button("Stop", false)) {
+            gear_stop_replay(gear);
+        }
+        return;
+    }
+
+    ui_note("Alternatively, replay the telemetry log of a previous session:");
+
+    static char replay_buffer[512];
+    StringBuffer buffer = { replay_buffer, sizeof replay_buffer };
+    ui_searchbar(&buffer, "##TelemetryReplayBar", ICON_FA_FILE " Enter log path...", false);
+
+    ui_keep_line();
+
+    if (ui_button_light("Replay", true)) {
+        gear_replay(gear, replay_buffer);
+    }
+    ui_property_real("Speed", &gear->replay_speed, "%.0fx");
+}
+
+/// Reads a consistent copy of the server health that is published by the sample thread
+static void gear_health(Gear const *gear, AlpacaHealth *health) {
+    u32 sequence = 0;
+    do {
+        sequence = seqlock_read_begin(&gear->health_lock);
+        memcpy(health, gear->health, sizeof gear->health);
+    } while (seqlock_read_retry(&gear->health_lock, sequence));
+}
+
+/// Render the health of every server
+static void gear_render_health(Gear *gear) {
+    AlpacaHealth health[GEAR_MAX_CLIENTS];
+    gear_health(gear, health);
+
+    f64 const now = timer_now();
+    for (usize i = 0; i < gear->client_count; ++i) {
+        AlpacaHealth const *server = health + i;
+        const char *state = alpaca_health_state_to_string(server->state);
+        if (server->state == ALPACA_HEALTH_OPEN) {
+            f64 const probe = fmax(server->retry - now, 0.0) / 1000.0;
+            ui_text("%s: %s, next probe in %.0f s", gear->clients[i].server, state, probe);
+        } else if (server->latency >= 0.0) {
+            ui_text("%s: %s, %.1f ms", gear->clients[i].server, state, server->latency);
+        } else {
+            ui_text("%s: %s", gear->clients[i].server, state);
+        }
+        ui_tooltip_hovered("%u consecutive failures\n%llu of %llu requests failed", server->failures,
+                           (unsigned long long) server->failed, (unsigned long long) server->requests);
     }
 }
 
 /// Render the device disconnect prompt
 static void gear_render_disconnect(Gear *gear) {
-    ui_note("Connected to ASCOM Alpaca server '%s'.", gear->client->server);
+    if (gear->client_count == 1) {
+        ui_note("Connected to ASCOM Alpaca server '%s'.", gear->clients[0].server);
+    } else {
+        ui_note("Connected to %zu ASCOM Alpaca servers.", gear->client_count);
+    }
+    gear_render_health(gear);
     if (ui_button("Disconnect", false)) {
-        gear->client = nil;
+        gear_stop_sample(gear);
+        gear_clear_devices(gear);
+        gear_destroy_clients(gear);
         memory_arena_clear(&gear->arena);
-        alpaca_device_list_clear(&gear->devices);
+    }
+}
+
+/// Render the description and the data age of a payload field as a tooltip
+static void gear_render_field_tooltip(AlpacaDeviceSnapshot const *state, usize field, const char *description) {
+    f64 age = alpaca_device_age(state, field);
+    if (age < 0.0) {
+        ui_tooltip_hovered("%s\nNot sampled yet", description);
+        return;
+    }
+    ui_tooltip_hovered("%s\nUpdated %.1f s ago (transaction %u)", description, age / 1000.0,
+                       state->stamps[field].server_tx_id);
+}
+
+/// Render the readiness of a device that is not ready yet
+static void gear_render_device_state(AlpacaDeviceSnapshot const *state) {
+    if (state->state == ALPACA_DEVICE_STATE_CONNECTING) {
+        ui_note("Connecting...");
+    } else if (state->state == ALPACA_DEVICE_STATE_FAILED) {
+        ui_note("The device could not be connected.");
+    }
+}
+
+/// Render the history of payload fields as a plot, the ring buffers are plotted in place
+static void gear_render_history(AlpacaDevice const *device,
+                                const char *id,
+                                usize const *fields,
+                                const char *const *labels,
+                                usize count,
+                                const char *format) {
+    ImVec2 size = { 0 };
+    igGetContentRegionAvail(&size);
+    size.y = GEAR_HISTORY_PLOT_HEIGHT;
+
+    char plot_title[64];
+    snprintf(plot_title, sizeof plot_title, "##idHistory%s%p", id, (void *) device);
+    ImPlotAxisFlags axis_flags = ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_NoLabel | ImPlotAxisFlags_NoTickLabels;
+    if (ImPlot_BeginPlot(plot_title, size, ImPlotFlags_NoFrame)) {
+        ImPlot_SetupAxes("Time", id, axis_flags, ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_Opposite);
+        ImPlot_SetupAxisFormat_Str(ImAxis_Y1, format);
+        for (usize i = 0; i < count; ++i) {
+            TimeSeriesView view = time_series_view(device->history + fields[i]);
+            ImPlot_PlotLine_doublePtrdoublePtr(labels[i], view.timestamps, view.values, (s32) view.count, 0,
+                                               (s32) view.offset, sizeof(f64));
+        }
+        ImPlot_EndPlot();
+    }
+}
+
+/// Render the telescope controls, commands are queued and their completion is observed through the payload
+static void gear_render_telescope_control(Gear *gear, AlpacaDevice *device, AlpacaDeviceSnapshot const *state) {
+    const char *status = "Idle";
+    if (state->payload.slewing > 0.5) {
+        status = "Slewing";
+    } else if (state->payload.at_park > 0.5) {
+        status = "Parked";
+    } else if (state->payload.tracking > 0.5) {
+        status = "Tracking";
+    }
+    ui_property_text_readonly("Status", status);
+    gear_render_field_tooltip(state, ALPACA_FIELD_SLEWING, "Whether the mount is slewing, tracking or parked");
+
+    static f64 target_right_ascension = 0.0;
+    static f64 target_declination = 0.0;
+    ui_property_real("Target RA", &target_right_ascension, "%.4f h");
+    ui_property_real("Target Dec", &target_declination, "%.4f °");
+
+    AlpacaTelescopeCommand command = { .device = device, .type = ALPACA_TELESCOPE_COMMAND_NONE };
+    if (ui_button_light("Slew", false)) {
+        command.type = ALPACA_TELESCOPE_COMMAND_SLEW_TO_COORDINATES;
+        command.coordinates.right_ascension = target_right_ascension;
+        command.coordinates.declination = target_declination;
+    }
+    ui_keep_line();
+    if (ui_button("Abort", false)) {
+        command.type = ALPACA_TELESCOPE_COMMAND_ABORT_SLEW;
+    }
+    ui_keep_line();
+    b8 tracking = state->payload.tracking > 0.5;
+    if (ui_button(tracking ? "Stop Tracking" : "Track", false)) {
+        command.type = ALPACA_TELESCOPE_COMMAND_TRACKING;
+        command.tracking = !tracking;
+    }
+    ui_keep_line();
+    b8 parked = state->payload.at_park > 0.5;
+    if (ui_button(parked ? "Unpark" : "Park", false)) {
+        command.type = parked ? ALPACA_TELESCOPE_COMMAND_UNPARK : ALPACA_TELESCOPE_COMMAND_PARK;
+    }
+    if (command.type != ALPACA_TELESCOPE_COMMAND_NONE) {
+        alpaca_telescope_queue_submit(gear->commands, &command);
+    }
+
+    AlpacaResult result = { 0 };
+    if (alpaca_telescope_queue_last(gear->commands, &result) != 0 && !result.ok) {
+        ui_note("The last command failed (error 0x%X).", result.err_number);
     }
 }
 
 /// Render the telescope device properties
-static void gear_render_telescope(AlpacaDevice const *device) {
+static void gear_render_telescope(Gear *gear, AlpacaDevice *device, AlpacaDeviceSnapshot const *state) {
     if (!igCollapsingHeader_BoolPtr("Telescopes " ICON_FA_STAR, nil, ImGuiTreeNodeFlags_DefaultOpen)) {
         return;
     }
 
     if (ui_tree_node_begin(device->name.base, nil, false)) {
+        gear_render_device_state(state);
         if (ui_tree_node_begin(ICON_FA_MAP_PIN " Position", nil, false)) {
             ui_note("Horizontal");
-            ui_property_real_readonly("Alt", device->payload.altitude, "%.4f °");
-            ui_tooltip_hovered("The mount's current altitude over the horizon");
-            ui_property_real_readonly("Az", device->payload.azimuth, "%.4f °");
-            ui_tooltip_hovered("The mount's current azimuth");
+            ui_property_real_readonly("Alt", state->payload.altitude, "%.4f °");
+            gear_render_field_tooltip(state, ALPACA_FIELD_ALTITUDE, "The mount's current altitude over the horizon");
+            ui_property_real_readonly("Az", state->payload.azimuth, "%.4f °");
+            gear_render_field_tooltip(state, ALPACA_FIELD_AZIMUTH, "The mount's current azimuth");
+            ui_note("Equatorial");
+            ui_property_real_readonly("RA", state->payload.right_ascension, "%.4f h");
+            gear_render_field_tooltip(state, ALPACA_FIELD_RIGHT_ASCENSION, "The mount's current right ascension");
+            ui_property_real_readonly("Dec", state->payload.declination, "%.4f °");
+            gear_render_field_tooltip(state, ALPACA_FIELD_DECLINATION, "The mount's current declination");
+            ui_property_real_readonly("LST", state->payload.sidereal_time, "%.4f h");
+            gear_render_field_tooltip(state, ALPACA_FIELD_SIDEREAL_TIME,
+                                      "The local apparent sidereal time of the mount");
+            ui_tree_node_end();
+        }
+        if (ui_tree_node_begin(ICON_FA_GAMEPAD " Control", nil, false)) {
+            gear_render_telescope_control(gear, device, state);
+            ui_tree_node_end();
+        }
+        if (ui_tree_node_begin(ICON_FA_CHART_LINE " History", nil, false)) {
+            static const usize fields[] = { ALPACA_FIELD_ALTITUDE, ALPACA_FIELD_AZIMUTH };
+            static const char *const labels[] = { "Alt", "Az" };
+            gear_render_history(device, "Position", fields, labels, ARRAY_SIZE(fields), "%g °");
             ui_tree_node_end();
         }
         ui_tree_node_end();
@@ -190,48 +1208,80 @@ static void gear_render_telescope(AlpacaDevice const *device) {
 }
 
 /// Render the observing conditions device properties
-static void gear_render_observing_conditions(AlpacaDevice const *device) {
+static void gear_render_observing_conditions(AlpacaDevice const *device, AlpacaDeviceSnapshot const *state) {
     if (!igCollapsingHeader_BoolPtr("Observatories " ICON_FA_CLOUD_SUN_RAIN, nil, ImGuiTreeNodeFlags_DefaultOpen)) {
         return;
     }
 
     if (ui_tree_node_begin(device->name.base, nil, false)) {
+        gear_render_device_state(state);
         if (ui_tree_node_begin(ICON_FA_SUN " Sky", nil, false)) {
-            ui_property_real_readonly("Cloud Cover", device->payload.cloud_cover, "%.4f%%");
-            ui_tooltip_hovered("The amount of by cloud obscured sky");
-            ui_property_real_readonly("Brightness", device->payload.sky_brightness, "%.4f Lux");
-            ui_tooltip_hovered("The sky brightness (Lux) at the observatory");
-            ui_property_real_readonly("Quality", device->payload.sky_quality, "%.4f Mag/arcsec^2");
-            ui_tooltip_hovered("The sky quality (Mag/arcsec^2) at the observatory");
-            ui_property_real_readonly("Temperature", device->payload.sky_temperature, "%.4f °C");
-            ui_tooltip_hovered("The sky temperature (°C) at the observatory");
+            ui_property_real_readonly("Cloud Cover", state->payload.cloud_cover, "%.4f%%");
+            gear_render_field_tooltip(state, ALPACA_FIELD_CLOUD_COVER, "The amount of by cloud obscured sky");
+            ui_property_real_readonly("Brightness", state->payload.sky_brightness, "%.4f Lux");
+            gear_render_field_tooltip(state, ALPACA_FIELD_SKY_BRIGHTNESS,
+                                      "The sky brightness (Lux) at the observatory");
+            ui_property_real_readonly("Quality", state->payload.sky_quality, "%.4f Mag/arcsec^2");
+            gear_render_field_tooltip(state, ALPACA_FIELD_SKY_QUALITY,
+                                      "The sky quality (Mag/arcsec^2) at the observatory");
+            ui_property_real_readonly("Temperature", state->payload.sky_temperature, "%.4f °C");
+            gear_render_field_tooltip(state, ALPACA_FIELD_SKY_TEMPERATURE,
+                                      "The sky temperature (°C) at the observatory");
             ui_tree_node_end();
         }
         if (ui_tree_node_begin(ICON_FA_CLOUD_RAIN " Weather", nil, false)) {
-            ui_property_real_readonly("Dew Point", device->payload.dew_point, "%.4f °C");
-            ui_tooltip_hovered("The atmospheric dew point temperature (°C) at the observatory");
-            ui_property_real_readonly("Humidity", device->payload.humidity, "%.4f%%");
-            ui_tooltip_hovered("The atmospheric relative humidity at the observatory");
-            ui_property_real_readonly("Pressure", device->payload.pressure, "%.4f hPa");
-            ui_tooltip_hovered("The atmospheric pressure (hPa) at the observatory");
-            ui_property_real_readonly("Rain Rate", device->payload.rain_rate, "%.4f mm/h");
-            ui_tooltip_hovered("The hourly rain rate (mm/h) at the observatory");
-            ui_property_real_readonly("Temperature", device->payload.temperature, "%.4f °C");
-            ui_tooltip_hovered("The temperature (°C) at the observatory");
+            ui_property_real_readonly("Dew Point", state->payload.dew_point, "%.4f °C");
+            gear_render_field_tooltip(state, ALPACA_FIELD_DEW_POINT,
+                                      "The atmospheric dew point temperature (°C) at the observatory");
+            ui_property_real_readonly("Humidity", state->payload.humidity, "%.4f%%");
+            gear_render_field_tooltip(state, ALPACA_FIELD_HUMIDITY,
+                                      "The atmospheric relative humidity at the observatory");
+            ui_property_real_readonly("Pressure", state->payload.pressure, "%.4f hPa");
+            gear_render_field_tooltip(state, ALPACA_FIELD_PRESSURE,
+                                      "The atmospheric pressure (hPa) at the observatory");
+            ui_property_real_readonly("Rain Rate", state->payload.rain_rate, "%.4f mm/h");
+            gear_render_field_tooltip(state, ALPACA_FIELD_RAIN_RATE, "The hourly rain rate (mm/h) at the observatory");
+            ui_property_real_readonly("Temperature", state->payload.temperature, "%.4f °C");
+            gear_render_field_tooltip(state, ALPACA_FIELD_TEMPERATURE, "The temperature (°C) at the observatory");
             ui_tree_node_end();
         }
         if (ui_tree_node_begin(ICON_FA_BINOCULARS " Seeing", nil, false)) {
-            ui_property_real_readonly("Star FWHM", device->payload.star_fwhm, "%.4f '");
-            ui_tooltip_hovered("The seeing at the observatory measured as star full width half maximum (')");
+            ui_property_real_readonly("Star FWHM", state->payload.star_fwhm, "%.4f '");
+            gear_render_field_tooltip(state, ALPACA_FIELD_STAR_FWHM,
+                                      "The seeing at the observatory measured as star full width half maximum (')");
             ui_tree_node_end();
         }
         if (ui_tree_node_begin(ICON_FA_WIND " Wind", nil, false)) {
-            ui_property_real_readonly("Direction", device->payload.wind_direction, "%.4f °");
-            ui_tooltip_hovered("The wind direction (°) at the observatory");
-            ui_property_real_readonly("Gust", device->payload.wind_gust, "%.4f m/s");
-            ui_tooltip_hovered("The peak three second wind gust (m/s) at the observatory over the last two minutes");
-            ui_property_real_readonly("Speed", device->payload.wind_speed, "%.4f m/s");
-            ui_tooltip_hovered("The wind speed (m/s) at the observatory");
+            ui_property_real_readonly("Direction", state->payload.wind_direction, "%.4f °");
+            gear_render_field_tooltip(state, ALPACA_FIELD_WIND_DIRECTION, "The wind direction (°) at the observatory");
+            ui_property_real_readonly("Gust", state->payload.wind_gust, "%.4f m/s");
+            gear_render_field_tooltip(state, ALPACA_FIELD_WIND_GUST,
+                                      "The peak three second wind gust (m/s) at the observatory "
+                                      "over the last two minutes");
+            ui_property_real_readonly("Speed", state->payload.wind_speed, "%.4f m/s");
+            gear_render_field_tooltip(state, ALPACA_FIELD_WIND_SPEED, "The wind speed (m/s) at the observatory");
+            ui_tree_node_end();
+        }
+        if (ui_tree_node_begin(ICON_FA_CHART_LINE " History", nil, false)) {
+            static const usize temperature_fields[] = { ALPACA_FIELD_TEMPERATURE, ALPACA_FIELD_DEW_POINT,
+                                                        ALPACA_FIELD_SKY_TEMPERATURE };
+            static const char *const temperature_labels[] = { "Temperature", "Dew Point", "Sky" };
+            gear_render_history(device, "Temperature", temperature_fields, temperature_labels,
+                                ARRAY_SIZE(temperature_fields), "%g °C");
+
+            static const usize wind_fields[] = { ALPACA_FIELD_WIND_SPEED, ALPACA_FIELD_WIND_GUST };
+            static const char *const wind_labels[] = { "Speed", "Gust" };
+            gear_render_history(device, "Wind", wind_fields, wind_labels, ARRAY_SIZE(wind_fields), "%g m/s");
+
+            static const usize humidity_fields[] = { ALPACA_FIELD_HUMIDITY, ALPACA_FIELD_CLOUD_COVER };
+            static const char *const humidity_labels[] = { "Humidity", "Cloud Cover" };
+            gear_render_history(device, "Humidity", humidity_fields, humidity_labels, ARRAY_SIZE(humidity_fields),
+                                "%g%%");
+
+            static const usize pressure_fields[] = { ALPACA_FIELD_PRESSURE };
+            static const char *const pressure_labels[] = { "Pressure" };
+            gear_render_history(device, "Pressure", pressure_fields, pressure_labels, ARRAY_SIZE(pressure_fields),
+                                "%g hPa");
             ui_tree_node_end();
         }
         ui_tree_node_end();
@@ -239,15 +1289,19 @@ static void gear_render_observing_conditions(AlpacaDevice const *device) {
 }
 
 /// Render the device
-static void gear_render_device(AlpacaDevice const *device) {
+static void gear_render_device(Gear *gear, AlpacaDevice *device) {
+    // The sampling thread publishes the state, the snapshot never tears
+    AlpacaDeviceSnapshot state = { 0 };
+    alpaca_device_snapshot(device, &state);
+
     switch (device->type) {
         case ALPACA_DEVICE_TYPE_NONE:
             break;
         case ALPACA_DEVICE_TYPE_OBSERVING_CONDITIONS:
-            gear_render_observing_conditions(device);
+            gear_render_observing_conditions(device, &state);
             break;
         case ALPACA_DEVICE_TYPE_TELESCOPE:
-            gear_render_telescope(device);
+            gear_render_telescope(gear, device, &state);
             break;
         default:
             break;
@@ -261,15 +1315,18 @@ static void gear_render_devices(Gear *gear) {
     }
 
     // Connect
-    if (gear->client == nil) {
-        gear_render_connect(gear);
+    if (gear->client_count == 0) {
+        if (!gear->replay) {
+            gear_render_connect(gear);
+        }
+        gear_render_replay(gear);
     } else {
         gear_render_disconnect(gear);
     }
 
     // Devices
     for (usize i = 0; i < gear->devices.count; ++i) {
-        gear_render_device(gear->devices.devices + i);
+        gear_render_device(gear, gear->devices.devices + i);
     }
 
     ui_window_end();
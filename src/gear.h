@@ -25,13 +25,42 @@
 #define KOPERNIKUS_GEAR_H
 
 #include <libascom/client.h>
+#include <libascom/discovery.h>
+#include <libascom/health.h>
 #include <libascom/observing_conditions.h>
 #include <libascom/telescope.h>
 
+#include "guider.h"
+#include "settings.h"
+#include "telemetry.h"
+
+enum {
+    /// The maximum number of alpaca servers the gear connects to
+    GEAR_MAX_CLIENTS = 8,
+};
+
 /// Gear collects data from the alpaca devices
 typedef struct Gear {
-    /// The alpaca client
-    AlpacaClient *client;
+    /// The alpaca clients, one per server
+    AlpacaClient clients[GEAR_MAX_CLIENTS];
+
+    /// The number of connected clients
+    usize client_count;
+
+    /// The index of the first device of every client, the devices of a client are enumerated consecutively
+    usize client_devices[GEAR_MAX_CLIENTS];
+
+    /// The health of every server as published by the sample thread
+    AlpacaHealth health[GEAR_MAX_CLIENTS];
+
+    /// Guards the published health
+    SeqLock health_lock;
+
+    /// Finds alpaca servers in the local network, nil if the socket could not be created
+    AlpacaDiscovery *discovery;
+
+    /// Whether the discovered servers were already connected once, a disconnect is not undone
+    b8 discovery_connected;
 
     /// The memory arena
     MemoryArena arena;
@@ -39,23 +68,52 @@ typedef struct Gear {
     /// The devices
     AlpacaDeviceList devices;
 
-    /// The sampling interval
+    /// The base sampling interval in seconds, the rates of the
+    /// individual attributes are multiples of it
     f64 sampling_interval;
 
-    /// Arena for requests, this gets cleared on every sample
+    /// Arena of the sample scheduler, this gets cleared on every dispatch
     MemoryArena sample_arena;
 
+    /// Sends telescope commands without blocking the UI or the sample thread
+    AlpacaTelescopeQueue *commands;
+
+    /// Closed-loop tracking corrections for one of the telescopes
+    Guider guider;
+
     /// Controls whether active sampling should continue
     b8 sample;
 
+    /// Set while the sample thread runs, it is cleared once the thread and its workers no longer touch the devices
+    b8 sampling;
+
+    /// Controls whether a telemetry replay should continue
+    b8 replay;
+
+    /// Set while the replay thread runs, it is cleared once the thread no longer touches the devices
+    b8 replaying;
+
+    /// Speed-up of the replay relative to real time
+    f64 replay_speed;
+
+    /// The log that is being replayed
+    TelemetryLog replay_log;
+
     /// Controls whether the device properties are shown
     b8 show_properties;
+
+    /// The kopernikus settings
+    Settings *settings;
+
+    /// The telemetry log of the current session, empty if the session is not recorded
+    char telemetry_path[320];
 } Gear;
 
 /// Creates a new gear instance
 /// @param gear The gear handle
 /// @param sampling_interval The sampling interval in seconds
-void gear_make(Gear *gear, f64 sampling_interval);
+/// @param settings The settings
+void gear_make(Gear *gear, f64 sampling_interval, Settings *settings);
 
 /// Destroys the gear
 /// @param gear The gear handle
@@ -0,0 +1,417 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <libcore/timer.h>
+#include <solaris/planet.h>
+
+#include "guider.h"
+#include "ui.h"
+
+enum {
+    /// Default period (ms) of the correction loop
+    GUIDER_DEFAULT_PERIOD = 100,
+
+    /// Interval (ms) in which guider_stop checks whether the thread finished
+    GUIDER_STOP_POLL = 5,
+};
+
+/// Default deadband (°), about two arcseconds
+#define GUIDER_DEFAULT_DEADBAND 0.0005
+
+/// Default error (°) above which the axes are moved instead of pulse guided
+#define GUIDER_DEFAULT_MOVE_THRESHOLD 0.25
+
+/// Default guide rate (°/s), half the sidereal rate
+#define GUIDER_DEFAULT_GUIDE_RATE 0.002089
+
+/// Proportional gain (1/s) that converts large errors into axis rates
+#define GUIDER_MOVE_GAIN 0.5
+
+/// The highest axis rate (°/s) the guider commands
+#define GUIDER_MAX_RATE 2.0
+
+/// Converts degrees into radians
+#define GUIDER_RADIANS (3.14159265358979323846 / 180.0)
+
+/// Step (°) by which the target is offset in order to measure the orientation of the equatorial frame
+#define GUIDER_FRAME_STEP 0.01
+
+/// The predicted position of the target and the local orientation of the equatorial frame
+typedef struct GuiderPrediction {
+    Horizontal position;
+
+    /// Converts on-sky offsets (°) along azimuth and altitude into on-sky offsets along right ascension
+    /// and declination, this is the rotation through the parallactic angle
+    f64 to_equatorial[2][2];
+} GuiderPrediction;
+
+/// Predicts the current horizontal position of the target
+static GuiderPrediction guider_predict(ObjectEntry const *target, Geographic const *observer) {
+    Time now = time_now();
+    Equatorial position = target->classification == CLASSIFICATION_PLANET
+                                  ? planet_position_equatorial(target->planet, &now)
+                                  : object_position(target->object, &now);
+    GuiderPrediction prediction = { 0 };
+    prediction.position = observe_geographic(&position, observer, &now);
+
+    // Offset the target east and towards the equator, the horizontal offsets span the frame in either hemisphere
+    f64 const equator = position.declination > 0.0 ? -1.0 : 1.0;
+    f64 const cos_declination = fmax(cos(position.declination * GUIDER_RADIANS), 1e-6);
+    Equatorial const east = { position.right_ascension + GUIDER_FRAME_STEP / cos_declination, position.declination };
+    Equatorial const north = { position.right_ascension, position.declination + equator * GUIDER_FRAME_STEP };
+    Horizontal const steps[] = {
+        observe_geographic(&east, observer, &now),
+        observe_geographic(&north, observer, &now),
+    };
+
+    // Columns of the horizontal offsets per unit offset east and north
+    f64 const cos_altitude = cos(prediction.position.altitude * GUIDER_RADIANS);
+    f64 to_horizontal[2][2] = { 0 };
+    for (usize i = 0; i < 2; ++i) {
+        f64 const scale = (i == 0 ? 1.0 : equator) * GUIDER_FRAME_STEP;
+        f64 const azimuth = fmod(steps[i].azimuth - prediction.position.azimuth + 540.0, 360.0) - 180.0;
+        to_horizontal[0][i] = azimuth * cos_altitude / scale;
+        to_horizontal[1][i] = (steps[i].altitude - prediction.position.altitude) / scale;
+    }
+
+    f64 const determinant = to_horizontal[0][0] * to_horizontal[1][1] - to_horizontal[0][1] * to_horizontal[1][0];
+    if (fabs(determinant) > 1e-9) {
+        prediction.to_equatorial[0][0] = to_horizontal[1][1] / determinant;
+        prediction.to_equatorial[0][1] = -to_horizontal[0][1] / determinant;
+        prediction.to_equatorial[1][0] = -to_horizontal[1][0] / determinant;
+        prediction.to_equatorial[1][1] = to_horizontal[0][0] / determinant;
+    }
+    return prediction;
+}
+
+/// Correction state of a single axis
+typedef struct GuiderAxis {
+    AlpacaTelescopeAxis axis;
+
+    /// The guide directions that reduce positive and negative errors
+    AlpacaGuideDirection positive;
+    AlpacaGuideDirection negative;
+
+    /// Whether large errors may be closed by moving the axis
+    b8 movable;
+
+    /// Whether the axis is currently moved by the guider
+    b8 moving;
+} GuiderAxis;
+
+/// Corrects the error (°) of an axis, returns whether a command was sent
+static b8 guider_correct_axis(Guider const *guider,
+                              GuiderAxis *axis,
+                              MemoryArena *arena,
+                              f64 error,
+                              f64 period,
+                              b8 *ok) {
+    AlpacaDevice *device = guider->device;
+    f64 const magnitude = fabs(error);
+
+    // Large errors are closed by moving the axis, the rate shrinks with the error
+    if (axis->movable && magnitude >= guider->move_threshold) {
+        f64 rate = fmin(magnitude * GUIDER_MOVE_GAIN, GUIDER_MAX_RATE);
+        *ok = alpaca_telescope_move_axis(device, arena, axis->axis, copysign(rate, error)).ok && *ok;
+        axis->moving = true;
+        return true;
+    }
+
+    b8 sent = false;
+    if (axis->moving) {
+        *ok = alpaca_telescope_move_axis(device, arena, axis->axis, 0.0).ok && *ok;
+        axis->moving = false;
+        sent = true;
+    }
+
+    // Pulses never outlast the cycle, the remaining error is corrected by the next one
+    if (magnitude > guider->deadband) {
+        u32 duration = (u32) fmin(magnitude / guider->guide_rate * 1000.0, period);
+        AlpacaGuideDirection direction = error > 0.0 ? axis->positive : axis->negative;
+        *ok = alpaca_telescope_pulse_guide(device, arena, direction, duration).ok && *ok;
+        sent = true;
+    }
+    return sent;
+}
+
+/// Runs the correction loop on the monotonic clock, every cycle reads the mount, computes
+/// the error and sends corrections
+static void *guider_task(void *args) {
+    Guider *guider = (Guider *) args;
+
+    b8 priority = thread_raise_priority();
+    mutex_lock(guider->mutex);
+    guider->priority = priority;
+    mutex_unlock(guider->mutex);
+
+    HttpMulti multi = { 0 };
+    http_multi_make(&multi);
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+
+    // Mounts of unknown geometry are guided like altitude-azimuth mounts
+    AlpacaAlignmentMode alignment = ALPACA_ALIGNMENT_ALT_AZ;
+    if (!alpaca_telescope_alignment_mode(guider->device, &arena, &alignment).ok) {
+        alignment = ALPACA_ALIGNMENT_ALT_AZ;
+    }
+    memory_arena_clear(&arena);
+    b8 const alt_az = alignment == ALPACA_ALIGNMENT_ALT_AZ;
+    mutex_lock(guider->mutex);
+    guider->alignment = alignment;
+    mutex_unlock(guider->mutex);
+
+    // The axes of equatorial mounts are only pulse guided, as their directions depend on the pier side
+    GuiderAxis north_axis = { ALPACA_TELESCOPE_AXIS_SECONDARY, ALPACA_GUIDE_NORTH, ALPACA_GUIDE_SOUTH, alt_az, false };
+    GuiderAxis east_axis = { ALPACA_TELESCOPE_AXIS_PRIMARY, ALPACA_GUIDE_EAST, ALPACA_GUIDE_WEST, alt_az, false };
+    static const char *const attributes[] = { "altitude", "azimuth" };
+
+    f64 deadline = timer_now();
+    for (;;) {
+        mutex_lock(guider->mutex);
+        b8 running = guider->running;
+        f64 period = guider->period;
+        mutex_unlock(guider->mutex);
+        if (!running) {
+            break;
+        }
+        deadline += period;
+
+        // Read the reported position directly, the payload belongs to the sample thread
+        f64 const begin = timer_now();
+        f64 reported_altitude = 0.0;
+        f64 reported_azimuth = 0.0;
+        f64 *const values[] = { &reported_altitude, &reported_azimuth };
+        AlpacaResult read = alpaca_device_get_many_f64(guider->device, &multi, &arena, attributes, values, nil, 2);
+        f64 const read_end = timer_now();
+
+        // Compute the error, the azimuth error takes the shorter way around
+        GuiderPrediction prediction = guider_predict(&guider->target, &guider->observer);
+        Horizontal const *predicted = &prediction.position;
+        f64 error_altitude = predicted->altitude - reported_altitude;
+        f64 error_azimuth = fmod(predicted->azimuth - reported_azimuth + 540.0, 360.0) - 180.0;
+
+        // The guide directions of equatorial mounts are north and east on the sky, so the on-sky error
+        // is rotated into the equatorial frame
+        f64 guide_north = error_altitude;
+        f64 guide_east = error_azimuth;
+        if (!alt_az) {
+            f64 const sky_azimuth = error_azimuth * cos(predicted->altitude * GUIDER_RADIANS);
+            f64 (*rotation)[2] = prediction.to_equatorial;
+            guide_east = rotation[0][0] * sky_azimuth + rotation[0][1] * error_altitude;
+            guide_north = rotation[1][0] * sky_azimuth + rotation[1][1] * error_altitude;
+        }
+        f64 const compute_end = timer_now();
+
+        // Command the corrections
+        b8 ok = read.ok;
+        u64 corrections = 0;
+        if (read.ok) {
+            corrections += guider_correct_axis(guider, &north_axis, &arena, guide_north, period, &ok);
+            corrections += guider_correct_axis(guider, &east_axis, &arena, guide_east, period, &ok);
+        }
+        f64 const command_end = timer_now();
+        memory_arena_clear(&arena);
+
+        mutex_lock(guider->mutex);
+        GuiderStatistics *statistics = &guider->statistics;
+        statistics->cycles++;
+        statistics->corrections += corrections;
+        statistics->failures += ok ? 0 : 1;
+        statistics->read_latency = read_end - begin;
+        statistics->compute_latency = compute_end - read_end;
+        statistics->command_latency = command_end - compute_end;
+        statistics->cycle_latency = command_end - begin;
+        statistics->max_latency = fmax(statistics->max_latency, statistics->cycle_latency);
+        statistics->error_altitude = error_altitude;
+        statistics->error_azimuth = error_azimuth;
+        if (command_end > deadline) {
+            statistics->deadline_misses++;
+        }
+        mutex_unlock(guider->mutex);
+
+        // Missed cycles are skipped instead of being caught up in a burst
+        if (command_end > deadline) {
+            deadline = command_end;
+            continue;
+        }
+        thread_sleep((u64) (deadline - command_end));
+    }
+
+    // Never leave an axis moving
+    if (north_axis.moving) {
+        alpaca_telescope_move_axis(guider->device, &arena, north_axis.axis, 0.0);
+    }
+    if (east_axis.moving) {
+        alpaca_telescope_move_axis(guider->device, &arena, east_axis.axis, 0.0);
+    }
+
+    memory_arena_destroy(&arena);
+    http_multi_destroy(&multi);
+
+    mutex_lock(guider->mutex);
+    guider->stopped = true;
+    mutex_unlock(guider->mutex);
+    return nil;
+}
+
+/// Creates a new guider
+void guider_make(Guider *guider) {
+    *guider = (Guider) { 0 };
+    guider->mutex = mutex_new();
+    guider->period = GUIDER_DEFAULT_PERIOD;
+    guider->deadband = GUIDER_DEFAULT_DEADBAND;
+    guider->move_threshold = GUIDER_DEFAULT_MOVE_THRESHOLD;
+    guider->guide_rate = GUIDER_DEFAULT_GUIDE_RATE;
+    guider->stopped = true;
+}
+
+/// Stops and destroys the guider
+void guider_destroy(Guider *guider) {
+    guider_stop(guider);
+    mutex_free(guider->mutex);
+}
+
+/// Starts guiding a telescope towards an object, a running guider is stopped first
+void guider_start(Guider *guider, AlpacaDevice *device, ObjectEntry const *target, Geographic const *observer) {
+    guider_stop(guider);
+
+    mutex_lock(guider->mutex);
+    guider->device = device;
+    guider->target = *target;
+    guider->observer = *observer;
+    guider->statistics = (GuiderStatistics) { 0 };
+    guider->running = true;
+    guider->stopped = false;
+    mutex_unlock(guider->mutex);
+    thread_create(guider_task, guider);
+}
+
+/// Stops guiding, waits for the cycle that is currently running
+void guider_stop(Guider *guider) {
+    mutex_lock(guider->mutex);
+    guider->running = false;
+    mutex_unlock(guider->mutex);
+
+    for (;;) {
+        mutex_lock(guider->mutex);
+        b8 stopped = guider->stopped;
+        mutex_unlock(guider->mutex);
+        if (stopped) {
+            break;
+        }
+        thread_sleep(GUIDER_STOP_POLL);
+    }
+    guider->device = nil;
+}
+
+/// Checks whether the guider is running
+b8 guider_running(Guider *guider) {
+    mutex_lock(guider->mutex);
+    b8 running = guider->running;
+    mutex_unlock(guider->mutex);
+    return running;
+}
+
+/// Retrieves a copy of the loop instrumentation
+void guider_statistics(Guider *guider, GuiderStatistics *statistics) {
+    mutex_lock(guider->mutex);
+    *statistics = guider->statistics;
+    mutex_unlock(guider->mutex);
+}
+
+/// Finds the first telescope of the device list
+static AlpacaDevice *guider_find_telescope(AlpacaDeviceList *devices) {
+    for (usize i = 0; i < devices->count; ++i) {
+        if (devices->devices[i].type == ALPACA_DEVICE_TYPE_TELESCOPE) {
+            return devices->devices + i;
+        }
+    }
+    return nil;
+}
+
+/// Renders the loop instrumentation
+static void guider_render_statistics(Guider *guider) {
+    GuiderStatistics statistics = { 0 };
+    guider_statistics(guider, &statistics);
+
+    ui_note("Mount");
+    ui_property_text_readonly("Alignment", guider->alignment == ALPACA_ALIGNMENT_ALT_AZ ? "Alt-Az" : "Equatorial");
+    ui_tooltip_hovered("Equatorial mounts are pulse guided along right ascension and declination");
+
+    ui_note("Tracking Error");
+    ui_property_real_readonly("Alt", statistics.error_altitude * 3600.0, "%.1f \"");
+    ui_property_real_readonly("Az", statistics.error_azimuth * 3600.0, "%.1f \"");
+
+    ui_note("Latency");
+    ui_property_real_readonly("Read", statistics.read_latency, "%.2f ms");
+    ui_property_real_readonly("Compute", statistics.compute_latency, "%.2f ms");
+    ui_property_real_readonly("Command", statistics.command_latency, "%.2f ms");
+    ui_property_real_readonly("Cycle", statistics.cycle_latency, "%.2f ms");
+    ui_tooltip_hovered("Time from reading the mount until the corrections were sent");
+    ui_property_real_readonly("Max", statistics.max_latency, "%.2f ms");
+
+    ui_note("Loop");
+    ui_property_number_readonly("Cycles", (s64) statistics.cycles, "%lld");
+    ui_property_number_readonly("Deadline Misses", (s64) statistics.deadline_misses, "%lld");
+    ui_tooltip_hovered("Cycles that did not finish within the period");
+    ui_property_number_readonly("Corrections", (s64) statistics.corrections, "%lld");
+    ui_property_number_readonly("Failures", (s64) statistics.failures, "%lld");
+}
+
+/// Renders the guider window
+void guider_render(Guider *guider, AlpacaDeviceList *devices, ObjectBrowser *browser) {
+    if (!ui_window_begin("Guider", &guider->show_guider)) {
+        return;
+    }
+
+    if (guider_running(guider)) {
+        ui_note("Guiding at a period of %.0f ms%s.", guider->period, guider->priority ? " with raised priority" : "");
+        if (ui_button("Stop", false)) {
+            guider_stop(guider);
+        }
+        guider_render_statistics(guider);
+        ui_window_end();
+        return;
+    }
+
+    AlpacaDevice *telescope = guider_find_telescope(devices);
+    ObjectEntry const *target = &browser->selected;
+    b8 has_target = target->classification == CLASSIFICATION_PLANET ? target->planet != nil : target->object != nil;
+    if (telescope == nil) {
+        ui_note("Connect to a telescope in order to guide it.");
+    } else if (!has_target) {
+        ui_note("Select the object that should be tracked in the object browser.");
+    } else {
+        ui_property_real("Period", &guider->period, "%.0f ms");
+        guider->period = fmax(guider->period, 10.0);
+        if (ui_button_light("Guide", false)) {
+            Geographic observer = { 0 };
+            observer.latitude = browser->settings->location.latitude;
+            observer.longitude = browser->settings->location.longitude;
+            guider_start(guider, telescope, target, &observer);
+        }
+    }
+    ui_window_end();
+}
@@ -0,0 +1,143 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef KOPERNIKUS_GUIDER_H
+#define KOPERNIKUS_GUIDER_H
+
+#include <libascom/telescope.h>
+#include <libcore/arch/thread.h>
+#include <solaris/object.h>
+
+#include "browser.h"
+
+/// Instrumentation of the correction loop
+typedef struct GuiderStatistics {
+    /// Completed correction cycles
+    u64 cycles;
+
+    /// Cycles that did not finish within their period
+    u64 deadline_misses;
+
+    /// Commands that were sent to the mount
+    u64 corrections;
+
+    /// Cycles in which the mount could not be read or commanded
+    u64 failures;
+
+    /// Latencies (ms) of the stages of the last cycle
+    f64 read_latency;
+    f64 compute_latency;
+    f64 command_latency;
+
+    /// Latency (ms) from reading the mount to the sent command of the last cycle
+    f64 cycle_latency;
+
+    /// The highest cycle latency (ms) since the guider was started
+    f64 max_latency;
+
+    /// Tracking error (°) of the last cycle, predicted minus reported position
+    f64 error_altitude;
+    f64 error_azimuth;
+} GuiderStatistics;
+
+/// Closed-loop tracking corrections, compares the predicted horizontal position of the
+/// target against the position that the mount reports and guides the mount towards it
+/// @note Altitude-azimuth mounts are guided along their axes and moved for large errors, equatorial
+///       mounts are only pulse guided with the error rotated through the parallactic angle
+typedef struct Guider {
+    /// Guards the state that is shared with the guider thread
+    Mutex *mutex;
+
+    /// The telescope that is guided
+    AlpacaDevice *device;
+
+    /// The tracked object
+    ObjectEntry target;
+
+    /// The location of the observer
+    Geographic observer;
+
+    /// The period (ms) of the correction loop
+    f64 period;
+
+    /// Errors (°) below the deadband are not corrected
+    f64 deadband;
+
+    /// Errors (°) above the threshold are corrected by moving the axes, smaller ones by pulse guiding
+    f64 move_threshold;
+
+    /// The guide rate (°/s) of the mount, which converts errors into pulse durations
+    f64 guide_rate;
+
+    /// The geometry of the mount, which the guider thread reads when it starts
+    AlpacaAlignmentMode alignment;
+
+    GuiderStatistics statistics;
+
+    /// Cleared to stop the guider thread, which sets stopped once it no longer touches the device
+    b8 running;
+    b8 stopped;
+
+    /// Whether the guider thread runs with a raised priority
+    b8 priority;
+
+    /// Controls whether the guider window is shown
+    b8 show_guider;
+} Guider;
+
+/// Creates a new guider
+/// @param guider The guider handle
+void guider_make(Guider *guider);
+
+/// Stops and destroys the guider
+/// @param guider The guider handle
+void guider_destroy(Guider *guider);
+
+/// Starts guiding a telescope towards an object, a running guider is stopped first
+/// @param guider The guider handle
+/// @param device The telescope, must stay valid until the guider is stopped
+/// @param target The object to track
+/// @param observer The location of the observer
+void guider_start(Guider *guider, AlpacaDevice *device, ObjectEntry const *target, Geographic const *observer);
+
+/// Stops guiding, waits for the cycle that is currently running
+/// @param guider The guider handle
+void guider_stop(Guider *guider);
+
+/// Checks whether the guider is running
+/// @param guider The guider handle
+/// @return Whether the guider is running
+b8 guider_running(Guider *guider);
+
+/// Retrieves a copy of the loop instrumentation
+/// @param guider The guider handle
+/// @param statistics The statistics that will be set
+void guider_statistics(Guider *guider, GuiderStatistics *statistics);
+
+/// Renders the guider window
+/// @param guider The guider handle
+/// @param devices The devices that can be guided
+/// @param browser The object browser that provides the target
+void guider_render(Guider *guider, AlpacaDeviceList *devices, ObjectBrowser *browser);
+
+#endif// KOPERNIKUS_GUIDER_H
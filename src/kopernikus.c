@@ -21,11 +21,13 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <cimgui.h>
 #include <libascom/device.h>
 #include <libascom/http/client.h>
 #include <libascom/observing_conditions.h>
 #include <libascom/utils/cJSON.h>
 #include <libcore/display.h>
+#include <libcore/jobs.h>
 #include <libcore/log.h>
 
 #include "browser.h"
@@ -44,14 +46,17 @@ int main(void) {
     Settings settings = { 0 };
     settings_make(&settings);
 
+    // Shared by everything that computes positions in the background
+    JobPool *jobs = job_pool_new(0);
+
     ObjectBrowser browser = { 0 };
-    object_browser_make(&browser, &settings);
+    object_browser_make(&browser, &settings, jobs);
 
     Sequencer sequencer = { 0 };
-    sequencer_make(&sequencer, &browser);
+    sequencer_make(&sequencer, &browser, jobs);
 
     Gear gear = { 0 };
-    gear_make(&gear, 1.0f);
+    gear_make(&gear, 1.0f, &settings);
 
     while (display_running(&display)) {
         ui_begin();
@@ -76,6 +81,9 @@ int main(void) {
                 if (ui_selectable("Properties\t", ICON_FA_BOOK)) {
                     gear.show_properties = true;
                 }
+                if (ui_selectable("Guider", ICON_FA_CROSSHAIRS)) {
+                    gear.guider.show_guider = true;
+                }
                 ui_separator();
                 ui_note("Editor");
                 if (ui_selectable("Sequencer", ICON_FA_PEN_TO_SQUARE)) {
@@ -91,7 +99,13 @@ int main(void) {
                 ui_menu_end();
             }
             if (ui_menu_begin(ICON_FA_GEARS " Settings")) {
-                ui_text("No configurable settings.");
+                ui_note("Telemetry");
+                bool telemetry = settings.telemetry;
+                igCheckbox("Record gear sessions", &telemetry);
+                settings.telemetry = telemetry;
+                igInputText("Directory", settings.telemetry_directory, sizeof settings.telemetry_directory,
+                            ImGuiInputTextFlags_None, nil, nil);
+                ui_tooltip_hovered("The directory the telemetry logs of recorded sessions are written to");
                 ui_menu_end();
             }
             if (ui_menu_begin(ICON_FA_CIRCLE_QUESTION " About")) {
@@ -104,6 +118,7 @@ int main(void) {
         object_browser_render(&browser);
         sequencer_render(&sequencer);
         gear_render(&gear);
+        guider_render(&gear.guider, &gear.devices, &browser);
 
         ui_end();
         display_update_frame(&display);
@@ -111,6 +126,7 @@ int main(void) {
 
     gear_destroy(&gear);
     sequencer_destroy(&sequencer);
+    job_pool_free(jobs);
     object_browser_destroy(&browser);
     settings_destroy(&settings);
 
@@ -21,26 +21,265 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
-#include "utils/cJSON_Helper.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "alpaca.h"
+#include "utils/cJSON_Helper.h"
+
+/// Scanner over the raw bytes of an alpaca response
+typedef struct AlpacaScanner {
+    const char *at;
+    const char *end;
+} AlpacaScanner;
+
+/// Skips whitespace
+static void alpaca_scanner_whitespace(AlpacaScanner *scanner) {
+    while (scanner->at < scanner->end && isspace((unsigned char) *scanner->at)) {
+        scanner->at++;
+    }
+}
+
+/// Consumes the expected symbol
+static b8 alpaca_scanner_expect(AlpacaScanner *scanner, char symbol) {
+    alpaca_scanner_whitespace(scanner);
+    if (scanner->at >= scanner->end || *scanner->at != symbol) {
+        return false;
+    }
+    scanner->at++;
+    return true;
+}
+
+/// Scans a string, the view references the still escaped contents
+static b8 alpaca_scanner_string(AlpacaScanner *scanner, StringView *view) {
+    if (!alpaca_scanner_expect(scanner, '"')) {
+        return false;
+    }
+
+    const char *begin = scanner->at;
+    while (scanner->at < scanner->end) {
+        char symbol = *scanner->at;
+        if (symbol == '\\') {
+            scanner->at += 2;
+            continue;
+        }
+        if (symbol == '"') {
+            *view = string_view_make(begin, scanner->at - begin);
+            scanner->at++;
+            return true;
+        }
+        scanner->at++;
+    }
+    return false;
+}
+
+/// Scans a number
+static b8 alpaca_scanner_number(AlpacaScanner *scanner, f64 *number) {
+    alpaca_scanner_whitespace(scanner);
+
+    // strtod requires a zero terminated token, which the body is not guaranteed to be
+    char token[64] = { 0 };
+    usize length = 0;
+    while (scanner->at < scanner->end && length < sizeof token - 1) {
+        char symbol = *scanner->at;
+        if (!(isdigit((unsigned char) symbol) || symbol == '-' || symbol == '+' || symbol == '.' || symbol == 'e' ||
+              symbol == 'E')) {
+            break;
+        }
+        token[length++] = symbol;
+        scanner->at++;
+    }
+
+    char *token_end = nil;
+    *number = strtod(token, &token_end);
+    return length > 0 && token_end == token + length;
+}
+
+/// Consumes the expected literal
+static b8 alpaca_scanner_literal(AlpacaScanner *scanner, const char *literal) {
+    usize length = strlen(literal);
+    if ((usize) (scanner->end - scanner->at) < length || memcmp(scanner->at, literal, length) != 0) {
+        return false;
+    }
+    scanner->at += length;
+    return true;
+}
+
+/// Skips an arbitrary value
+static b8 alpaca_scanner_skip(AlpacaScanner *scanner) {
+    alpaca_scanner_whitespace(scanner);
+    if (scanner->at >= scanner->end) {
+        return false;
+    }
+
+    StringView ignored = { 0 };
+    char symbol = *scanner->at;
+    if (symbol == '"') {
+        return alpaca_scanner_string(scanner, &ignored);
+    }
+
+    if (symbol == '{' || symbol == '[') {
+        s32 depth = 0;
+        while (scanner->at < scanner->end) {
+            symbol = *scanner->at;
+            if (symbol == '"') {
+                if (!alpaca_scanner_string(scanner, &ignored)) {
+                    return false;
+                }
+                continue;
+            }
+            if (symbol == '{' || symbol == '[') {
+                depth++;
+            } else if (symbol == '}' || symbol == ']') {
+                depth--;
+                if (depth == 0) {
+                    scanner->at++;
+                    return true;
+                }
+            }
+            scanner->at++;
+        }
+        return false;
+    }
+
+    // Numbers and literals run until the next delimiter
+    const char *begin = scanner->at;
+    while (scanner->at < scanner->end && strchr(",}] \t\r\n", *scanner->at) == nil) {
+        scanner->at++;
+    }
+    return scanner->at > begin;
+}
+
+/// Scans the value member of the envelope
+static b8 alpaca_scanner_value(AlpacaScanner *scanner, AlpacaResponse *response) {
+    alpaca_scanner_whitespace(scanner);
+    if (scanner->at >= scanner->end) {
+        return false;
+    }
+
+    const char *begin = scanner->at;
+    b8 valid = false;
+    switch (*scanner->at) {
+        case 't':
+            response->type = ALPACA_VALUE_BOOL;
+            response->boolean = true;
+            valid = alpaca_scanner_literal(scanner, "true");
+            break;
+        case 'f':
+            response->type = ALPACA_VALUE_BOOL;
+            response->boolean = false;
+            valid = alpaca_scanner_literal(scanner, "false");
+            break;
+        case 'n':
+            response->type = ALPACA_VALUE_NULL;
+            valid = alpaca_scanner_literal(scanner, "null");
+            break;
+        case '"':
+            response->type = ALPACA_VALUE_STRING;
+            valid = alpaca_scanner_skip(scanner);
+            break;
+        case '[':
+            response->type = ALPACA_VALUE_ARRAY;
+            valid = alpaca_scanner_skip(scanner);
+            break;
+        case '{':
+            response->type = ALPACA_VALUE_OBJECT;
+            valid = alpaca_scanner_skip(scanner);
+            break;
+        default:
+            response->type = ALPACA_VALUE_NUMBER;
+            valid = alpaca_scanner_number(scanner, &response->number);
+            break;
+    }
+
+    response->raw = string_view_make(begin, scanner->at - begin);
+    return valid;
+}
+
+/// Checks whether the key matches the name, alpaca keys are treated case insensitive
+static b8 alpaca_key_equal(StringView const *key, const char *name) {
+    usize length = strlen(name);
+    if ((usize) key->length != length) {
+        return false;
+    }
+    for (usize i = 0; i < length; ++i) {
+        if (tolower((unsigned char) key->data[i]) != tolower((unsigned char) name[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Parses the alpaca envelope in place
+static b8 alpaca_response_parse(AlpacaResponse *response, String const *body) {
+    AlpacaScanner scanner = { .at = body->base, .end = body->base + body->length };
+    if (body->base == nil || !alpaca_scanner_expect(&scanner, '{')) {
+        return false;
+    }
+
+    alpaca_scanner_whitespace(&scanner);
+    if (scanner.at < scanner.end && *scanner.at == '}') {
+        return true;
+    }
+
+    for (;;) {
+        StringView key = { 0 };
+        if (!alpaca_scanner_string(&scanner, &key) || !alpaca_scanner_expect(&scanner, ':')) {
+            return false;
+        }
+
+        f64 number = 0.0;
+        b8 valid = true;
+        if (alpaca_key_equal(&key, "Value")) {
+            valid = alpaca_scanner_value(&scanner, response);
+        } else if (alpaca_key_equal(&key, "ErrorNumber")) {
+            valid = alpaca_scanner_number(&scanner, &number);
+            response->result.err_number = (AlpacaError) number;
+        } else if (alpaca_key_equal(&key, "ClientTransactionID")) {
+            valid = alpaca_scanner_number(&scanner, &number);
+            response->result.client_tx_id = (u32) number;
+        } else if (alpaca_key_equal(&key, "ServerTransactionID")) {
+            valid = alpaca_scanner_number(&scanner, &number);
+            response->result.server_tx_id = (u32) number;
+        } else {
+            valid = alpaca_scanner_skip(&scanner);
+        }
+
+        if (!valid) {
+            return false;
+        }
+
+        alpaca_scanner_whitespace(&scanner);
+        if (alpaca_scanner_expect(&scanner, ',')) {
+            continue;
+        }
+        return alpaca_scanner_expect(&scanner, '}');
+    }
+}
 
 /// Creates a new alpaca response
-void alpaca_response_make(AlpacaResponse *response, HttpResponse const *http) {
-    cJSON *data = cJSON_ParseWithLength(http->body.base, http->body.length);
-    response->result.client_tx_id = (u32) cJSON_GetNumberByName(data, "ClientTransactionID");
-    response->result.server_tx_id = (u32) cJSON_GetNumberByName(data, "ServerTransactionID");
-    response->result.err_number = (AlpacaError) cJSON_GetNumberByName(data, "ErrorNumber");
+void alpaca_response_make(AlpacaResponse *response, MemoryArena *arena, HttpResponse const *http) {
+    *response = (AlpacaResponse) { 0 };
+    response->number = NAN;
     response->result.status = (AlpacaStatus) http->code;
-    response->result.ok = response->result.err_number == ALPACA_ERROR_SUCCESSFUL_TX;
 
-    response->value = cJSON_Duplicate(cJSON_GetObjectItem(data, "Value"), true);
-    cJSON_Delete(data);
+    b8 parsed = alpaca_response_parse(response, &http->body);
+    response->result.ok = parsed && response->result.err_number == ALPACA_ERROR_SUCCESSFUL_TX;
+
+    // Only compound values need a tree, scalars are already available
+    if (parsed && response->type >= ALPACA_VALUE_STRING) {
+        MemoryArena *previous = cJSON_BindArena(arena);
+        response->value = cJSON_ParseWithLength(response->raw.data, response->raw.length);
+        cJSON_BindArena(previous);
+    }
 }
 
 /// Creates a failed alpaca response
 void alpaca_response_make_failed(AlpacaResponse *response) {
-    response->result = (AlpacaResult) { 0 };
+    *response = (AlpacaResponse) { 0 };
+    response->number = NAN;
     response->result.ok = false;
     response->value = nil;
 }
@@ -53,3 +292,18 @@ void alpaca_response_destroy(AlpacaResponse const *result) {
 
     cJSON_Delete(result->value);
 }
+
+/// Retrieves the value of the response as f64
+f64 alpaca_response_f64(AlpacaResponse const *response) {
+    return response->type == ALPACA_VALUE_NUMBER ? response->number : NAN;
+}
+
+/// Retrieves the value of the response as s64
+s64 alpaca_response_s64(AlpacaResponse const *response) {
+    return response->type == ALPACA_VALUE_NUMBER ? (s64) response->number : 0;
+}
+
+/// Retrieves the value of the response as boolean
+b8 alpaca_response_bool(AlpacaResponse const *response) {
+    return response->type == ALPACA_VALUE_BOOL && response->boolean;
+}
@@ -59,15 +59,43 @@ typedef struct AlpacaResult {
     b8 ok;
 } AlpacaResult;
 
+typedef enum AlpacaValueType {
+    ALPACA_VALUE_NONE = 0,
+    ALPACA_VALUE_NULL,
+    ALPACA_VALUE_BOOL,
+    ALPACA_VALUE_NUMBER,
+    ALPACA_VALUE_STRING,
+    ALPACA_VALUE_ARRAY,
+    ALPACA_VALUE_OBJECT,
+} AlpacaValueType;
+
 typedef struct AlpacaResponse {
     AlpacaResult result;
+
+    /// The type of the value, ALPACA_VALUE_NONE if the response has no value
+    AlpacaValueType type;
+
+    /// The value if it is a number
+    f64 number;
+
+    /// The value if it is a boolean
+    b8 boolean;
+
+    /// The raw JSON text of the value, which references the HTTP body
+    StringView raw;
+
+    /// The parsed value if it is a string, array or object, nil otherwise
     cJSON *value;
 } AlpacaResponse;
 
 /// Creates a new alpaca response
 /// @param response The response
+/// @param arena The arena for the parsed value, usually the request arena
 /// @param http The body
-void alpaca_response_make(AlpacaResponse *response, HttpResponse const *http);
+///
+/// @note The envelope is parsed in place, numbers and booleans are read without
+///       any allocation, only string, array and object values get parsed into a tree
+void alpaca_response_make(AlpacaResponse *response, MemoryArena *arena, HttpResponse const *http);
 
 /// Creates a failed alpaca response
 /// @param response The response
@@ -77,4 +105,19 @@ void alpaca_response_make_failed(AlpacaResponse *response);
 /// @param result The alpaca result
 void alpaca_response_destroy(AlpacaResponse const *result);
 
+/// Retrieves the value of the response as f64
+/// @param response The response
+/// @return The value, NAN if the value is not a number
+f64 alpaca_response_f64(AlpacaResponse const *response);
+
+/// Retrieves the value of the response as s64
+/// @param response The response
+/// @return The value, zero if the value is not a number
+s64 alpaca_response_s64(AlpacaResponse const *response);
+
+/// Retrieves the value of the response as boolean
+/// @param response The response
+/// @return The value, false if the value is not a boolean
+b8 alpaca_response_bool(AlpacaResponse const *response);
+
 #endif// ASCOM_ALPACA_H
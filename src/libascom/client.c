@@ -57,7 +57,7 @@ static AlpacaResponse alpaca_client_get(AlpacaClient *client, MemoryArena *arena
 
     // Execute the HTTP request
     HttpResponse response = { 0 };
-    if (!http_client_get(&response, arena, url.base)) {
+    if (!http_client_get(&response, arena, url.base, HTTP_FLAGS_NONE)) {
         // If the request fails, we must create a failed alpaca result
         AlpacaResponse result = { 0 };
         alpaca_response_make_failed(&result);
@@ -66,13 +66,13 @@ static AlpacaResponse alpaca_client_get(AlpacaClient *client, MemoryArena *arena
     }
 
     AlpacaResponse result = { 0 };
-    alpaca_response_make(&result, &response);
+    alpaca_response_make(&result, arena, &response);
     mutex_unlock(client->mutex);
     return result;
 }
 
 /// Creates an alpaca device from the specified json
-static b8 alpaca_client_device_from_json(AlpacaClient *client, AlpacaDevice *device, MemoryArena *arena, cJSON *json) {
+static b8 alpaca_client_device_from_json(AlpacaClient *client, AlpacaDevice *device, cJSON *json) {
     const char *name_json = cJSON_GetNativeStringByName(json, "DeviceName");
     const char *type_json = cJSON_GetNativeStringByName(json, "DeviceType");
     u32 number = (u32) cJSON_GetNumberByName(json, "DeviceNumber");
@@ -90,29 +90,21 @@ static b8 alpaca_client_device_from_json(AlpacaClient *client, AlpacaDevice *dev
     StringView address = string_view_from_native(client->server);
     StringView name = string_view_from_native(name_json);
     alpaca_device_make(device, type, &address, &name, number);
-
-    b8 connected = false;
-    if (alpaca_device_connected(device, arena, &connected).ok && connected == false) {
-        alpaca_device_update_connected(device, arena, true);
-    }
-
     return true;
 }
 
-/// Queries all configured devices from the alpaca client
-AlpacaResult alpaca_client_devices(AlpacaClient *client, AlpacaDeviceList *devices) {
+/// Queries all configured devices from the alpaca client without connecting them
+AlpacaResult alpaca_client_discover(AlpacaClient *client, AlpacaDeviceList *devices) {
     // It is guaranteed that the devices arena only contains the actual devices,
     // therefore it is necessary to create a temporary arena for the request
     MemoryArena request = memory_arena_identity(ALIGNMENT1);
     AlpacaResponse response = alpaca_client_get(client, &request, "management/v1/configureddevices");
     AlpacaResult result = response.result;
 
-    if (!cJSON_IsArray(response.value)) {
-        return result;
-    }
-
-    usize device_count = cJSON_GetArraySize(response.value);
+    usize device_count = cJSON_IsArray(response.value) ? cJSON_GetArraySize(response.value) : 0;
     if (device_count == 0) {
+        alpaca_response_destroy(&response);
+        memory_arena_destroy(&request);
         return result;
     }
 
@@ -126,7 +118,7 @@ AlpacaResult alpaca_client_devices(AlpacaClient *client, AlpacaDeviceList *devic
         }
 
         AlpacaDevice device = { 0 };
-        if (!alpaca_client_device_from_json(client, &device, &request, device_json)) {
+        if (!alpaca_client_device_from_json(client, &device, device_json)) {
             continue;
         }
 
@@ -137,3 +129,10 @@ AlpacaResult alpaca_client_devices(AlpacaClient *client, AlpacaDeviceList *devic
     memory_arena_destroy(&request);
     return result;
 }
+
+/// Queries all configured devices from the alpaca client and connects them
+AlpacaResult alpaca_client_devices(AlpacaClient *client, AlpacaDeviceList *devices) {
+    AlpacaResult result = alpaca_client_discover(client, devices);
+    alpaca_device_list_connect(devices, nil);
+    return result;
+}
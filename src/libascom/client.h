@@ -55,7 +55,14 @@ void alpaca_client_make(AlpacaClient *client, StringView *server);
 /// @param client The alpaca client handle
 void alpaca_client_destroy(AlpacaClient *client);
 
-/// Queries all configured devices from the alpaca client
+/// Queries all configured devices from the alpaca client without connecting them,
+/// the devices are in the connecting state
+/// @param client The alpaca client
+/// @param devices The device list
+/// @return A result
+AlpacaResult alpaca_client_discover(AlpacaClient *client, AlpacaDeviceList *devices);
+
+/// Queries all configured devices from the alpaca client and connects them
 /// @param client The alpaca client
 /// @param devices The device list
 /// @return A result
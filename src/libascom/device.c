@@ -23,6 +23,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "alpaca.h"
 #include "device.h"
@@ -32,8 +33,116 @@
 #include "utils/url.h"
 
 #include <libcore/string.h>
+#include <libcore/timer.h>
 #include <solaris/arena.h>
 
+/// Default time-to-live (ms) of attributes that rarely change
+#define ALPACA_DEVICE_TTL_SLOW 60000.0
+
+/// A payload attribute of a device type
+typedef struct AlpacaDeviceAttribute {
+    const char *name;
+    f64 ttl;
+} AlpacaDeviceAttribute;
+
+/// The payload attributes of observing conditions devices, indexed by field
+static const AlpacaDeviceAttribute alpaca_observing_conds_attributes[ALPACA_FIELD_OBSERVING_CONDS_COUNT] = {
+    [ALPACA_FIELD_AVERAGE_PERIOD] = { "averageperiod", ALPACA_DEVICE_TTL_SLOW },
+    [ALPACA_FIELD_CLOUD_COVER] = { "cloudcover", 0.0 },
+    [ALPACA_FIELD_DEW_POINT] = { "dewpoint", 0.0 },
+    [ALPACA_FIELD_HUMIDITY] = { "humidity", 0.0 },
+    [ALPACA_FIELD_PRESSURE] = { "pressure", 0.0 },
+    [ALPACA_FIELD_RAIN_RATE] = { "rainrate", 0.0 },
+    [ALPACA_FIELD_SKY_BRIGHTNESS] = { "skybrightness", 0.0 },
+    [ALPACA_FIELD_SKY_QUALITY] = { "skyquality", 0.0 },
+    [ALPACA_FIELD_SKY_TEMPERATURE] = { "skytemperature", 0.0 },
+    [ALPACA_FIELD_STAR_FWHM] = { "starfwhm", 0.0 },
+    [ALPACA_FIELD_TEMPERATURE] = { "temperature", 0.0 },
+    [ALPACA_FIELD_WIND_DIRECTION] = { "winddirection", 0.0 },
+    [ALPACA_FIELD_WIND_GUST] = { "windgust", 0.0 },
+    [ALPACA_FIELD_WIND_SPEED] = { "windspeed", 0.0 },
+};
+
+/// The payload attributes of telescope devices, indexed by field
+static const AlpacaDeviceAttribute alpaca_telescope_attributes[ALPACA_FIELD_TELESCOPE_COUNT] = {
+    [ALPACA_FIELD_ALTITUDE] = { "altitude", 0.0 },
+    [ALPACA_FIELD_AZIMUTH] = { "azimuth", 0.0 },
+    [ALPACA_FIELD_RIGHT_ASCENSION] = { "rightascension", 0.0 },
+    [ALPACA_FIELD_DECLINATION] = { "declination", 0.0 },
+    [ALPACA_FIELD_SIDEREAL_TIME] = { "siderealtime", 0.0 },
+    [ALPACA_FIELD_TRACKING] = { "tracking", 0.0 },
+    [ALPACA_FIELD_SLEWING] = { "slewing", 0.0 },
+    [ALPACA_FIELD_AT_PARK] = { "atpark", 0.0 },
+};
+
+/// The attributes that every device type supports
+static const char *const alpaca_common_attributes[] = {
+    "connected", "description", "driverinfo", "driverversion", "interfaceversion", "name", "supportedactions",
+};
+
+/// Retrieves the payload attributes of the provided device type
+static AlpacaDeviceAttribute const *alpaca_device_attributes(AlpacaDeviceType type, usize *count) {
+    switch (type) {
+        case ALPACA_DEVICE_TYPE_OBSERVING_CONDITIONS:
+            *count = ARRAY_SIZE(alpaca_observing_conds_attributes);
+            return alpaca_observing_conds_attributes;
+        case ALPACA_DEVICE_TYPE_TELESCOPE:
+            *count = ARRAY_SIZE(alpaca_telescope_attributes);
+            return alpaca_telescope_attributes;
+        default:
+            break;
+    }
+    *count = 0;
+    return nil;
+}
+
+/// Retrieves the payload field of an attribute, or -1 if the attribute is not part of the payload
+static ssize alpaca_device_attribute_field(AlpacaDevice const *device, const char *attribute) {
+    usize count = 0;
+    AlpacaDeviceAttribute const *attributes = alpaca_device_attributes(device->type, &count);
+    for (usize i = 0; i < count; ++i) {
+        if (strcmp(attributes[i].name, attribute) == 0) {
+            return (ssize) i;
+        }
+    }
+    return -1;
+}
+
+/// Checks whether a payload field can be served from the cache
+static b8 alpaca_device_field_fresh(AlpacaDeviceStamp const *stamps, usize field, f64 now) {
+    AlpacaDeviceStamp const *stamp = stamps + field;
+    return stamp->valid && stamp->ttl > 0.0 && now - stamp->timestamp < stamp->ttl;
+}
+
+/// Publishes the payload and its metadata as a new snapshot, the device lock must be held by the
+/// caller so that writers from different threads do not interleave on the sequence lock
+static void alpaca_device_publish(AlpacaDevice *device) {
+    seqlock_write_begin(&device->seqlock);
+    device->published.payload = device->payload;
+    for (usize i = 0; i < ALPACA_DEVICE_PAYLOAD_CAPACITY; ++i) {
+        device->published.stamps[i] = device->stamps[i];
+    }
+    device->published.state = device->state;
+    seqlock_write_end(&device->seqlock);
+}
+
+/// Retrieves the payload value of a response, booleans become zero or one
+static f64 alpaca_device_response_value(AlpacaResponse const *response) {
+    if (response->type == ALPACA_VALUE_BOOL) {
+        return response->boolean ? 1.0 : 0.0;
+    }
+    return alpaca_response_f64(response);
+}
+
+/// Stores a successfully read value in the payload
+static void alpaca_device_field_store(AlpacaDevice *device, usize field, f64 value, u32 server_tx_id, f64 now) {
+    AlpacaDeviceStamp *stamp = device->stamps + field;
+    device->payload.values[field] = value;
+    stamp->timestamp = now;
+    stamp->server_tx_id = server_tx_id;
+    stamp->valid = true;
+}
+
 /// Retrieves the string representation of the provided device type
 static const char *alpaca_device_type_to_string(AlpacaDeviceType type) {
     switch (type) {
@@ -63,6 +172,20 @@ static void alpaca_device_make_base_url(AlpacaDevice *device, StringView *addres
     alpaca_device_make_base_url_internal(device, address, &device->base_url);
 }
 
+/// Formats the request URLs of all known attributes of the device
+static void alpaca_device_make_urls(AlpacaDevice *device) {
+    usize count = 0;
+    AlpacaDeviceAttribute const *attributes = alpaca_device_attributes(device->type, &count);
+    device->url_count = count + ARRAY_SIZE(alpaca_common_attributes);
+    device->urls = (String *) memory_arena_alloc(&device->arena, sizeof(String) * device->url_count);
+
+    StringView base = string_view_make(device->base_url.base, device->base_url.length);
+    for (usize i = 0; i < device->url_count; ++i) {
+        const char *name = i < count ? attributes[i].name : alpaca_common_attributes[i - count];
+        alpaca_make_path_url(&base, &device->arena, device->urls + i, name);
+    }
+}
+
 /// Adds the client headers to the data that gets sent to the device
 static void alpaca_device_add_client_headers(AlpacaDevice *device, cJSON *data) {
     cJSON_AddNumberToObject(data, "ClientTransactionID", device->client_tx_id);
@@ -88,7 +211,7 @@ void alpaca_device_make(AlpacaDevice *device,
                         StringView *address,
                         StringView *name,
                         u32 number) {
-    device->arena = memory_arena_identity(ALIGNMENT1);
+    device->arena = memory_arena_identity(ALIGNMENT8);
     device->type = type;
     device->number = number;
 
@@ -97,7 +220,22 @@ void alpaca_device_make(AlpacaDevice *device,
 
     device->mutex = mutex_new();
     alpaca_device_make_base_url(device, address);
+    alpaca_device_make_urls(device);
     device->name = string_new(&device->arena, name->data, name->length);
+
+    usize count = 0;
+    AlpacaDeviceAttribute const *attributes = alpaca_device_attributes(type, &count);
+    for (usize i = 0; i < ALPACA_DEVICE_PAYLOAD_CAPACITY; ++i) {
+        device->payload.values[i] = 0.0;
+        device->stamps[i] = (AlpacaDeviceStamp) { .ttl = i < count ? attributes[i].ttl : 0.0 };
+        device->history[i] = (TimeSeries) { 0 };
+        if (i < count) {
+            time_series_make(device->history + i, &device->arena, ALPACA_DEVICE_HISTORY_CAPACITY);
+        }
+    }
+    device->state = ALPACA_DEVICE_STATE_CONNECTING;
+    device->seqlock = (SeqLock) { 0 };
+    alpaca_device_publish(device);
 }
 
 /// Destroys the alpaca device
@@ -110,55 +248,328 @@ void alpaca_device_destroy(AlpacaDevice *device) {
     mutex_free(device->mutex);
 }
 
-/// Send an HTTP GET request to the device
-AlpacaResponse alpaca_device_get(AlpacaDevice *device, MemoryArena *arena, const char *attribute) {
-    mutex_lock(device->mutex);
-    device->client_tx_id++;
+/// Retrieves the request URL of an attribute, known attributes are served from the URL table
+const char *alpaca_device_url(AlpacaDevice const *device, MemoryArena *arena, const char *attribute) {
+    usize count = 0;
+    AlpacaDeviceAttribute const *attributes = alpaca_device_attributes(device->type, &count);
+    for (usize i = 0; i < device->url_count; ++i) {
+        const char *name = i < count ? attributes[i].name : alpaca_common_attributes[i - count];
+        if (name == attribute || strcmp(name, attribute) == 0) {
+            return device->urls[i].base;
+        }
+    }
 
     String url = { 0 };
     StringView base = string_view_make(device->base_url.base, device->base_url.length);
     alpaca_make_path_url(&base, arena, &url, attribute);
+    return url.base;
+}
+
+/// Send an HTTP GET request to the device
+AlpacaResponse alpaca_device_get(AlpacaDevice *device, MemoryArena *arena, const char *attribute) {
+    // The lock only covers the transaction bookkeeping, other threads must not wait for the transfer
+    mutex_lock(device->mutex);
+    device->client_tx_id++;
+    const char *url = alpaca_device_url(device, arena, attribute);
+    mutex_unlock(device->mutex);
 
     // Execute the HTTP request
     HttpResponse response = { 0 };
-    if (!http_client_get(&response, arena, url.base)) {
+    if (!http_client_get(&response, arena, url, HTTP_FLAGS_NONE)) {
         // If the request fails, we must create a failed alpaca result
         AlpacaResponse result = { 0 };
         alpaca_response_make_failed(&result);
-        mutex_unlock(device->mutex);
         return result;
     }
 
     AlpacaResponse result = { 0 };
-    alpaca_response_make(&result, &response);
+    alpaca_response_make(&result, arena, &response);
+    return result;
+}
+
+/// Submits an asynchronous HTTP GET request, the device lock must be held by the caller
+static HttpRequest *alpaca_device_get_submit_locked(AlpacaDevice *device,
+                                                    HttpMulti *multi,
+                                                    MemoryArena *arena,
+                                                    const char *attribute) {
+    device->client_tx_id++;
+
+    const char *url = alpaca_device_url(device, arena, attribute);
+    return http_multi_submit_get(multi, arena, url);
+}
+
+/// Submits an asynchronous HTTP GET request to the device
+HttpRequest *alpaca_device_get_submit(AlpacaDevice *device,
+                                      HttpMulti *multi,
+                                      MemoryArena *arena,
+                                      const char *attribute) {
+    mutex_lock(device->mutex);
+    HttpRequest *request = alpaca_device_get_submit_locked(device, multi, arena, attribute);
+    mutex_unlock(device->mutex);
+    return request;
+}
+
+/// Submits an asynchronous HTTP PUT request to the device
+HttpRequest *alpaca_device_put_submit(AlpacaDevice *device,
+                                      HttpMulti *multi,
+                                      MemoryArena *arena,
+                                      const char *attribute,
+                                      cJSON *data) {
+    mutex_lock(device->mutex);
+    alpaca_device_add_client_headers(device, data);
+    device->client_tx_id++;
+
+    const char *url = alpaca_device_url(device, arena, attribute);
+    HttpRequest *request = http_multi_submit_put_form(multi, arena, url, data);
+    mutex_unlock(device->mutex);
+    return request;
+}
+
+/// Creates the response of a submitted HTTP GET or PUT request once it is done
+AlpacaResponse alpaca_device_get_complete(HttpRequest const *request) {
+    AlpacaResponse result = { 0 };
+    if (!(request->done && request->ok)) {
+        alpaca_response_make_failed(&result);
+        return result;
+    }
+
+    alpaca_response_make(&result, request->arena, &request->response);
+    return result;
+}
+
+/// Send HTTP GET requests for many attributes of the device at once
+void alpaca_device_get_many(AlpacaDevice *device,
+                            HttpMulti *multi,
+                            MemoryArena *arena,
+                            const char *const *attributes,
+                            AlpacaResponse *responses,
+                            usize count) {
+    HttpMulti temporary = { 0 };
+    if (multi == nil) {
+        http_multi_make(&temporary);
+        multi = &temporary;
+    }
+
+    HttpRequest **requests = (HttpRequest **) memory_arena_alloc(arena, sizeof(HttpRequest *) * count);
+
+    mutex_lock(device->mutex);
+    for (usize i = 0; i < count; ++i) {
+        requests[i] = alpaca_device_get_submit_locked(device, multi, arena, attributes[i]);
+    }
+    mutex_unlock(device->mutex);
+    http_multi_complete(multi);
+
+    for (usize i = 0; i < count; ++i) {
+        responses[i] = alpaca_device_get_complete(requests[i]);
+    }
+
+    if (multi == &temporary) {
+        http_multi_destroy(&temporary);
+    }
+}
+
+/// Send HTTP GET requests for many attributes of the device at once and retrieve f64 values
+AlpacaResult alpaca_device_get_many_f64(AlpacaDevice *device,
+                                        HttpMulti *multi,
+                                        MemoryArena *arena,
+                                        const char *const *attributes,
+                                        f64 *const *values,
+                                        AlpacaResult *results,
+                                        usize count) {
+    AlpacaResponse *responses = (AlpacaResponse *) memory_arena_alloc(arena, sizeof(AlpacaResponse) * count);
+    alpaca_device_get_many(device, multi, arena, attributes, responses, count);
+
+    AlpacaResult combined = { .status = ALPACA_OK, .ok = true };
+    for (usize i = 0; i < count; ++i) {
+        *values[i] = alpaca_response_f64(responses + i);
+        if (results != nil) {
+            results[i] = responses[i].result;
+        }
+        if (combined.ok && !responses[i].result.ok) {
+            combined = responses[i].result;
+        }
+        alpaca_response_destroy(responses + i);
+    }
+    return combined;
+}
+
+/// Sets the time-to-live of a cached payload attribute
+b8 alpaca_device_set_ttl(AlpacaDevice *device, const char *attribute, f64 ttl) {
+    ssize field = alpaca_device_attribute_field(device, attribute);
+    if (field < 0) {
+        return false;
+    }
+    mutex_lock(device->mutex);
+    device->stamps[field].ttl = ttl;
+    alpaca_device_publish(device);
     mutex_unlock(device->mutex);
+    return true;
+}
+
+/// Retrieves a consistent copy of the last published device state without taking a lock
+void alpaca_device_snapshot(AlpacaDevice const *device, AlpacaDeviceSnapshot *snapshot) {
+    u32 sequence = 0;
+    do {
+        sequence = seqlock_read_begin(&device->seqlock);
+        *snapshot = device->published;
+    } while (seqlock_read_retry(&device->seqlock, sequence));
+}
+
+/// Retrieves the age of a payload field
+f64 alpaca_device_age(AlpacaDeviceSnapshot const *snapshot, usize field) {
+    if (field >= ALPACA_DEVICE_PAYLOAD_CAPACITY || !snapshot->stamps[field].valid) {
+        return -1.0;
+    }
+    return timer_now() - snapshot->stamps[field].timestamp;
+}
+
+/// Retrieves a f64 payload attribute, either from the payload or from the server
+AlpacaResult alpaca_device_get_cached_f64(AlpacaDevice *device, MemoryArena *arena, const char *attribute, f64 *value) {
+    ssize field = alpaca_device_attribute_field(device, attribute);
+    if (field < 0) {
+        return alpaca_device_get_f64(device, arena, attribute, value);
+    }
+
+    // Cache hits are served from the published snapshot, the payload belongs to the writers
+    AlpacaDeviceSnapshot snapshot = { 0 };
+    alpaca_device_snapshot(device, &snapshot);
+    f64 now = timer_now();
+    if (alpaca_device_field_fresh(snapshot.stamps, (usize) field, now)) {
+        *value = snapshot.payload.values[field];
+        return (AlpacaResult) { .status = ALPACA_OK, .server_tx_id = snapshot.stamps[field].server_tx_id, .ok = true };
+    }
+
+    AlpacaResponse response = alpaca_device_get(device, arena, attribute);
+    AlpacaResult result = response.result;
+    mutex_lock(device->mutex);
+    if (result.ok) {
+        alpaca_device_field_store(device, (usize) field, alpaca_device_response_value(&response), result.server_tx_id,
+                                  now);
+        alpaca_device_publish(device);
+    }
+    *value = device->payload.values[field];
+    mutex_unlock(device->mutex);
+    alpaca_response_destroy(&response);
     return result;
 }
 
+/// Stores a value in the payload as if it was read from the server and publishes it
+void alpaca_device_update_field(AlpacaDevice *device, usize field, f64 value, u32 server_tx_id) {
+    if (field >= ALPACA_DEVICE_PAYLOAD_CAPACITY) {
+        return;
+    }
+    mutex_lock(device->mutex);
+    alpaca_device_field_store(device, field, value, server_tx_id, timer_now());
+    alpaca_device_publish(device);
+    mutex_unlock(device->mutex);
+}
+
+/// Sets the readiness of the device and publishes it
+void alpaca_device_set_state(AlpacaDevice *device, AlpacaDeviceState state) {
+    mutex_lock(device->mutex);
+    device->state = state;
+    alpaca_device_publish(device);
+    mutex_unlock(device->mutex);
+}
+
+/// Retrieves the number of payload fields of the device
+usize alpaca_device_field_count(AlpacaDevice const *device) {
+    usize count = 0;
+    alpaca_device_attributes(device->type, &count);
+    return count;
+}
+
+/// Refreshes the specified stale payload fields of the device concurrently
+AlpacaResult alpaca_device_sample_fields(AlpacaDevice *device,
+                                         HttpMulti *multi,
+                                         MemoryArena *arena,
+                                         usize const *fields,
+                                         AlpacaResult *results,
+                                         usize count) {
+    usize attribute_count = 0;
+    AlpacaDeviceAttribute const *attributes = alpaca_device_attributes(device->type, &attribute_count);
+
+    // Collect the stale fields, fresh ones are served from the payload
+    AlpacaDeviceSnapshot snapshot = { 0 };
+    alpaca_device_snapshot(device, &snapshot);
+    f64 now = timer_now();
+    usize stale_count = 0;
+    usize *stale = (usize *) memory_arena_alloc(arena, sizeof(usize) * count);
+    const char **stale_attributes = (const char **) memory_arena_alloc(arena, sizeof(const char *) * count);
+    for (usize i = 0; i < count; ++i) {
+        usize field = fields[i];
+        if (results != nil) {
+            results[i] = (AlpacaResult) { .status = ALPACA_OK, .server_tx_id = snapshot.stamps[field].server_tx_id,
+                                          .ok = true };
+        }
+        if (field < attribute_count && !alpaca_device_field_fresh(snapshot.stamps, field, now)) {
+            stale[stale_count] = i;
+            stale_attributes[stale_count] = attributes[field].name;
+            stale_count++;
+        }
+    }
+
+    AlpacaResult combined = { .status = ALPACA_OK, .ok = true };
+    if (stale_count == 0) {
+        return combined;
+    }
+
+    AlpacaResponse *responses = (AlpacaResponse *) memory_arena_alloc(arena, sizeof(AlpacaResponse) * stale_count);
+    alpaca_device_get_many(device, multi, arena, stale_attributes, responses, stale_count);
+
+    // Failed reads keep the last known value, their age reveals that they are stale
+    now = timer_now();
+    mutex_lock(device->mutex);
+    for (usize i = 0; i < stale_count; ++i) {
+        AlpacaResult const *result = &responses[i].result;
+        if (result->ok) {
+            alpaca_device_field_store(device, fields[stale[i]], alpaca_device_response_value(responses + i),
+                                      result->server_tx_id, now);
+        } else if (combined.ok) {
+            combined = *result;
+        }
+        if (results != nil) {
+            results[stale[i]] = *result;
+        }
+        alpaca_response_destroy(responses + i);
+    }
+
+    // All fields of the sample become visible at once
+    alpaca_device_publish(device);
+    mutex_unlock(device->mutex);
+    return combined;
+}
+
+/// Refreshes all stale payload fields of the device concurrently
+AlpacaResult alpaca_device_sample(AlpacaDevice *device, HttpMulti *multi, MemoryArena *arena) {
+    usize fields[ALPACA_DEVICE_PAYLOAD_CAPACITY];
+    usize count = alpaca_device_field_count(device);
+    for (usize i = 0; i < count; ++i) {
+        fields[i] = i;
+    }
+    return alpaca_device_sample_fields(device, multi, arena, fields, nil, count);
+}
+
 /// Send an HTTP PUT request to the device
 AlpacaResponse alpaca_device_put(AlpacaDevice *device, MemoryArena *arena, const char *attribute, cJSON *data) {
     mutex_lock(device->mutex);
     alpaca_device_add_client_headers(device, data);
     device->client_tx_id++;
-
-    String url = { 0 };
-    StringView base = string_view_make(device->base_url.base, device->base_url.length);
-    alpaca_make_path_url(&base, arena, &url, attribute);
+    const char *url = alpaca_device_url(device, arena, attribute);
+    mutex_unlock(device->mutex);
 
     // Execute the HTTP request
     HttpResponse response = { 0 };
-    if (!http_client_put_form(&response, arena, url.base, data)) {
+    if (!http_client_put_form(&response, arena, url, data, HTTP_FLAGS_NONE)) {
         // If the request fails, we must create a failed alpaca result
         AlpacaResponse result = { 0 };
         alpaca_response_make_failed(&result);
-        mutex_unlock(device->mutex);
         return result;
     }
 
     // Create result
     AlpacaResponse result = { 0 };
-    alpaca_response_make(&result, &response);
-    mutex_unlock(device->mutex);
+    alpaca_response_make(&result, arena, &response);
     return result;
 }
 
@@ -181,7 +592,7 @@ AlpacaResult alpaca_device_update_connected(AlpacaDevice *device, MemoryArena *a
 /// Send an HTTP GET request to the device and retrieve a f64 value
 AlpacaResult alpaca_device_get_f64(AlpacaDevice *device, MemoryArena *arena, const char *attribute, f64 *value) {
     AlpacaResponse response = alpaca_device_get(device, arena, attribute);
-    *value = cJSON_GetNumberValue(response.value);
+    *value = alpaca_response_f64(&response);
     AlpacaResult result = response.result;
     alpaca_response_destroy(&response);
     return result;
@@ -190,7 +601,7 @@ AlpacaResult alpaca_device_get_f64(AlpacaDevice *device, MemoryArena *arena, con
 /// Send an HTTP GET request to the device and retrieve a s64 value
 AlpacaResult alpaca_device_get_s64(AlpacaDevice *device, MemoryArena *arena, const char *attribute, s64 *value) {
     AlpacaResponse response = alpaca_device_get(device, arena, attribute);
-    *value = (s64) cJSON_GetNumberValue(response.value);
+    *value = alpaca_response_s64(&response);
     AlpacaResult result = response.result;
     alpaca_response_destroy(&response);
     return result;
@@ -199,7 +610,7 @@ AlpacaResult alpaca_device_get_s64(AlpacaDevice *device, MemoryArena *arena, con
 /// Send an HTTP GET request to the device and retrieve a boolean value
 AlpacaResult alpaca_device_get_bool(AlpacaDevice *device, MemoryArena *arena, const char *attribute, b8 *value) {
     AlpacaResponse response = alpaca_device_get(device, arena, attribute);
-    *value = cJSON_IsBool(response.value) && cJSON_IsTrue(response.value);
+    *value = alpaca_response_bool(&response);
     AlpacaResult result = response.result;
     alpaca_response_destroy(&response);
     return result;
@@ -207,14 +618,18 @@ AlpacaResult alpaca_device_get_bool(AlpacaDevice *device, MemoryArena *arena, co
 
 /// Creates a new alpaca device list
 void alpaca_device_list_make(AlpacaDeviceList *list) {
-    list->arena = memory_arena_identity(ALIGNMENT1);
+    // Devices contain doubles and the sequence lock, which must be aligned
+    list->arena = memory_arena_identity(ALIGNMENT8);
+    list->devices = nil;
+    list->count = 0;
+    list->reserved = 0;
 }
 
 /// Appends an alpaca device to the list
 void alpaca_device_list_append(AlpacaDeviceList *list, AlpacaDevice *device) {
     if (list->count == list->reserved) {
-        list->reserved *= 2;
-        AlpacaDevice *copied = (AlpacaDevice *) memory_arena_alloc(&list->arena, list->reserved);
+        list->reserved = list->reserved > 0 ? list->reserved * 2 : 4;
+        AlpacaDevice *copied = (AlpacaDevice *) memory_arena_alloc(&list->arena, sizeof(AlpacaDevice) * list->reserved);
         for (usize i = 0; i < list->count; ++i) {
             copied[i] = list->devices[i];
         }
@@ -225,8 +640,12 @@ void alpaca_device_list_append(AlpacaDeviceList *list, AlpacaDevice *device) {
     list->count++;
 }
 
-/// Clears the device list
+/// Clears the device list and destroys the associated devices
 void alpaca_device_list_clear(AlpacaDeviceList *list) {
+    // Every device owns its history and a mutex, clearing the list arena alone would leak them
+    for (usize i = 0; i < list->count; ++i) {
+        alpaca_device_destroy(list->devices + i);
+    }
     list->count = 0;
     list->reserved = 0;
     list->devices = nil;
@@ -235,7 +654,15 @@ void alpaca_device_list_clear(AlpacaDeviceList *list) {
 
 /// Reserves space for the provided amount of devices
 void alpaca_device_list_reserve(AlpacaDeviceList *list, usize count) {
-    list->devices = (AlpacaDevice *) memory_arena_alloc(&list->arena, sizeof(AlpacaDevice) * count);
+    if (count <= list->reserved) {
+        return;
+    }
+    AlpacaDevice *reserved = (AlpacaDevice *) memory_arena_alloc(&list->arena, sizeof(AlpacaDevice) * count);
+    for (usize i = 0; i < list->count; ++i) {
+        reserved[i] = list->devices[i];
+    }
+    list->devices = reserved;
+    list->reserved = count;
 }
 
 /// Destroys the alpaca device list and the associated devices
@@ -246,3 +673,59 @@ void alpaca_device_list_destroy(AlpacaDeviceList *list) {
     list->devices = nil;
     memory_arena_destroy(&list->arena);
 }
+
+/// Connects the devices concurrently, every device becomes ready as soon as its own requests are done
+void alpaca_device_connect_many(AlpacaDevice *devices, usize count, HttpMulti *multi) {
+    HttpMulti temporary = { 0 };
+    if (multi == nil) {
+        http_multi_make(&temporary);
+        multi = &temporary;
+    }
+
+    // Check the connected state of all devices at once
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+    HttpRequest **requests = (HttpRequest **) memory_arena_alloc(&arena, sizeof(HttpRequest *) * count);
+    b8 *connecting = (b8 *) memory_arena_alloc(&arena, sizeof(b8) * count);
+    for (usize i = 0; i < count; ++i) {
+        requests[i] = alpaca_device_get_submit(devices + i, multi, &arena, "connected");
+        connecting[i] = false;
+    }
+
+    usize remaining = count;
+    while (remaining > 0) {
+        http_multi_poll(multi, HTTP_MULTI_POLL_TIMEOUT);
+        for (usize i = 0; i < count; ++i) {
+            if (requests[i] == nil || !requests[i]->done) {
+                continue;
+            }
+
+            AlpacaDevice *device = devices + i;
+            AlpacaResponse response = alpaca_device_get_complete(requests[i]);
+            requests[i] = nil;
+
+            // Disconnected devices are connected right away, without waiting for the other checks
+            if (!connecting[i] && response.result.ok && !alpaca_response_bool(&response)) {
+                cJSON *data = cJSON_CreateObject();
+                cJSON_AddBoolToObject(data, "Connected", true);
+                requests[i] = alpaca_device_put_submit(device, multi, &arena, "connected", data);
+                cJSON_Delete(data);
+                connecting[i] = true;
+            } else {
+                AlpacaDeviceState state = response.result.ok ? ALPACA_DEVICE_STATE_READY : ALPACA_DEVICE_STATE_FAILED;
+                alpaca_device_set_state(device, state);
+                remaining--;
+            }
+            alpaca_response_destroy(&response);
+        }
+    }
+
+    memory_arena_destroy(&arena);
+    if (multi == &temporary) {
+        http_multi_destroy(&temporary);
+    }
+}
+
+/// Connects all devices of the list concurrently, every device becomes ready as soon as its own requests are done
+void alpaca_device_list_connect(AlpacaDeviceList *list, HttpMulti *multi) {
+    alpaca_device_connect_many(list->devices, list->count, multi);
+}
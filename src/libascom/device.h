@@ -25,9 +25,11 @@
 #define ASCOM_DEVICE_H
 
 #include "alpaca.h"
+#include "http/multi.h"
 #include "utils/cJSON.h"
 
 #include <libcore/arch/thread.h>
+#include <libcore/series.h>
 #include <libcore/string.h>
 #include <libcore/types.h>
 
@@ -42,6 +44,58 @@ typedef enum AlpacaDeviceType {
 /// @return The alpaca device type
 AlpacaDeviceType alpaca_device_type_make(StringView *type);
 
+/// The readiness of a device while the client connects to it
+typedef enum AlpacaDeviceState {
+    /// The device was discovered, the client is still connecting
+    ALPACA_DEVICE_STATE_CONNECTING = 0,
+
+    /// The device is connected and can be sampled
+    ALPACA_DEVICE_STATE_READY,
+
+    /// The device could not be connected
+    ALPACA_DEVICE_STATE_FAILED,
+} AlpacaDeviceState;
+
+/// Indices of the observing conditions fields within the payload
+typedef enum AlpacaObservingCondsField {
+    ALPACA_FIELD_AVERAGE_PERIOD = 0,
+    ALPACA_FIELD_CLOUD_COVER,
+    ALPACA_FIELD_DEW_POINT,
+    ALPACA_FIELD_HUMIDITY,
+    ALPACA_FIELD_PRESSURE,
+    ALPACA_FIELD_RAIN_RATE,
+    ALPACA_FIELD_SKY_BRIGHTNESS,
+    ALPACA_FIELD_SKY_QUALITY,
+    ALPACA_FIELD_SKY_TEMPERATURE,
+    ALPACA_FIELD_STAR_FWHM,
+    ALPACA_FIELD_TEMPERATURE,
+    ALPACA_FIELD_WIND_DIRECTION,
+    ALPACA_FIELD_WIND_GUST,
+    ALPACA_FIELD_WIND_SPEED,
+    ALPACA_FIELD_OBSERVING_CONDS_COUNT,
+} AlpacaObservingCondsField;
+
+/// Indices of the telescope fields within the payload
+typedef enum AlpacaTelescopeField {
+    ALPACA_FIELD_ALTITUDE = 0,
+    ALPACA_FIELD_AZIMUTH,
+    ALPACA_FIELD_RIGHT_ASCENSION,
+    ALPACA_FIELD_DECLINATION,
+    ALPACA_FIELD_SIDEREAL_TIME,
+    ALPACA_FIELD_TRACKING,
+    ALPACA_FIELD_SLEWING,
+    ALPACA_FIELD_AT_PARK,
+    ALPACA_FIELD_TELESCOPE_COUNT,
+} AlpacaTelescopeField;
+
+enum {
+    /// The maximum number of fields within the payload
+    ALPACA_DEVICE_PAYLOAD_CAPACITY = 14,
+
+    /// The number of samples kept in the history of every field
+    ALPACA_DEVICE_HISTORY_CAPACITY = 8192,
+};
+
 /// The payload of the alpaca device, represents the last known state
 typedef union AlpacaDevicePayload {
     /// Observing Conditions data
@@ -62,13 +116,49 @@ typedef union AlpacaDevicePayload {
         f64 wind_speed;
     };
 
-    /// Telescope specific data
+    /// Telescope specific data, boolean fields are stored as zero or one
     struct {
         f64 altitude;
         f64 azimuth;
+        f64 right_ascension;
+        f64 declination;
+        f64 sidereal_time;
+        f64 tracking;
+        f64 slewing;
+        f64 at_park;
     };
+
+    /// The fields by their index
+    f64 values[ALPACA_DEVICE_PAYLOAD_CAPACITY];
 } AlpacaDevicePayload;
 
+/// Cache metadata that is recorded alongside every payload field
+typedef struct AlpacaDeviceStamp {
+    /// Monotonic time (ms) of the last successful read
+    f64 timestamp;
+
+    /// Time-to-live (ms) of the field, zero means the field is read on every sample
+    f64 ttl;
+
+    /// The server transaction ID of the response the field stems from
+    u32 server_tx_id;
+
+    /// Whether the field has ever been read successfully
+    b8 valid;
+} AlpacaDeviceStamp;
+
+/// A consistent copy of the device state as published by the sampling thread
+typedef struct AlpacaDeviceSnapshot {
+    /// The payload
+    AlpacaDevicePayload payload;
+
+    /// The cache metadata of the payload fields
+    AlpacaDeviceStamp stamps[ALPACA_DEVICE_PAYLOAD_CAPACITY];
+
+    /// The readiness of the device
+    AlpacaDeviceState state;
+} AlpacaDeviceSnapshot;
+
 typedef struct AlpacaDevice {
     /// One of the recognised ASCOM device types
     AlpacaDeviceType type;
@@ -80,6 +170,13 @@ typedef struct AlpacaDevice {
     /// stored within the device
     String base_url;
 
+    /// Request URLs of the payload attributes followed by the common attributes,
+    /// formatted once when the device is created
+    String *urls;
+
+    /// The number of request URLs
+    usize url_count;
+
     /// The name of the device
     String name;
 
@@ -89,12 +186,27 @@ typedef struct AlpacaDevice {
     /// The transaction ID, gets incremented with every command
     u32 client_tx_id;
 
-    /// Lock in order to enable thread-safety
+    /// Lock in order to enable thread-safety, never held across an HTTP transfer
     Mutex *mutex;
 
-    /// The payload
+    /// The payload, written under the lock
     AlpacaDevicePayload payload;
 
+    /// The cache metadata of the payload fields, written under the lock
+    AlpacaDeviceStamp stamps[ALPACA_DEVICE_PAYLOAD_CAPACITY];
+
+    /// The readiness of the device, written under the lock
+    AlpacaDeviceState state;
+
+    /// Guards the published snapshot
+    SeqLock seqlock;
+
+    /// The last published state, read through alpaca_device_snapshot
+    AlpacaDeviceSnapshot published;
+
+    /// The sample history of every payload field, in seconds of the monotonic clock
+    TimeSeries history[ALPACA_DEVICE_PAYLOAD_CAPACITY];
+
     /// The device arena for internal allocations
     MemoryArena arena;
 } AlpacaDevice;
@@ -111,6 +223,13 @@ void alpaca_device_make(AlpacaDevice *device, AlpacaDeviceType type, StringView
 /// @param device The alpaca device handle
 void alpaca_device_destroy(AlpacaDevice *device);
 
+/// Retrieves the request URL of an attribute, known attributes are served from the URL table
+/// @param device The alpaca device handle
+/// @param arena The arena for formatting URLs of unknown attributes
+/// @param attribute The attribute
+/// @return The zero-terminated request URL
+const char *alpaca_device_url(AlpacaDevice const *device, MemoryArena *arena, const char *attribute);
+
 /// Send an HTTP GET request to the device
 /// @note It is extremely important to know that the response
 ///       must be destroyed by the caller.
@@ -121,6 +240,141 @@ void alpaca_device_destroy(AlpacaDevice *device);
 /// @return A response
 AlpacaResponse alpaca_device_get(AlpacaDevice *device, MemoryArena *arena, const char *attribute);
 
+/// Submits an asynchronous HTTP GET request to the device
+/// @param device The alpaca device handle
+/// @param multi The multi engine that drives the request
+/// @param arena The arena for the request allocation
+/// @param attribute The attribute to get from the server
+/// @return The submitted request
+HttpRequest *alpaca_device_get_submit(AlpacaDevice *device,
+                                      HttpMulti *multi,
+                                      MemoryArena *arena,
+                                      const char *attribute);
+
+/// Submits an asynchronous HTTP PUT request to the device
+/// @param device The alpaca device handle
+/// @param multi The multi engine that drives the request
+/// @param arena The arena for the request allocation
+/// @param attribute The attribute to put on the server
+/// @param data The form data, which is copied on submission
+/// @return The submitted request
+HttpRequest *alpaca_device_put_submit(AlpacaDevice *device,
+                                      HttpMulti *multi,
+                                      MemoryArena *arena,
+                                      const char *attribute,
+                                      cJSON *data);
+
+/// Creates the response of a submitted HTTP GET or PUT request once it is done
+/// @note It is extremely important to know that the response
+///       must be destroyed by the caller.
+///
+/// @param request The completed request
+/// @return A response
+AlpacaResponse alpaca_device_get_complete(HttpRequest const *request);
+
+/// Send HTTP GET requests for many attributes of the device at once, the requests
+/// are issued concurrently and the device lock is only held while they are submitted
+/// @note It is extremely important to know that the responses
+///       must be destroyed by the caller.
+///
+/// @param device The alpaca device handle
+/// @param multi The multi engine that drives the requests, nil for a temporary engine
+/// @param arena The arena for the request allocation
+/// @param attributes The attributes to get from the server
+/// @param responses The responses, one for every attribute
+/// @param count The number of attributes
+void alpaca_device_get_many(AlpacaDevice *device,
+                            HttpMulti *multi,
+                            MemoryArena *arena,
+                            const char *const *attributes,
+                            AlpacaResponse *responses,
+                            usize count);
+
+/// Send HTTP GET requests for many attributes of the device at once and retrieve f64 values
+/// @param device The alpaca device handle
+/// @param multi The multi engine that drives the requests, nil for a temporary engine
+/// @param arena The arena for the request allocation
+/// @param attributes The attributes to get from the server
+/// @param values The values that will be set, one for every attribute
+/// @param results The results, one for every attribute, may be nil
+/// @param count The number of attributes
+/// @return The first failed result, or a successful result if all requests succeeded
+AlpacaResult alpaca_device_get_many_f64(AlpacaDevice *device,
+                                        HttpMulti *multi,
+                                        MemoryArena *arena,
+                                        const char *const *attributes,
+                                        f64 *const *values,
+                                        AlpacaResult *results,
+                                        usize count);
+
+/// Sets the time-to-live of a cached payload attribute, reads of the attribute are
+/// served from the payload as long as the last successful read is younger than the ttl
+/// @param device The alpaca device handle
+/// @param attribute The attribute, e.g. "averageperiod"
+/// @param ttl The time-to-live in milliseconds, zero disables caching
+/// @return Whether the attribute is part of the device payload
+b8 alpaca_device_set_ttl(AlpacaDevice *device, const char *attribute, f64 ttl);
+
+/// Retrieves a consistent copy of the last published device state without taking a lock,
+/// related values such as altitude and azimuth always stem from the same sample
+/// @param device The alpaca device handle
+/// @param snapshot The snapshot that will be filled
+void alpaca_device_snapshot(AlpacaDevice const *device, AlpacaDeviceSnapshot *snapshot);
+
+/// Retrieves the age of a payload field
+/// @param snapshot The device snapshot
+/// @param field The index of the field within the payload
+/// @return The age in milliseconds, or a negative value if the field was never read
+f64 alpaca_device_age(AlpacaDeviceSnapshot const *snapshot, usize field);
+
+/// Retrieves a f64 payload attribute, the value is served from the payload if it is
+/// still fresh, otherwise it is read from the server and stored in the payload
+/// @param device The alpaca device handle
+/// @param arena The arena for the request allocation
+/// @param attribute The attribute to get from the server
+/// @param value The value that will be set
+/// @return A result, the cached result if the value was served from the payload
+AlpacaResult alpaca_device_get_cached_f64(AlpacaDevice *device, MemoryArena *arena, const char *attribute, f64 *value);
+
+/// Stores a value in the payload as if it was read from the server and publishes it
+/// @param device The alpaca device handle
+/// @param field The index of the field within the payload
+/// @param value The value
+/// @param server_tx_id The server transaction ID the value stems from
+void alpaca_device_update_field(AlpacaDevice *device, usize field, f64 value, u32 server_tx_id);
+
+/// Sets the readiness of the device and publishes it
+/// @param device The alpaca device handle
+/// @param state The readiness
+void alpaca_device_set_state(AlpacaDevice *device, AlpacaDeviceState state);
+
+/// Retrieves the number of payload fields of the device
+/// @param device The alpaca device handle
+/// @return The number of fields, which depends on the device type
+usize alpaca_device_field_count(AlpacaDevice const *device);
+
+/// Refreshes the specified stale payload fields of the device concurrently, fresh fields are skipped
+/// @param device The alpaca device handle
+/// @param multi The multi engine that drives the requests, nil for a temporary engine
+/// @param arena The arena for the request allocation
+/// @param fields The indices of the fields within the payload
+/// @param results The results, one for every field, may be nil
+/// @param count The number of fields
+/// @return The first failed result, or a successful result if all requests succeeded
+AlpacaResult alpaca_device_sample_fields(AlpacaDevice *device,
+                                         HttpMulti *multi,
+                                         MemoryArena *arena,
+                                         usize const *fields,
+                                         AlpacaResult *results,
+                                         usize count);
+
+/// Refreshes all stale payload fields of the device concurrently, fresh fields are skipped
+/// @param device The alpaca device handle
+/// @param multi The multi engine that drives the requests, nil for a temporary engine
+/// @param arena The arena for the request allocation
+/// @return The first failed result, or a successful result if all requests succeeded
+AlpacaResult alpaca_device_sample(AlpacaDevice *device, HttpMulti *multi, MemoryArena *arena);
+
 /// Send an HTTP PUT request to the device
 /// @note It is extremely important to know that the response
 ///       must be destroyed by the caller.
@@ -186,7 +440,7 @@ void alpaca_device_list_make(AlpacaDeviceList *list);
 /// @param device The alpaca device
 void alpaca_device_list_append(AlpacaDeviceList *list, AlpacaDevice *device);
 
-/// Clears the device list
+/// Clears the device list and destroys the associated devices
 /// @param list The device list
 void alpaca_device_list_clear(AlpacaDeviceList *list);
 
@@ -199,4 +453,17 @@ void alpaca_device_list_reserve(AlpacaDeviceList *list, usize count);
 /// @param list The device list
 void alpaca_device_list_destroy(AlpacaDeviceList *list);
 
+/// Connects the devices concurrently, the readiness of every device is published as soon
+/// as its own requests are done
+/// @param devices The devices
+/// @param count The number of devices
+/// @param multi The multi engine that drives the requests, nil for a temporary engine
+void alpaca_device_connect_many(AlpacaDevice *devices, usize count, HttpMulti *multi);
+
+/// Connects all devices of the list concurrently, the readiness of every device is
+/// published as soon as its own requests are done
+/// @param list The device list
+/// @param multi The multi engine that drives the requests, nil for a temporary engine
+void alpaca_device_list_connect(AlpacaDeviceList *list, HttpMulti *multi);
+
 #endif// ASCOM_DEVICE_H
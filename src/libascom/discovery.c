@@ -0,0 +1,279 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CORE_PLATFORM_WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+typedef SOCKET DiscoverySocket;
+#define DISCOVERY_INVALID_SOCKET INVALID_SOCKET
+#define discovery_socket_close closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+typedef int DiscoverySocket;
+#define DISCOVERY_INVALID_SOCKET (-1)
+#define discovery_socket_close close
+#endif
+
+#include <libcore/arch/thread.h>
+#include <libcore/timer.h>
+
+#include "discovery.h"
+
+enum {
+    /// Time (ms) a receive blocks before the service checks its timers
+    ALPACA_DISCOVERY_RECEIVE_TIMEOUT = 50,
+
+    /// Size of the response buffer, responses are tiny JSON objects
+    ALPACA_DISCOVERY_BUFFER_SIZE = 512,
+};
+
+/// The request of the alpaca discovery protocol, version 1
+static const char alpaca_discovery_request[] = "alpacadiscovery1";
+
+struct AlpacaDiscovery {
+    AlpacaDiscoveryConfig config;
+    char address[64];
+    DiscoverySocket socket;
+
+    /// Monotonic time (ms) at which the service was started
+    f64 start;
+
+    /// Guards the cache and the flags
+    Mutex *mutex;
+    AlpacaServer servers[ALPACA_DISCOVERY_CAPACITY];
+    usize server_count;
+    b8 running;
+    b8 refresh;
+};
+
+/// Sends a discovery request to the configured address
+static void alpaca_discovery_send(AlpacaDiscovery *discovery) {
+    struct sockaddr_in target = { 0 };
+    target.sin_family = AF_INET;
+    target.sin_port = htons(discovery->config.port);
+    inet_pton(AF_INET, discovery->address, &target.sin_addr);
+    sendto(discovery->socket, alpaca_discovery_request, (int) strlen(alpaca_discovery_request), 0,
+           (struct sockaddr *) &target, sizeof target);
+}
+
+/// Extracts the port from a discovery response, returns zero for invalid responses
+static u16 alpaca_discovery_parse(const char *response) {
+    const char *key = strstr(response, "\"AlpacaPort\"");
+    if (key == nil) {
+        return 0;
+    }
+    const char *colon = strchr(key, ':');
+    if (colon == nil) {
+        return 0;
+    }
+    unsigned long port = strtoul(colon + 1, nil, 10);
+    return port > 0 && port <= 0xFFFF ? (u16) port : 0;
+}
+
+/// Caches a responding server, the oldest server makes room if the cache is full
+static void alpaca_discovery_cache(AlpacaDiscovery *discovery, const char *url, f64 now) {
+    mutex_lock(discovery->mutex);
+    usize slot = discovery->server_count;
+    for (usize i = 0; i < discovery->server_count; ++i) {
+        if (strcmp(discovery->servers[i].url, url) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == ALPACA_DISCOVERY_CAPACITY) {
+        slot = 0;
+        for (usize i = 1; i < discovery->server_count; ++i) {
+            if (discovery->servers[i].seen < discovery->servers[slot].seen) {
+                slot = i;
+            }
+        }
+    }
+    if (slot == discovery->server_count) {
+        discovery->server_count++;
+    }
+    snprintf(discovery->servers[slot].url, sizeof discovery->servers[slot].url, "%s", url);
+    discovery->servers[slot].seen = now;
+    mutex_unlock(discovery->mutex);
+}
+
+/// Drops the servers that stopped responding
+static void alpaca_discovery_expire(AlpacaDiscovery *discovery, f64 now) {
+    mutex_lock(discovery->mutex);
+    usize kept = 0;
+    for (usize i = 0; i < discovery->server_count; ++i) {
+        if (now - discovery->servers[i].seen < discovery->config.expiry) {
+            discovery->servers[kept++] = discovery->servers[i];
+        }
+    }
+    discovery->server_count = kept;
+    mutex_unlock(discovery->mutex);
+}
+
+/// Receives a single response and caches its server
+static void alpaca_discovery_receive(AlpacaDiscovery *discovery) {
+    char buffer[ALPACA_DISCOVERY_BUFFER_SIZE];
+    struct sockaddr_in source = { 0 };
+    socklen_t source_length = sizeof source;
+    int received = (int) recvfrom(discovery->socket, buffer, sizeof buffer - 1, 0, (struct sockaddr *) &source,
+                                  &source_length);
+    if (received <= 0) {
+        return;
+    }
+    buffer[received] = '\0';
+
+    u16 port = alpaca_discovery_parse(buffer);
+    char host[INET_ADDRSTRLEN] = { 0 };
+    if (port == 0 || inet_ntop(AF_INET, &source.sin_addr, host, sizeof host) == nil) {
+        return;
+    }
+
+    char url[64];
+    snprintf(url, sizeof url, "http://%s:%u", host, port);
+    alpaca_discovery_cache(discovery, url, timer_now());
+}
+
+/// Broadcasts requests in the configured interval and collects the responses, frees the
+/// service once it was stopped
+static void *alpaca_discovery_task(void *args) {
+    AlpacaDiscovery *discovery = (AlpacaDiscovery *) args;
+
+    f64 next = discovery->start;
+    for (;;) {
+        mutex_lock(discovery->mutex);
+        b8 running = discovery->running;
+        b8 refresh = discovery->refresh;
+        discovery->refresh = false;
+        mutex_unlock(discovery->mutex);
+        if (!running) {
+            break;
+        }
+
+        f64 now = timer_now();
+        if (refresh || now >= next) {
+            alpaca_discovery_send(discovery);
+            next = now + discovery->config.interval;
+        }
+        alpaca_discovery_receive(discovery);
+        alpaca_discovery_expire(discovery, timer_now());
+    }
+
+    discovery_socket_close(discovery->socket);
+#ifdef CORE_PLATFORM_WIN32
+    WSACleanup();
+#endif
+    mutex_free(discovery->mutex);
+    free(discovery);
+    return nil;
+}
+
+/// Starts the discovery service on a background thread
+AlpacaDiscovery *alpaca_discovery_start(AlpacaDiscoveryConfig const *config) {
+#ifdef CORE_PLATFORM_WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        return nil;
+    }
+#endif
+
+    DiscoverySocket udp = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (udp == DISCOVERY_INVALID_SOCKET) {
+#ifdef CORE_PLATFORM_WIN32
+        WSACleanup();
+#endif
+        return nil;
+    }
+
+    // Requests are broadcast, responses are awaited with a timeout so the thread can stop
+    int enable = 1;
+    setsockopt(udp, SOL_SOCKET, SO_BROADCAST, (const char *) &enable, sizeof enable);
+#ifdef CORE_PLATFORM_WIN32
+    DWORD timeout = ALPACA_DISCOVERY_RECEIVE_TIMEOUT;
+#else
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = ALPACA_DISCOVERY_RECEIVE_TIMEOUT * 1000 };
+#endif
+    setsockopt(udp, SOL_SOCKET, SO_RCVTIMEO, (const char *) &timeout, sizeof timeout);
+
+    AlpacaDiscovery *discovery = (AlpacaDiscovery *) calloc(1, sizeof(AlpacaDiscovery));
+    if (config != nil) {
+        discovery->config = *config;
+    }
+    if (discovery->config.port == 0) {
+        discovery->config.port = ALPACA_DISCOVERY_PORT;
+    }
+    if (discovery->config.interval == 0) {
+        discovery->config.interval = ALPACA_DISCOVERY_INTERVAL;
+    }
+    if (discovery->config.expiry == 0) {
+        discovery->config.expiry = ALPACA_DISCOVERY_EXPIRY;
+    }
+    const char *address = discovery->config.address != nil ? discovery->config.address : "255.255.255.255";
+    snprintf(discovery->address, sizeof discovery->address, "%s", address);
+    discovery->config.address = discovery->address;
+
+    discovery->socket = udp;
+    discovery->start = timer_now();
+    discovery->mutex = mutex_new();
+    discovery->running = true;
+    thread_create(alpaca_discovery_task, discovery);
+    return discovery;
+}
+
+/// Stops the discovery service, the service frees itself once its thread finished
+void alpaca_discovery_stop(AlpacaDiscovery *discovery) {
+    mutex_lock(discovery->mutex);
+    discovery->running = false;
+    mutex_unlock(discovery->mutex);
+}
+
+/// Sends a discovery request right away instead of waiting for the interval
+void alpaca_discovery_refresh(AlpacaDiscovery *discovery) {
+    mutex_lock(discovery->mutex);
+    discovery->refresh = true;
+    mutex_unlock(discovery->mutex);
+}
+
+/// Copies the cached servers, never blocks on the network
+usize alpaca_discovery_servers(AlpacaDiscovery *discovery, AlpacaServer *servers, usize capacity) {
+    mutex_lock(discovery->mutex);
+    usize count = discovery->server_count < capacity ? discovery->server_count : capacity;
+    for (usize i = 0; i < count; ++i) {
+        servers[i] = discovery->servers[i];
+    }
+    mutex_unlock(discovery->mutex);
+    return count;
+}
+
+/// Retrieves the time (ms) since the first discovery request was sent
+f64 alpaca_discovery_elapsed(AlpacaDiscovery *discovery) {
+    return timer_now() - discovery->start;
+}
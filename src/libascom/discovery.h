@@ -0,0 +1,95 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef ASCOM_DISCOVERY_H
+#define ASCOM_DISCOVERY_H
+
+#include <libcore/types.h>
+
+enum {
+    /// The UDP port of the alpaca discovery protocol
+    ALPACA_DISCOVERY_PORT = 32227,
+
+    /// The maximum number of servers that are cached
+    ALPACA_DISCOVERY_CAPACITY = 16,
+
+    /// Default interval (ms) in which discovery requests are broadcast
+    ALPACA_DISCOVERY_INTERVAL = 1000,
+
+    /// Default time (ms) after which servers that stopped responding are dropped
+    ALPACA_DISCOVERY_EXPIRY = 10000,
+};
+
+/// Configuration of the discovery service, zeroed fields take their defaults
+typedef struct AlpacaDiscoveryConfig {
+    /// The IPv4 address the requests are sent to, the limited broadcast address by default
+    const char *address;
+
+    /// The UDP port the requests are sent to
+    u16 port;
+
+    /// The interval (ms) in which requests are sent
+    u32 interval;
+
+    /// The time (ms) after which servers that stopped responding are dropped
+    u32 expiry;
+} AlpacaDiscoveryConfig;
+
+/// An alpaca server that responded to a discovery request
+typedef struct AlpacaServer {
+    /// The server URL, e.g. http://192.168.0.10:11111
+    char url[64];
+
+    /// Monotonic time (ms) of the last response
+    f64 seen;
+} AlpacaServer;
+
+/// Background service that broadcasts discovery requests and caches the responding servers
+typedef struct AlpacaDiscovery AlpacaDiscovery;
+
+/// Starts the discovery service on a background thread
+/// @param config The configuration, may be nil for the defaults
+/// @return The discovery service, nil if the socket could not be created
+AlpacaDiscovery *alpaca_discovery_start(AlpacaDiscoveryConfig const *config);
+
+/// Stops the discovery service, the service frees itself once its thread finished
+/// @param discovery The discovery service
+void alpaca_discovery_stop(AlpacaDiscovery *discovery);
+
+/// Sends a discovery request right away instead of waiting for the interval
+/// @param discovery The discovery service
+void alpaca_discovery_refresh(AlpacaDiscovery *discovery);
+
+/// Copies the cached servers, never blocks on the network
+/// @param discovery The discovery service
+/// @param servers The servers that will be set
+/// @param capacity The capacity of the servers
+/// @return The number of servers that were copied
+usize alpaca_discovery_servers(AlpacaDiscovery *discovery, AlpacaServer *servers, usize capacity);
+
+/// Retrieves the time (ms) since the first discovery request was sent
+/// @param discovery The discovery service
+/// @return The elapsed time in milliseconds
+f64 alpaca_discovery_elapsed(AlpacaDiscovery *discovery);
+
+#endif// ASCOM_DISCOVERY_H
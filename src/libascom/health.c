@@ -0,0 +1,105 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <math.h>
+
+#include "health.h"
+
+/// Weight of the latest latency within the moving average
+static const f64 ALPACA_HEALTH_LATENCY_WEIGHT = 0.2;
+
+/// Creates the health of a server that is assumed to be reachable
+void alpaca_health_make(AlpacaHealth *health) {
+    *health = (AlpacaHealth) { 0 };
+    health->state = ALPACA_HEALTH_CLOSED;
+    health->latency = -1.0;
+    health->backoff = ALPACA_HEALTH_BACKOFF_MIN;
+}
+
+/// Decides whether a request may be issued to the server
+b8 alpaca_health_allow(AlpacaHealth *health, f64 const now) {
+    switch (health->state) {
+        case ALPACA_HEALTH_CLOSED:
+            return true;
+        case ALPACA_HEALTH_OPEN:
+            if (now < health->retry) {
+                return false;
+            }
+            health->state = ALPACA_HEALTH_HALF_OPEN;
+            return true;
+        case ALPACA_HEALTH_HALF_OPEN:
+            break;
+    }
+    return false;
+}
+
+/// Opens the circuit, the next probe is issued once the backoff elapsed
+static void alpaca_health_open(AlpacaHealth *health, f64 const now) {
+    health->state = ALPACA_HEALTH_OPEN;
+    health->retry = now + health->backoff;
+}
+
+/// Records the outcome of a request
+void alpaca_health_record(AlpacaHealth *health, b8 const ok, f64 const latency, f64 const now) {
+    health->requests++;
+    if (ok) {
+        health->failures = 0;
+        health->state = ALPACA_HEALTH_CLOSED;
+        health->backoff = ALPACA_HEALTH_BACKOFF_MIN;
+        health->latency = health->latency < 0.0
+                                  ? latency
+                                  : health->latency + ALPACA_HEALTH_LATENCY_WEIGHT * (latency - health->latency);
+        return;
+    }
+
+    health->failed++;
+    health->failures++;
+    switch (health->state) {
+        case ALPACA_HEALTH_CLOSED:
+            if (health->failures >= ALPACA_HEALTH_FAILURE_THRESHOLD) {
+                alpaca_health_open(health, now);
+            }
+            break;
+        case ALPACA_HEALTH_HALF_OPEN:
+            // The probe failed, every further probe waits twice as long
+            health->backoff = fmin(2.0 * health->backoff, ALPACA_HEALTH_BACKOFF_MAX);
+            alpaca_health_open(health, now);
+            break;
+        case ALPACA_HEALTH_OPEN:
+            // Requests that were issued before the circuit opened do not extend the backoff
+            break;
+    }
+}
+
+/// Retrieves a string representation of the circuit breaker state
+const char *alpaca_health_state_to_string(AlpacaHealthState const state) {
+    switch (state) {
+        case ALPACA_HEALTH_CLOSED:
+            return "Healthy";
+        case ALPACA_HEALTH_OPEN:
+            return "Unreachable";
+        case ALPACA_HEALTH_HALF_OPEN:
+            return "Probing";
+    }
+    return "Unknown";
+}
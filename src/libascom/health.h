@@ -0,0 +1,99 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef ASCOM_HEALTH_H
+#define ASCOM_HEALTH_H
+
+#include <libcore/types.h>
+
+enum {
+    /// Consecutive failures after which the circuit of a server opens
+    ALPACA_HEALTH_FAILURE_THRESHOLD = 3,
+
+    /// Time (ms) until the first probe of an unreachable server
+    ALPACA_HEALTH_BACKOFF_MIN = 1000,
+
+    /// Upper bound (ms) of the time between two probes of an unreachable server
+    ALPACA_HEALTH_BACKOFF_MAX = 60000,
+};
+
+/// The circuit breaker state of a server
+typedef enum AlpacaHealthState {
+    /// The server responds, requests are issued as usual
+    ALPACA_HEALTH_CLOSED,
+
+    /// The server stopped responding, no requests are issued until the backoff elapsed
+    ALPACA_HEALTH_OPEN,
+
+    /// A single probe request is on its way, its outcome closes or reopens the circuit
+    ALPACA_HEALTH_HALF_OPEN,
+} AlpacaHealthState;
+
+/// Health of a single alpaca server, derived from the outcome of the requests to it
+typedef struct AlpacaHealth {
+    /// The circuit breaker state
+    AlpacaHealthState state;
+
+    /// Failures since the last successful request
+    u32 failures;
+
+    /// The number of recorded requests
+    u64 requests;
+
+    /// The number of recorded requests that failed
+    u64 failed;
+
+    /// Exponentially weighted moving average of the request latency (ms), negative until the first success
+    f64 latency;
+
+    /// Time (ms) between the current and the next probe
+    f64 backoff;
+
+    /// Monotonic time (ms) at which the next probe may be issued
+    f64 retry;
+} AlpacaHealth;
+
+/// Creates the health of a server that is assumed to be reachable
+/// @param health The health
+void alpaca_health_make(AlpacaHealth *health);
+
+/// Decides whether a request may be issued to the server, an open circuit becomes half-open
+/// once its backoff elapsed and lets exactly one probe pass
+/// @param health The health
+/// @param now The monotonic time in milliseconds
+/// @return Whether the request may be issued
+b8 alpaca_health_allow(AlpacaHealth *health, f64 now);
+
+/// Records the outcome of a request
+/// @param health The health
+/// @param ok Whether the server responded, alpaca errors count as responses
+/// @param latency The duration of the request in milliseconds
+/// @param now The monotonic time in milliseconds
+void alpaca_health_record(AlpacaHealth *health, b8 ok, f64 latency, f64 now);
+
+/// Retrieves a string representation of the circuit breaker state
+/// @param state The state
+/// @return String representation of the state
+const char *alpaca_health_state_to_string(AlpacaHealthState state);
+
+#endif// ASCOM_HEALTH_H
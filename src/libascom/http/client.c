@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include <libascom/http/client.h>
+#include <libascom/utils/cJSON_Helper.h>
 #include <libcore/arch/thread.h>
 #include <libcore/types.h>
 
@@ -35,6 +36,21 @@ static Mutex *http_share_locks[CURL_LOCK_DATA_LAST];
 /// Global curl share instance
 static CURLSH *http_share_handle = nil;
 
+enum {
+    HTTP_HANDLE_POOL_CAPACITY = 32
+};
+
+/// Pool of idle easy handles, recycling them keeps the handle allocation
+/// and the option set out of the per-request cost
+typedef struct HttpHandlePool {
+    Mutex *mutex;
+    CURL *handles[HTTP_HANDLE_POOL_CAPACITY];
+    usize count;
+} HttpHandlePool;
+
+/// Global easy handle pool
+static HttpHandlePool http_handle_pool = { 0 };
+
 /// CURL share lock function
 static void http_client_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *user) {
     mutex_lock(http_share_locks[data]);
@@ -47,6 +63,9 @@ static void http_client_unlock(CURL *handle, curl_lock_data data, void *user) {
 
 /// Initializes the HTTP client
 void http_client_init() {
+    // Parsed responses live in the request arena
+    cJSON_InitArenaHooks();
+
     for (u8 i = 0; i < CURL_LOCK_DATA_LAST; ++i) {
         http_share_locks[i] = mutex_new();
     }
@@ -57,10 +76,20 @@ void http_client_init() {
     curl_share_setopt(http_share_handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
     curl_share_setopt(http_share_handle, CURLSHOPT_LOCKFUNC, http_client_lock);
     curl_share_setopt(http_share_handle, CURLSHOPT_UNLOCKFUNC, http_client_unlock);
+
+    http_handle_pool.mutex = mutex_new();
+    http_handle_pool.count = 0;
 }
 
 /// Destroys the HTTP client
 void http_client_destroy() {
+    // Pooled handles still reference the share, so they have to go first
+    for (usize i = 0; i < http_handle_pool.count; ++i) {
+        curl_easy_cleanup(http_handle_pool.handles[i]);
+    }
+    http_handle_pool.count = 0;
+    mutex_free(http_handle_pool.mutex);
+
     curl_share_cleanup(http_share_handle);
     http_share_handle = nil;
     for (u8 i = 0; i < CURL_LOCK_DATA_LAST; ++i) {
@@ -85,15 +114,11 @@ const char *http_response_code_to_string(HttpResponseCode code) {
     return "";
 }
 
-/// CURL write function for the HttpClient
+/// CURL write function for the HttpClient, streams the data straight into the arena
 static size_t http_client_write(char *const buffer, size_t const size, size_t const member_size, void *out_stream) {
-    StringBuffer *out = (StringBuffer *) out_stream;
+    StringBuilder *out = (StringBuilder *) out_stream;
     size_t const curl_length = size * member_size;
-    char *tmp = realloc(out->data, out->size + curl_length);
-    ASSERT(tmp != nil, "[http] could not allocate write buffer!")
-    out->data = tmp;
-    memcpy(out->data + out->size, buffer, curl_length);
-    out->size += (ssize) curl_length;
+    string_builder_append(out, buffer, (ssize) curl_length);
     return curl_length;
 }
 
@@ -101,65 +126,130 @@ static size_t http_client_write(char *const buffer, size_t const size, size_t co
 static size_t http_client_read(char *buffer, size_t size, size_t member_size, void *in_stream) {
     StringView *in = (StringView *) in_stream;
     size_t curl_length = size * member_size;
-    size_t length = (in->length < curl_length) ? in->length : curl_length;
+    size_t length = ((size_t) in->length < curl_length) ? (size_t) in->length : curl_length;
     memcpy(buffer, in->data, length);
     in->data += length;
-    in->length += (ssize) length;
+    in->length -= (ssize) length;
     return length;
 }
 
-/// Performs a HTTP GET request and retrieves the response
-b8 http_client_get(HttpResponse *response, MemoryArena *arena, const char *url) {
-    CURL *curl = curl_easy_init();
-    if (curl == nil) {
-        return false;
-    }
-
+/// Applies the options that are common to every request
+static void http_client_prepare(CURL *curl) {
     // Use the shared handle for connection reuse
     curl_easy_setopt(curl, CURLOPT_SHARE, http_share_handle);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, http_client_write);
     curl_easy_setopt(curl, CURLOPT_READFUNCTION, http_client_read);
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
 
-    StringBuffer header_buffer = { 0 }, body_buffer = { 0 };
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &header_buffer);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body_buffer);
+    // Keep idle connections to the alpaca server warm between samples
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
 
-    CURLcode result = curl_easy_perform(curl);
-    if (result != CURLE_OK) {
-        free(header_buffer.data);
-        free(body_buffer.data);
+    // Requests to a server that went away fail quickly instead of pinning their caller
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, (long) HTTP_CONNECT_TIMEOUT);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long) HTTP_TIMEOUT);
+}
+
+/// Acquires a prepared easy handle from the handle pool
+CURL *http_client_acquire(void) {
+    CURL *curl = nil;
+    mutex_lock(http_handle_pool.mutex);
+    if (http_handle_pool.count > 0) {
+        http_handle_pool.count--;
+        curl = http_handle_pool.handles[http_handle_pool.count];
+    }
+    mutex_unlock(http_handle_pool.mutex);
+
+    if (curl == nil) {
+        curl = curl_easy_init();
+        if (curl != nil) {
+            http_client_prepare(curl);
+        }
+    }
+    return curl;
+}
+
+/// Resets the easy handle and returns it to the handle pool
+void http_client_release(CURL *curl) {
+    curl_easy_reset(curl);
+    http_client_prepare(curl);
+
+    mutex_lock(http_handle_pool.mutex);
+    if (http_handle_pool.count < HTTP_HANDLE_POOL_CAPACITY) {
+        http_handle_pool.handles[http_handle_pool.count] = curl;
+        http_handle_pool.count++;
+        curl = nil;
+    }
+    mutex_unlock(http_handle_pool.mutex);
+
+    // The pool is saturated, there is no point in keeping the handle
+    if (curl != nil) {
         curl_easy_cleanup(curl);
-        return false;
     }
+}
 
-    String header = string_new(arena, header_buffer.data, header_buffer.size);
-    free(header_buffer.data);
+/// Sets up the capture of the response into the arena
+static void http_client_capture(CURL *curl,
+                                MemoryArena *arena,
+                                HttpFlags flags,
+                                StringBuilder *header,
+                                StringBuilder *body) {
+    string_builder_make(body, arena, HTTP_BODY_CAPACITY);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, body);
+
+    // Without header data, curl discards the header entirely
+    if (flags & HTTP_FLAGS_HEADER) {
+        string_builder_make(header, arena, HTTP_HEADER_CAPACITY);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, header);
+    }
+}
 
-    String body = string_new(arena, body_buffer.data, body_buffer.size);
-    free(body_buffer.data);
+/// Finishes a request by filling the response and returning the handle to the pool
+static b8 http_client_finish(HttpResponse *response,
+                             CURL *curl,
+                             CURLcode result,
+                             StringBuilder const *header,
+                             StringBuilder const *body) {
+    if (result != CURLE_OK) {
+        http_client_release(curl);
+        return false;
+    }
 
     long response_code;
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    curl_easy_cleanup(curl);
-    *response = (HttpResponse) { .code = response_code, .header = header, .body = body };
+    http_client_release(curl);
+    *response = (HttpResponse) {
+        .code = response_code,
+        .header = string_builder_string(header),
+        .body = string_builder_string(body),
+    };
     return true;
 }
 
+/// Performs a HTTP GET request and retrieves the response
+b8 http_client_get(HttpResponse *response, MemoryArena *arena, const char *url, HttpFlags flags) {
+    CURL *curl = http_client_acquire();
+    if (curl == nil) {
+        return false;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+
+    StringBuilder header = { 0 }, body = { 0 };
+    http_client_capture(curl, arena, flags, &header, &body);
+
+    CURLcode result = curl_easy_perform(curl);
+    return http_client_finish(response, curl, result, &header, &body);
+}
+
 
 /// Performs a HTTP PUT request and retrieves the response
-b8 http_client_put(HttpResponse *response, MemoryArena *arena, const char *url, StringView *data) {
-    CURL *curl = curl_easy_init();
+b8 http_client_put(HttpResponse *response, MemoryArena *arena, const char *url, StringView *data, HttpFlags flags) {
+    CURL *curl = http_client_acquire();
     if (curl == nil) {
         return false;
     }
 
-    // Use the shared handle for connection reuse
-    curl_easy_setopt(curl, CURLOPT_SHARE, http_share_handle);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, http_client_write);
-    curl_easy_setopt(curl, CURLOPT_READFUNCTION, http_client_read);
-
     struct curl_slist *headers = nil;
     headers = curl_slist_append(headers, "Content-Type: application/json");
     curl_easy_setopt(curl, CURLOPT_URL, url);
@@ -168,30 +258,12 @@ b8 http_client_put(HttpResponse *response, MemoryArena *arena, const char *url,
     curl_easy_setopt(curl, CURLOPT_INFILESIZE, (long) data->length);
     curl_easy_setopt(curl, CURLOPT_READDATA, data);
 
-    StringBuffer header_buffer = { 0 }, body_buffer = { 0 };
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &header_buffer);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body_buffer);
+    StringBuilder header = { 0 }, body = { 0 };
+    http_client_capture(curl, arena, flags, &header, &body);
 
     CURLcode result = curl_easy_perform(curl);
     curl_slist_free_all(headers);
-    if (result != CURLE_OK) {
-        free(header_buffer.data);
-        free(body_buffer.data);
-        curl_easy_cleanup(curl);
-        return false;
-    }
-
-    String const header = string_new(arena, header_buffer.data, header_buffer.size);
-    free(header_buffer.data);
-
-    String const body = string_new(arena, body_buffer.data, body_buffer.size);
-    free(body_buffer.data);
-
-    long response_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    curl_easy_cleanup(curl);
-    *response = (HttpResponse) { .code = response_code, .header = header, .body = body };
-    return true;
+    return http_client_finish(response, curl, result, &header, &body);
 }
 
 typedef struct HttpForm {
@@ -228,17 +300,21 @@ static void http_form_destroy(HttpForm *form) {
     curl_mime_free(form->mime);
 }
 
+/// Builds multipart form data from the members of a JSON object
+curl_mime *http_client_form_make(CURL *curl, cJSON *form) {
+    HttpForm form_data = { 0 };
+    http_form_make(&form_data, curl);
+    http_form_add_json(&form_data, form);
+    return form_data.mime;
+}
+
 /// Performs a HTTP PUT request with form data and retrieves the response
-b8 http_client_put_form(HttpResponse *response, MemoryArena *arena, const char *url, cJSON *form) {
-    CURL *curl = curl_easy_init();
+b8 http_client_put_form(HttpResponse *response, MemoryArena *arena, const char *url, cJSON *form, HttpFlags flags) {
+    CURL *curl = http_client_acquire();
     if (curl == nil) {
         return false;
     }
 
-    // Use the shared handle for connection reuse
-    curl_easy_setopt(curl, CURLOPT_SHARE, http_share_handle);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, http_client_write);
-    curl_easy_setopt(curl, CURLOPT_READFUNCTION, http_client_read);
     curl_easy_setopt(curl, CURLOPT_URL, url);
     curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
 
@@ -251,30 +327,11 @@ b8 http_client_put_form(HttpResponse *response, MemoryArena *arena, const char *
     headers = curl_slist_append(headers, "Content-Type: multipart/form-data");
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 
-    StringBuffer header_buffer = { 0 }, body_buffer = { 0 };
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &header_buffer);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body_buffer);
+    StringBuilder header = { 0 }, body = { 0 };
+    http_client_capture(curl, arena, flags, &header, &body);
 
     CURLcode result = curl_easy_perform(curl);
-    if (result != CURLE_OK) {
-        free(header_buffer.data);
-        free(body_buffer.data);
-        http_form_destroy(&form_data);
-        curl_easy_cleanup(curl);
-        return false;
-    }
-
     http_form_destroy(&form_data);
-
-    String header = string_new(arena, header_buffer.data, header_buffer.size);
-    free(header_buffer.data);
-
-    String body = string_new(arena, body_buffer.data, body_buffer.size);
-    free(body_buffer.data);
-
-    long response_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    curl_easy_cleanup(curl);
-    *response = (HttpResponse){ .code = response_code, .header = header, .body = body };
-    return true;
-}
\ No newline at end of file
+    curl_slist_free_all(headers);
+    return http_client_finish(response, curl, result, &header, &body);
+}
@@ -41,6 +41,28 @@ typedef enum HttpResponseCode {
 /// @return String representation of the response code
 const char *http_response_code_to_string(HttpResponseCode code);
 
+enum {
+    /// Initial capacity of the response body, which fits a typical alpaca response
+    HTTP_BODY_CAPACITY = 512,
+
+    /// Initial capacity of the response header
+    HTTP_HEADER_CAPACITY = 512,
+
+    /// Time (ms) a request may take to establish its connection, an unreachable
+    /// server would otherwise block for the system default of minutes
+    HTTP_CONNECT_TIMEOUT = 1000,
+
+    /// Time (ms) a request may take in total
+    HTTP_TIMEOUT = 3000,
+};
+
+typedef enum HttpFlags {
+    HTTP_FLAGS_NONE = 0,
+
+    /// Captures the response header, which is skipped otherwise
+    HTTP_FLAGS_HEADER = 1 << 0,
+} HttpFlags;
+
 typedef struct HttpResponse {
     String body;
     String header;
@@ -48,29 +70,49 @@ typedef struct HttpResponse {
 } HttpResponse;
 
 /// Initializes the HTTP client
+/// @note This installs the cJSON arena hooks, so it must be called before any cJSON allocation
 void http_client_init(void);
 
 /// Destroys the HTTP client
 void http_client_destroy(void);
 
+/// Acquires a prepared easy handle from the handle pool
+/// @return An easy handle, nil if no handle could be created
+///
+/// @note The handle must be returned with http_client_release
+CURL *http_client_acquire(void);
+
+/// Resets the easy handle and returns it to the handle pool
+/// @param curl The easy handle
+void http_client_release(CURL *curl);
+
 /// Performs a HTTP GET request and retrieves the response
 /// @param response The HTTP response (text and code)
 /// @param arena The arena for allocating the response string
 /// @param url The HTTP url for the request
-b8 http_client_get(HttpResponse *response, MemoryArena *arena, const char *url);
+/// @param flags Flags that control the capture of the response
+b8 http_client_get(HttpResponse *response, MemoryArena *arena, const char *url, HttpFlags flags);
 
 /// Performs a HTTP PUT request and retrieves the response
 /// @param response The HTTP response (text and code)
 /// @param arena The arena for allocating the response string
 /// @param url The HTTP url for the request
 /// @param data The data to send
-b8 http_client_put(HttpResponse *response, MemoryArena *arena, const char *url, StringView *data);
+/// @param flags Flags that control the capture of the response
+b8 http_client_put(HttpResponse *response, MemoryArena *arena, const char *url, StringView *data, HttpFlags flags);
 
 /// Performs a HTTP PUT request with form data and retrieves the response
 /// @param response The HTTP response (text and code)
 /// @param arena The arena for allocating the response string
 /// @param url The HTTP url for the request
 /// @param form The form-data to send
-b8 http_client_put_form(HttpResponse *response, MemoryArena *arena, const char *url, cJSON *form);
+/// @param flags Flags that control the capture of the response
+b8 http_client_put_form(HttpResponse *response, MemoryArena *arena, const char *url, cJSON *form, HttpFlags flags);
+
+/// Builds multipart form data from the members of a JSON object
+/// @param curl The easy handle the form is sent with
+/// @param form The JSON object
+/// @return The form data, which must be freed with curl_mime_free once the transfer is done
+curl_mime *http_client_form_make(CURL *curl, cJSON *form);
 
 #endif// ASCOM_HTTP_CLIENT_H
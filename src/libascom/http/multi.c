@@ -0,0 +1,197 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <libascom/http/multi.h>
+
+/// Links the request into the pending list
+static void http_multi_link(HttpMulti *multi, HttpRequest *request) {
+    request->previous = nil;
+    request->next = multi->pending;
+    if (multi->pending != nil) {
+        multi->pending->previous = request;
+    }
+    multi->pending = request;
+    multi->pending_count++;
+}
+
+/// Unlinks the request from the pending list
+static void http_multi_unlink(HttpMulti *multi, HttpRequest *request) {
+    if (request->previous != nil) {
+        request->previous->next = request->next;
+    } else {
+        multi->pending = request->next;
+    }
+    if (request->next != nil) {
+        request->next->previous = request->previous;
+    }
+    request->previous = nil;
+    request->next = nil;
+    multi->pending_count--;
+}
+
+/// Frees the form data and the headers of a PUT request
+static void http_multi_free_form(HttpRequest *request) {
+    if (request->form != nil) {
+        curl_mime_free(request->form);
+        request->form = nil;
+    }
+    if (request->headers != nil) {
+        curl_slist_free_all(request->headers);
+        request->headers = nil;
+    }
+}
+
+/// Detaches the easy handle from the request and hands it back to the pool
+static void http_multi_detach(HttpMulti *multi, HttpRequest *request) {
+    http_multi_unlink(multi, request);
+    curl_multi_remove_handle(multi->handle, request->curl);
+    http_client_release(request->curl);
+    request->curl = nil;
+    http_multi_free_form(request);
+}
+
+/// Finishes the request once curl reports that the transfer is done
+static void http_multi_finish(HttpMulti *multi, HttpRequest *request, CURLcode result) {
+    if (result == CURLE_OK) {
+        long response_code = 0;
+        curl_easy_getinfo(request->curl, CURLINFO_RESPONSE_CODE, &response_code);
+        request->response.code = (HttpResponseCode) response_code;
+        request->response.body = string_builder_string(&request->body);
+        request->ok = true;
+    }
+
+    http_multi_detach(multi, request);
+    request->done = true;
+}
+
+/// Reads all completion messages from curl
+static void http_multi_collect(HttpMulti *multi) {
+    CURLMsg *message = nil;
+    s32 queued = 0;
+    while ((message = curl_multi_info_read(multi->handle, &queued)) != nil) {
+        if (message->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        HttpRequest *request = nil;
+        curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, (char **) &request);
+        if (request != nil) {
+            http_multi_finish(multi, request, message->data.result);
+        }
+    }
+}
+
+/// Creates a new multi engine
+void http_multi_make(HttpMulti *multi) {
+    multi->handle = curl_multi_init();
+    multi->pending = nil;
+    multi->pending_count = 0;
+    curl_multi_setopt(multi->handle, CURLMOPT_MAX_HOST_CONNECTIONS, (long) HTTP_MULTI_MAX_HOST_CONNECTIONS);
+}
+
+/// Destroys the multi engine, pending requests are aborted
+void http_multi_destroy(HttpMulti *multi) {
+    while (multi->pending != nil) {
+        HttpRequest *request = multi->pending;
+        http_multi_detach(multi, request);
+        request->done = true;
+    }
+    curl_multi_cleanup(multi->handle);
+    multi->handle = nil;
+}
+
+/// Allocates a request and acquires its easy handle, the request is done if no handle is available
+static HttpRequest *http_multi_request_make(MemoryArena *arena, const char *url) {
+    HttpRequest *request = (HttpRequest *) memory_arena_alloc(arena, sizeof(HttpRequest));
+    *request = (HttpRequest) { 0 };
+    request->arena = arena;
+
+    request->curl = http_client_acquire();
+    if (request->curl == nil) {
+        request->done = true;
+        return request;
+    }
+    curl_easy_setopt(request->curl, CURLOPT_URL, url);
+    return request;
+}
+
+/// Adds the request to the multi handle, the request is done if that fails
+static HttpRequest *http_multi_request_add(HttpMulti *multi, HttpRequest *request) {
+    string_builder_make(&request->body, request->arena, HTTP_BODY_CAPACITY);
+    curl_easy_setopt(request->curl, CURLOPT_WRITEDATA, &request->body);
+    curl_easy_setopt(request->curl, CURLOPT_PRIVATE, (void *) request);
+
+    if (curl_multi_add_handle(multi->handle, request->curl) != CURLM_OK) {
+        http_client_release(request->curl);
+        request->curl = nil;
+        http_multi_free_form(request);
+        request->done = true;
+        return request;
+    }
+
+    http_multi_link(multi, request);
+    return request;
+}
+
+/// Submits a HTTP GET request, the transfer is driven by polling
+HttpRequest *http_multi_submit_get(HttpMulti *multi, MemoryArena *arena, const char *url) {
+    HttpRequest *request = http_multi_request_make(arena, url);
+    if (request->done) {
+        return request;
+    }
+
+    curl_easy_setopt(request->curl, CURLOPT_HTTPGET, 1L);
+    return http_multi_request_add(multi, request);
+}
+
+/// Submits a HTTP PUT request with form data, the transfer is driven by polling
+HttpRequest *http_multi_submit_put_form(HttpMulti *multi, MemoryArena *arena, const char *url, cJSON *form) {
+    HttpRequest *request = http_multi_request_make(arena, url);
+    if (request->done) {
+        return request;
+    }
+
+    curl_easy_setopt(request->curl, CURLOPT_CUSTOMREQUEST, "PUT");
+    request->form = http_client_form_make(request->curl, form);
+    curl_easy_setopt(request->curl, CURLOPT_MIMEPOST, request->form);
+    request->headers = curl_slist_append(nil, "Content-Type: multipart/form-data");
+    curl_easy_setopt(request->curl, CURLOPT_HTTPHEADER, request->headers);
+    return http_multi_request_add(multi, request);
+}
+
+/// Drives all pending transfers and waits for activity for at most the specified time
+usize http_multi_poll(HttpMulti *multi, s32 timeout) {
+    s32 running = 0;
+    curl_multi_perform(multi->handle, &running);
+    http_multi_collect(multi);
+
+    if (multi->pending_count > 0 && timeout > 0) {
+        curl_multi_poll(multi->handle, nil, 0, timeout, nil);
+    }
+    return multi->pending_count;
+}
+
+/// Drives all pending transfers until every request is done
+void http_multi_complete(HttpMulti *multi) {
+    while (http_multi_poll(multi, HTTP_MULTI_POLL_TIMEOUT) > 0) { }
+}
@@ -0,0 +1,122 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef ASCOM_HTTP_MULTI_H
+#define ASCOM_HTTP_MULTI_H
+
+#include <curl/curl.h>
+#include <libcore/string.h>
+
+#include "client.h"
+
+enum {
+    /// Upper bound of parallel connections to a single alpaca server
+    HTTP_MULTI_MAX_HOST_CONNECTIONS = 16,
+
+    /// Milliseconds to wait for socket activity per poll
+    HTTP_MULTI_POLL_TIMEOUT = 100,
+};
+
+typedef struct HttpRequest HttpRequest;
+
+/// A request that was submitted to the multi engine, it lives inside the
+/// arena that was provided on submission
+typedef struct HttpRequest {
+    /// Intrusive list of pending requests
+    HttpRequest *previous;
+    HttpRequest *next;
+
+    /// The easy handle, nil once the request is complete
+    CURL *curl;
+
+    /// The arena for allocating the response
+    MemoryArena *arena;
+
+    /// The form data and the headers of PUT requests, nil otherwise
+    curl_mime *form;
+    struct curl_slist *headers;
+
+    /// The response body, which is received directly into the arena
+    StringBuilder body;
+
+    /// The response, valid once the request is complete and ok
+    HttpResponse response;
+
+    /// Whether the transfer has finished
+    b8 done;
+
+    /// Whether the transfer has finished successfully
+    b8 ok;
+} HttpRequest;
+
+/// The multi engine drives many transfers concurrently on the calling thread
+typedef struct HttpMulti {
+    /// The curl multi handle
+    CURLM *handle;
+
+    /// Pending requests
+    HttpRequest *pending;
+
+    /// Number of pending requests
+    usize pending_count;
+} HttpMulti;
+
+/// Creates a new multi engine
+/// @param multi The multi engine handle
+void http_multi_make(HttpMulti *multi);
+
+/// Destroys the multi engine, pending requests are aborted
+/// @param multi The multi engine handle
+void http_multi_destroy(HttpMulti *multi);
+
+/// Submits a HTTP GET request, the transfer is driven by polling
+/// and the response header is not captured
+/// @param multi The multi engine handle
+/// @param arena The arena for allocating the request and its response
+/// @param url The HTTP url for the request
+/// @return The submitted request, never nil
+///
+/// @note If the request could not be submitted, it is returned as done but not ok
+HttpRequest *http_multi_submit_get(HttpMulti *multi, MemoryArena *arena, const char *url);
+
+/// Submits a HTTP PUT request with form data, the transfer is driven by polling
+/// @param multi The multi engine handle
+/// @param arena The arena for allocating the request and its response
+/// @param url The HTTP url for the request
+/// @param form The form-data to send, it is copied on submission
+/// @return The submitted request, never nil
+///
+/// @note If the request could not be submitted, it is returned as done but not ok
+HttpRequest *http_multi_submit_put_form(HttpMulti *multi, MemoryArena *arena, const char *url, cJSON *form);
+
+/// Drives all pending transfers and waits for activity for at most the specified time
+/// @param multi The multi engine handle
+/// @param timeout The maximum time to wait in milliseconds
+/// @return The number of requests that are still pending
+usize http_multi_poll(HttpMulti *multi, s32 timeout);
+
+/// Drives all pending transfers until every request is done
+/// @param multi The multi engine handle
+void http_multi_complete(HttpMulti *multi);
+
+#endif// ASCOM_HTTP_MULTI_H
@@ -25,98 +25,75 @@
 
 /// Tries to retrieve the average time period (hours) over which observations are averaged
 AlpacaResult alpaca_observing_conds_average_period(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "averageperiod", value);
-    device->payload.average_period = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "averageperiod", value);
 }
 
 /// Tries to retrieve the amount of by cloud obscured sky (0.0 to 1.0)
 AlpacaResult alpaca_observing_conds_cloud_cover(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "cloudcover", value);
-    device->payload.cloud_cover = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "cloudcover", value);
 }
 
 /// Tries to retrieve the atmospheric dew point temperature (°C) at the observatory
 AlpacaResult alpaca_observing_conds_dew_point(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "dewpoint", value);
-    device->payload.dew_point = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "dewpoint", value);
 }
 
 /// Tries to retrieve the atmospheric relative humidity (0 to 100%) at the observatory
 AlpacaResult alpaca_observing_conds_humidity(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "humidity", value);
-    device->payload.humidity = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "humidity", value);
 }
 
 /// Tries to retrieve the atmospheric pressure (hPa) at the observatory
 AlpacaResult alpaca_observing_conds_pressure(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "pressure", value);
-    device->payload.pressure = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "pressure", value);
 }
 
 /// Tries to retrieve the rain rate (mm/hr) at the observatory
 AlpacaResult alpaca_observing_conds_rain_rate(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "rainrate", value);
-    device->payload.rain_rate = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "rainrate", value);
 }
 
 /// Tries to retrieve the sky brightness (lux) at the observatory
 AlpacaResult alpaca_observing_conds_sky_brightness(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "skybrightness", value);
-    device->payload.sky_brightness = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "skybrightness", value);
 }
 
 /// Tries to retrieve the sky quality (mag per sq-arcsec) at the observatory
 AlpacaResult alpaca_observing_conds_sky_quality(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "skyquality", value);
-    device->payload.sky_quality = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "skyquality", value);
 }
 
 /// Tries to retrieve the sky temperature (°C) at the observatory
 AlpacaResult alpaca_observing_conds_sky_temperature(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "skytemperature", value);
-    device->payload.sky_temperature = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "skytemperature", value);
 }
 
 /// Tries to retrieve the seeting at the observatory measured as star full width half maximum (arcsec)
 AlpacaResult alpaca_observing_conds_star_fwhm(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "starfwhm", value);
-    device->payload.star_fwhm = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "starfwhm", value);
 }
 
 /// Tries to retrieve the temperature (°C) at the observatory
 AlpacaResult alpaca_observing_conds_temperature(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "temperature", value);
-    device->payload.temperature = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "temperature", value);
 }
 
 /// Tries to retrieve the wind direction (°) at the observatory
 AlpacaResult alpaca_observing_conds_wind_direction(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "winddirection", value);
-    device->payload.wind_direction = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "winddirection", value);
 }
 
 /// Tries to retrieve the peak three second wind gust (m/s) at the observatory over the last two minutes
 AlpacaResult alpaca_observing_conds_wind_gust(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "windgust", value);
-    device->payload.wind_gust = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "windgust", value);
 }
 
 /// Tries to retrieve the wind speed (m/s) at the observatory
 AlpacaResult alpaca_observing_conds_wind_speed(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult result = alpaca_device_get_f64(device, arena, "windspeed", value);
-    device->payload.wind_speed = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "windspeed", value);
+}
+
+/// Samples all stale observing conditions at once and stores them in the device payload
+AlpacaResult alpaca_observing_conds_sample(AlpacaDevice *device, HttpMulti *multi, MemoryArena *arena) {
+    return alpaca_device_sample(device, multi, arena);
 }
@@ -124,4 +124,11 @@ AlpacaResult alpaca_observing_conds_wind_gust(AlpacaDevice *device, MemoryArena
 /// @return A result
 AlpacaResult alpaca_observing_conds_wind_speed(AlpacaDevice *device, MemoryArena *arena, f64 *value);
 
+/// Samples all stale observing conditions at once and stores them in the device payload
+/// @param device The observing conditions device
+/// @param multi The multi engine that drives the requests, nil for a temporary engine
+/// @param arena The memory arena for the requests
+/// @return The first failed result, or a successful result if all requests succeeded
+AlpacaResult alpaca_observing_conds_sample(AlpacaDevice *device, HttpMulti *multi, MemoryArena *arena);
+
 #endif// ASCOM_OBSERVING_CONDITIONS_H
@@ -21,18 +21,327 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <stdlib.h>
+
 #include "telescope.h"
 
+#include <libcore/arch/thread.h>
+#include <solaris/arena.h>
+
+enum {
+    /// The maximum number of pending commands
+    ALPACA_TELESCOPE_QUEUE_CAPACITY = 64,
+};
+
 /// Tries to retrieve the mount's current altitude (°) above the horizon
 AlpacaResult alpaca_telescope_altitude(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult const result = alpaca_device_get_f64(device, arena, "altitude", value);
-    device->payload.altitude = *value;
-    return result;
+    return alpaca_device_get_cached_f64(device, arena, "altitude", value);
 }
 
 /// Tries to retrieve the mount's current azimuth (°)
 AlpacaResult alpaca_telescope_azimuth(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
-    AlpacaResult const result = alpaca_device_get_f64(device, arena, "azimuth", value);
-    device->payload.azimuth = *value;
+    return alpaca_device_get_cached_f64(device, arena, "azimuth", value);
+}
+
+/// Samples the mount's stale position at once and stores it in the device payload
+AlpacaResult alpaca_telescope_sample(AlpacaDevice *device, HttpMulti *multi, MemoryArena *arena) {
+    return alpaca_device_sample(device, multi, arena);
+}
+
+/// Tries to retrieve the mount's current right ascension (hours) in the equatorial system of the mount
+AlpacaResult alpaca_telescope_right_ascension(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
+    return alpaca_device_get_cached_f64(device, arena, "rightascension", value);
+}
+
+/// Tries to retrieve the mount's current declination (°) in the equatorial system of the mount
+AlpacaResult alpaca_telescope_declination(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
+    return alpaca_device_get_cached_f64(device, arena, "declination", value);
+}
+
+/// Tries to retrieve the local apparent sidereal time (hours) of the mount
+AlpacaResult alpaca_telescope_sidereal_time(AlpacaDevice *device, MemoryArena *arena, f64 *value) {
+    return alpaca_device_get_cached_f64(device, arena, "siderealtime", value);
+}
+
+/// Retrieves a boolean payload attribute, which is stored as zero or one
+static AlpacaResult alpaca_telescope_get_cached_bool(AlpacaDevice *device,
+                                                     MemoryArena *arena,
+                                                     const char *attribute,
+                                                     b8 *value) {
+    f64 number = 0.0;
+    AlpacaResult result = alpaca_device_get_cached_f64(device, arena, attribute, &number);
+    *value = number > 0.5;
+    return result;
+}
+
+/// Tries to retrieve whether the mount is tracking
+AlpacaResult alpaca_telescope_tracking(AlpacaDevice *device, MemoryArena *arena, b8 *value) {
+    return alpaca_telescope_get_cached_bool(device, arena, "tracking", value);
+}
+
+/// Tries to retrieve whether the mount is slewing
+AlpacaResult alpaca_telescope_slewing(AlpacaDevice *device, MemoryArena *arena, b8 *value) {
+    return alpaca_telescope_get_cached_bool(device, arena, "slewing", value);
+}
+
+/// Tries to retrieve whether the mount is parked
+AlpacaResult alpaca_telescope_at_park(AlpacaDevice *device, MemoryArena *arena, b8 *value) {
+    return alpaca_telescope_get_cached_bool(device, arena, "atpark", value);
+}
+
+/// Tries to retrieve the geometry of the mount
+AlpacaResult alpaca_telescope_alignment_mode(AlpacaDevice *device, MemoryArena *arena, AlpacaAlignmentMode *value) {
+    s64 mode = 0;
+    AlpacaResult result = alpaca_device_get_s64(device, arena, "alignmentmode", &mode);
+    *value = (AlpacaAlignmentMode) mode;
     return result;
 }
+
+/// Sends a PUT request and frees its data
+static AlpacaResult alpaca_telescope_put(AlpacaDevice *device, MemoryArena *arena, const char *attribute, cJSON *data) {
+    AlpacaResponse response = alpaca_device_put(device, arena, attribute, data);
+    cJSON_Delete(data);
+    AlpacaResult result = response.result;
+    alpaca_response_destroy(&response);
+    return result;
+}
+
+/// Turns tracking of the mount on or off
+AlpacaResult alpaca_telescope_update_tracking(AlpacaDevice *device, MemoryArena *arena, b8 value) {
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddBoolToObject(data, "Tracking", value);
+    return alpaca_telescope_put(device, arena, "tracking", data);
+}
+
+/// Starts a slew to the specified equatorial coordinates and returns immediately
+AlpacaResult alpaca_telescope_slew_to_coordinates_async(AlpacaDevice *device,
+                                                        MemoryArena *arena,
+                                                        f64 right_ascension,
+                                                        f64 declination) {
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data, "RightAscension", right_ascension);
+    cJSON_AddNumberToObject(data, "Declination", declination);
+    return alpaca_telescope_put(device, arena, "slewtocoordinatesasync", data);
+}
+
+/// Moves an axis of the mount at the specified rate, a rate of zero stops the axis
+AlpacaResult alpaca_telescope_move_axis(AlpacaDevice *device, MemoryArena *arena, AlpacaTelescopeAxis axis, f64 rate) {
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data, "Axis", axis);
+    cJSON_AddNumberToObject(data, "Rate", rate);
+    return alpaca_telescope_put(device, arena, "moveaxis", data);
+}
+
+/// Moves the mount in the specified direction at the guide rate for the specified time
+AlpacaResult alpaca_telescope_pulse_guide(AlpacaDevice *device,
+                                          MemoryArena *arena,
+                                          AlpacaGuideDirection direction,
+                                          u32 duration) {
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data, "Direction", direction);
+    cJSON_AddNumberToObject(data, "Duration", duration);
+    return alpaca_telescope_put(device, arena, "pulseguide", data);
+}
+
+/// Stops any slew, movement of axes and pulse guiding
+AlpacaResult alpaca_telescope_abort_slew(AlpacaDevice *device, MemoryArena *arena) {
+    return alpaca_telescope_put(device, arena, "abortslew", cJSON_CreateObject());
+}
+
+/// Moves the mount to its park position and stops tracking
+AlpacaResult alpaca_telescope_park(AlpacaDevice *device, MemoryArena *arena) {
+    return alpaca_telescope_put(device, arena, "park", cJSON_CreateObject());
+}
+
+/// Takes the mount out of its park position
+AlpacaResult alpaca_telescope_unpark(AlpacaDevice *device, MemoryArena *arena) {
+    return alpaca_telescope_put(device, arena, "unpark", cJSON_CreateObject());
+}
+
+struct AlpacaTelescopeQueue {
+    Mutex *mutex;
+
+    /// Ring buffer of pending commands and their tickets
+    AlpacaTelescopeCommand commands[ALPACA_TELESCOPE_QUEUE_CAPACITY];
+    u64 tickets[ALPACA_TELESCOPE_QUEUE_CAPACITY];
+    usize head;
+    usize count;
+    u64 next_ticket;
+
+    /// The outcome of the last command that was sent
+    u64 last_ticket;
+    AlpacaResult last_result;
+
+    /// Posted for every submitted command and when the worker is stopped, an idle worker blocks on it
+    Semaphore *ready;
+
+    /// Set while the worker sends a command that was already taken off the ring buffer
+    b8 sending;
+
+    /// The number of clears that wait for the command in flight, sent is posted once for each of them
+    u32 waiting;
+    Semaphore *sent;
+
+    /// Cleared to stop the worker, which posts stopped once it no longer touches any device
+    b8 running;
+    Semaphore *stopped;
+};
+
+/// Sends a command to its telescope
+static AlpacaResult alpaca_telescope_command_send(AlpacaTelescopeCommand const *command, MemoryArena *arena) {
+    AlpacaDevice *device = command->device;
+    switch (command->type) {
+        case ALPACA_TELESCOPE_COMMAND_TRACKING:
+            return alpaca_telescope_update_tracking(device, arena, command->tracking);
+        case ALPACA_TELESCOPE_COMMAND_SLEW_TO_COORDINATES:
+            return alpaca_telescope_slew_to_coordinates_async(device, arena, command->coordinates.right_ascension,
+                                                              command->coordinates.declination);
+        case ALPACA_TELESCOPE_COMMAND_MOVE_AXIS:
+            return alpaca_telescope_move_axis(device, arena, command->move.axis, command->move.rate);
+        case ALPACA_TELESCOPE_COMMAND_PULSE_GUIDE:
+            return alpaca_telescope_pulse_guide(device, arena, command->pulse.direction, command->pulse.duration);
+        case ALPACA_TELESCOPE_COMMAND_ABORT_SLEW:
+            return alpaca_telescope_abort_slew(device, arena);
+        case ALPACA_TELESCOPE_COMMAND_PARK:
+            return alpaca_telescope_park(device, arena);
+        case ALPACA_TELESCOPE_COMMAND_UNPARK:
+            return alpaca_telescope_unpark(device, arena);
+        default:
+            break;
+    }
+    return (AlpacaResult) { .status = ALPACA_BAD_REQUEST, .err_number = ALPACA_ERROR_INVALID_VALUE, .ok = false };
+}
+
+/// Sends the queued commands one after another
+static void *alpaca_telescope_queue_task(void *args) {
+    AlpacaTelescopeQueue *queue = (AlpacaTelescopeQueue *) args;
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+
+    for (;;) {
+        mutex_lock(queue->mutex);
+        if (!queue->running) {
+            mutex_unlock(queue->mutex);
+            semaphore_post(queue->stopped);
+            break;
+        }
+        if (queue->count == 0) {
+            mutex_unlock(queue->mutex);
+            semaphore_wait(queue->ready);
+            continue;
+        }
+        AlpacaTelescopeCommand command = queue->commands[queue->head];
+        u64 ticket = queue->tickets[queue->head];
+        queue->head = (queue->head + 1) % ALPACA_TELESCOPE_QUEUE_CAPACITY;
+        queue->count--;
+        queue->sending = true;
+        mutex_unlock(queue->mutex);
+
+        AlpacaResult result = alpaca_telescope_command_send(&command, &arena);
+        memory_arena_clear(&arena);
+
+        mutex_lock(queue->mutex);
+        queue->last_ticket = ticket;
+        queue->last_result = result;
+        queue->sending = false;
+        for (; queue->waiting > 0; --queue->waiting) {
+            semaphore_post(queue->sent);
+        }
+        mutex_unlock(queue->mutex);
+    }
+
+    memory_arena_destroy(&arena);
+    return nil;
+}
+
+/// Creates a new command queue and starts its worker thread
+AlpacaTelescopeQueue *alpaca_telescope_queue_new(void) {
+    AlpacaTelescopeQueue *queue = (AlpacaTelescopeQueue *) calloc(1, sizeof(AlpacaTelescopeQueue));
+    queue->mutex = mutex_new();
+    queue->ready = semaphore_new(0);
+    queue->sent = semaphore_new(0);
+    queue->stopped = semaphore_new(0);
+    queue->next_ticket = 1;
+    queue->running = true;
+    thread_create(alpaca_telescope_queue_task, queue);
+    return queue;
+}
+
+/// Stops the worker thread and frees the queue, pending commands are dropped
+void alpaca_telescope_queue_free(AlpacaTelescopeQueue *queue) {
+    mutex_lock(queue->mutex);
+    queue->running = false;
+    queue->count = 0;
+    mutex_unlock(queue->mutex);
+    semaphore_post(queue->ready);
+
+    // The devices of an in-flight command must stay valid until it was sent
+    semaphore_wait(queue->stopped);
+
+    semaphore_free(queue->stopped);
+    semaphore_free(queue->sent);
+    semaphore_free(queue->ready);
+    mutex_free(queue->mutex);
+    free(queue);
+}
+
+/// Removes the pending commands of a telescope, the queue lock must be held by the caller
+static void alpaca_telescope_queue_remove_locked(AlpacaTelescopeQueue *queue, AlpacaDevice const *device) {
+    usize kept = 0;
+    for (usize i = 0; i < queue->count; ++i) {
+        usize from = (queue->head + i) % ALPACA_TELESCOPE_QUEUE_CAPACITY;
+        if (queue->commands[from].device == device) {
+            continue;
+        }
+        usize to = (queue->head + kept) % ALPACA_TELESCOPE_QUEUE_CAPACITY;
+        queue->commands[to] = queue->commands[from];
+        queue->tickets[to] = queue->tickets[from];
+        kept++;
+    }
+    queue->count = kept;
+}
+
+/// Submits a command, abort commands drop all pending commands of the same telescope
+u64 alpaca_telescope_queue_submit(AlpacaTelescopeQueue *queue, AlpacaTelescopeCommand const *command) {
+    mutex_lock(queue->mutex);
+    if (command->type == ALPACA_TELESCOPE_COMMAND_ABORT_SLEW) {
+        alpaca_telescope_queue_remove_locked(queue, command->device);
+    }
+    if (queue->count == ALPACA_TELESCOPE_QUEUE_CAPACITY) {
+        mutex_unlock(queue->mutex);
+        return 0;
+    }
+
+    usize index = (queue->head + queue->count) % ALPACA_TELESCOPE_QUEUE_CAPACITY;
+    u64 ticket = queue->next_ticket++;
+    queue->commands[index] = *command;
+    queue->tickets[index] = ticket;
+    queue->count++;
+    mutex_unlock(queue->mutex);
+    semaphore_post(queue->ready);
+    return ticket;
+}
+
+/// Drops all pending commands and waits until the command in flight was sent
+void alpaca_telescope_queue_clear(AlpacaTelescopeQueue *queue) {
+    mutex_lock(queue->mutex);
+    queue->count = 0;
+    b8 const sending = queue->sending;
+    if (sending) {
+        queue->waiting++;
+    }
+    mutex_unlock(queue->mutex);
+
+    // Afterwards the queue no longer references any device, so the devices may be destroyed
+    if (sending) {
+        semaphore_wait(queue->sent);
+    }
+}
+
+/// Retrieves the outcome of the last command that was sent
+u64 alpaca_telescope_queue_last(AlpacaTelescopeQueue *queue, AlpacaResult *result) {
+    mutex_lock(queue->mutex);
+    u64 ticket = queue->last_ticket;
+    *result = queue->last_result;
+    mutex_unlock(queue->mutex);
+    return ticket;
+}
@@ -134,12 +134,195 @@ AlpacaResult alpaca_telescope_altitude(AlpacaDevice *device, MemoryArena *arena,
 /// @return A result
 AlpacaResult alpaca_telescope_azimuth(AlpacaDevice *device, MemoryArena *arena, f64 *value);
 
+/// Samples the mount's stale position at once and stores it in the device payload
+/// @param device The telescope device
+/// @param multi The multi engine that drives the requests, nil for a temporary engine
+/// @param arena The memory arena for the requests
+/// @return The first failed result, or a successful result if all requests succeeded
+AlpacaResult alpaca_telescope_sample(AlpacaDevice *device, HttpMulti *multi, MemoryArena *arena);
+
+/// Tries to retrieve the mount's current right ascension (hours) in the equatorial system of the mount
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param value The value that will be set
+/// @return A result
+AlpacaResult alpaca_telescope_right_ascension(AlpacaDevice *device, MemoryArena *arena, f64 *value);
+
+/// Tries to retrieve the mount's current declination (°) in the equatorial system of the mount
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param value The value that will be set
+/// @return A result
+AlpacaResult alpaca_telescope_declination(AlpacaDevice *device, MemoryArena *arena, f64 *value);
+
+/// Tries to retrieve the local apparent sidereal time (hours) of the mount
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param value The value that will be set
+/// @return A result
+AlpacaResult alpaca_telescope_sidereal_time(AlpacaDevice *device, MemoryArena *arena, f64 *value);
+
+/// Tries to retrieve whether the mount is tracking
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param value The value that will be set
+/// @return A result
+AlpacaResult alpaca_telescope_tracking(AlpacaDevice *device, MemoryArena *arena, b8 *value);
+
+/// Tries to retrieve whether the mount is slewing, this is how the completion of
+/// asynchronous slews is observed
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param value The value that will be set
+/// @return A result
+AlpacaResult alpaca_telescope_slewing(AlpacaDevice *device, MemoryArena *arena, b8 *value);
+
+/// Tries to retrieve whether the mount is parked
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param value The value that will be set
+/// @return A result
+AlpacaResult alpaca_telescope_at_park(AlpacaDevice *device, MemoryArena *arena, b8 *value);
+
+/// Tries to retrieve the geometry of the mount, which determines the frame of the axes and guide directions
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param value The value that will be set
+/// @return A result
+AlpacaResult alpaca_telescope_alignment_mode(AlpacaDevice *device, MemoryArena *arena, AlpacaAlignmentMode *value);
+
+/// Turns tracking of the mount on or off
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param value Whether the mount should track
+/// @return A result
+AlpacaResult alpaca_telescope_update_tracking(AlpacaDevice *device, MemoryArena *arena, b8 value);
+
+/// Starts a slew to the specified equatorial coordinates and returns immediately
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param right_ascension The right ascension (hours) of the target
+/// @param declination The declination (°) of the target
+/// @return A result
+AlpacaResult alpaca_telescope_slew_to_coordinates_async(AlpacaDevice *device,
+                                                        MemoryArena *arena,
+                                                        f64 right_ascension,
+                                                        f64 declination);
+
+/// Moves an axis of the mount at the specified rate, a rate of zero stops the axis
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param axis The axis to move
+/// @param rate The rate (°/s), negative rates move the axis in the opposite direction
+/// @return A result
+AlpacaResult alpaca_telescope_move_axis(AlpacaDevice *device, MemoryArena *arena, AlpacaTelescopeAxis axis, f64 rate);
+
+/// Moves the mount in the specified direction at the guide rate for the specified time
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @param direction The guide direction
+/// @param duration The duration (ms) of the pulse
+/// @return A result
+AlpacaResult alpaca_telescope_pulse_guide(AlpacaDevice *device,
+                                          MemoryArena *arena,
+                                          AlpacaGuideDirection direction,
+                                          u32 duration);
+
+/// Stops any slew, movement of axes and pulse guiding
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @return A result
+AlpacaResult alpaca_telescope_abort_slew(AlpacaDevice *device, MemoryArena *arena);
+
+/// Moves the mount to its park position and stops tracking
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @return A result
+AlpacaResult alpaca_telescope_park(AlpacaDevice *device, MemoryArena *arena);
+
+/// Takes the mount out of its park position
+/// @param device The telescope device
+/// @param arena The memory arena for the request
+/// @return A result
+AlpacaResult alpaca_telescope_unpark(AlpacaDevice *device, MemoryArena *arena);
+
+/// The commands that can be queued for a telescope
+typedef enum AlpacaTelescopeCommandType {
+    ALPACA_TELESCOPE_COMMAND_NONE = 0,
+    ALPACA_TELESCOPE_COMMAND_TRACKING,
+    ALPACA_TELESCOPE_COMMAND_SLEW_TO_COORDINATES,
+    ALPACA_TELESCOPE_COMMAND_MOVE_AXIS,
+    ALPACA_TELESCOPE_COMMAND_PULSE_GUIDE,
+    ALPACA_TELESCOPE_COMMAND_ABORT_SLEW,
+    ALPACA_TELESCOPE_COMMAND_PARK,
+    ALPACA_TELESCOPE_COMMAND_UNPARK,
+} AlpacaTelescopeCommandType;
+
+/// A telescope command and its arguments
+typedef struct AlpacaTelescopeCommand {
+    /// The telescope the command is sent to
+    AlpacaDevice *device;
+
+    AlpacaTelescopeCommandType type;
+
+    union {
+        /// Arguments of ALPACA_TELESCOPE_COMMAND_TRACKING
+        b8 tracking;
+
+        /// Arguments of ALPACA_TELESCOPE_COMMAND_SLEW_TO_COORDINATES
+        struct {
+            f64 right_ascension;
+            f64 declination;
+        } coordinates;
+
+        /// Arguments of ALPACA_TELESCOPE_COMMAND_MOVE_AXIS
+        struct {
+            AlpacaTelescopeAxis axis;
+            f64 rate;
+        } move;
+
+        /// Arguments of ALPACA_TELESCOPE_COMMAND_PULSE_GUIDE
+        struct {
+            AlpacaGuideDirection direction;
+            u32 duration;
+        } pulse;
+    };
+} AlpacaTelescopeCommand;
+
+/// Queue of telescope commands that are sent by a worker thread, submitting never
+/// waits for the network
+typedef struct AlpacaTelescopeQueue AlpacaTelescopeQueue;
+
+/// Creates a new command queue and starts its worker thread
+/// @return The command queue
+AlpacaTelescopeQueue *alpaca_telescope_queue_new(void);
+
+/// Stops the worker thread and frees the queue, pending commands are dropped
+/// @note Waits for the command that is currently sent
+/// @param queue The command queue
+void alpaca_telescope_queue_free(AlpacaTelescopeQueue *queue);
+
+/// Submits a command, abort commands drop all pending commands of the same telescope
+/// @param queue The command queue
+/// @param command The command
+/// @return The ticket of the command, or zero if the queue is full
+u64 alpaca_telescope_queue_submit(AlpacaTelescopeQueue *queue, AlpacaTelescopeCommand const *command);
+
+/// Drops all pending commands
+/// @note Waits for the command that is currently sent, afterwards the devices of the queued commands may be destroyed
+/// @param queue The command queue
+void alpaca_telescope_queue_clear(AlpacaTelescopeQueue *queue);
+
+/// Retrieves the outcome of the last command that was sent
+/// @param queue The command queue
+/// @param result The result of the command
+/// @return The ticket of the command, or zero if no command was sent yet
+u64 alpaca_telescope_queue_last(AlpacaTelescopeQueue *queue, AlpacaResult *result);
+
 /// TODO(elias): unimplemented
-/// AlignmentMode
 /// ApertureArea
 /// ApertureDiameter
 /// AtHome
-/// AtPark
 /// CanFindHome
 /// CanPark
 /// CanPulseGuide
@@ -156,7 +339,6 @@ AlpacaResult alpaca_telescope_azimuth(AlpacaDevice *device, MemoryArena *arena,
 /// CanSync
 /// CanSyncAltAz
 /// CanUnpark
-/// Declination
 /// DeclinationRate
 /// DeclinationRate setter
 /// DoesRefraction
@@ -168,47 +350,36 @@ AlpacaResult alpaca_telescope_azimuth(AlpacaDevice *device, MemoryArena *arena,
 /// GuideRateAscensiion
 /// GuideRateAscensiion setter
 /// IsPulseGuiding
-/// RightAscension
 /// RightAscension setter
 /// RightAscensionRate
 /// RightAscensionRate setter
 /// SideOfPier
 /// SideOfPier setter
-/// SiderealTime
 /// SiteElevation
 /// SiteElevation setter
 /// SiteLatitude
 /// SiteLatitude setter
 /// SiteLongitude
 /// SiteLongitude setter
-/// Slewing
 /// SlewSettleTime
 /// SlewSettleTime setter
 /// TargetDeclination
 /// TargetDeclination setter
-/// Tracking
-/// Tracking setter
 /// TrackingRates
 /// UTCDate
 /// UTCDate setter
 /// AxisRates
 /// CanMoveAxis
 /// DestinationSideOfPier
-/// AbortSlew
 /// FindHome
-/// MoveAxis
-/// Park
-/// PulseGuide
 /// SetPark
 /// SlewToAltAz
 /// SlewToAltAyAsync
 /// SlewToCoordinates
-/// SlewToCoordinatesAsync
 /// SlewToTarget
 /// SlewToTargetAsync
 /// SyncToAltAz
 /// SyncToCoordinates
 /// SyncToTarget
-/// Unpark
 
 #endif// ASCOM_TELESCOPE_H
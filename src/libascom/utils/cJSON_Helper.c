@@ -22,6 +22,7 @@
 // SOFTWARE.
 
 #include <libcore/types.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "cJSON_Helper.h"
@@ -70,3 +71,69 @@ static String string_from_possibly_nil(MemoryArena *arena, const char *source) {
 String cJSON_GetStringByName(MemoryArena *arena, cJSON const *json, const char *key) {
     return string_from_possibly_nil(arena, cJSON_GetNativeStringByName(json, key));
 }
+
+enum {
+    CJSON_ORIGIN_HEAP = 0x48454150,
+    CJSON_ORIGIN_ARENA = 0x4152454E,
+};
+
+/// Every allocation is prefixed with its origin, so that free knows whether it must release it
+typedef union cJSON_AllocationHeader {
+    u32 origin;
+    max_align_t alignment;
+} cJSON_AllocationHeader;
+
+/// The arena that is bound to the current thread
+static _Thread_local MemoryArena *cjson_arena = nil;
+
+/// Allocation counts of the current thread
+static _Thread_local cJSON_ArenaStatistics cjson_statistics = { 0 };
+
+/// cJSON malloc hook
+static void *cJSON_ArenaMalloc(size_t size) {
+    cJSON_AllocationHeader *header = nil;
+    if (cjson_arena != nil) {
+        header = (cJSON_AllocationHeader *) memory_arena_alloc(cjson_arena, sizeof *header + size);
+        header->origin = CJSON_ORIGIN_ARENA;
+        cjson_statistics.arena_allocations++;
+    } else {
+        header = (cJSON_AllocationHeader *) malloc(sizeof *header + size);
+        if (header == nil) {
+            return nil;
+        }
+        header->origin = CJSON_ORIGIN_HEAP;
+        cjson_statistics.heap_allocations++;
+    }
+    return header + 1;
+}
+
+/// cJSON free hook
+static void cJSON_ArenaFree(void *pointer) {
+    if (pointer == nil) {
+        return;
+    }
+
+    // Arena allocations are released together with the arena
+    cJSON_AllocationHeader *header = (cJSON_AllocationHeader *) pointer - 1;
+    if (header->origin == CJSON_ORIGIN_HEAP) {
+        free(header);
+    }
+}
+
+/// Installs allocation hooks into cJSON
+void cJSON_InitArenaHooks(void) {
+    cJSON_Hooks hooks = { .malloc_fn = cJSON_ArenaMalloc, .free_fn = cJSON_ArenaFree };
+    cJSON_InitHooks(&hooks);
+}
+
+/// Binds the arena to the calling thread
+MemoryArena *cJSON_BindArena(MemoryArena *arena) {
+    MemoryArena *previous = cjson_arena;
+    cjson_arena = arena;
+    return previous;
+}
+
+/// Retrieves the allocation counts of the calling thread
+cJSON_ArenaStatistics cJSON_GetArenaStatistics(void) {
+    return cjson_statistics;
+}
@@ -38,4 +38,24 @@ f64 cJSON_GetNumberByName(cJSON const *json, const char *key);
 /// Retrieves a string value that might not be present from a JSON object
 String cJSON_GetStringByName(MemoryArena *arena, cJSON const *json, const char *key);
 
+/// Allocation counts of the calling thread
+typedef struct cJSON_ArenaStatistics {
+    u64 heap_allocations;
+    u64 arena_allocations;
+} cJSON_ArenaStatistics;
+
+/// Installs allocation hooks into cJSON, which allocate from the arena that is bound to
+/// the calling thread and fall back to the heap otherwise
+/// @note The hooks must be installed before any cJSON allocation takes place
+void cJSON_InitArenaHooks(void);
+
+/// Binds the arena to the calling thread, cJSON allocations of this thread then live inside
+/// the arena and are released with the arena, freeing them is a no-op
+/// @param arena The arena, nil restores heap allocations
+/// @return The previously bound arena
+MemoryArena *cJSON_BindArena(MemoryArena *arena);
+
+/// Retrieves the allocation counts of the calling thread
+cJSON_ArenaStatistics cJSON_GetArenaStatistics(void);
+
 #endif// ASCOM_UTILS_CJSON_HELPER_H
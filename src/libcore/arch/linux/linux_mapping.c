@@ -0,0 +1,64 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libcore/arch/mapping.h>
+
+/// Maps the specified file into memory
+b8 file_mapping_open(FileMapping *mapping, const char *path) {
+    *mapping = (FileMapping) { 0 };
+    int file = open(path, O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat info = { 0 };
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        close(file);
+        return false;
+    }
+
+    void *data = mmap(nil, (usize) info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    // The file is read front to back
+    madvise(data, (usize) info.st_size, MADV_SEQUENTIAL);
+    mapping->data = (u8 const *) data;
+    mapping->size = (usize) info.st_size;
+    return true;
+}
+
+/// Unmaps the file
+void file_mapping_close(FileMapping *mapping) {
+    if (mapping->data != nil) {
+        munmap((void *) mapping->data, mapping->size);
+    }
+    *mapping = (FileMapping) { 0 };
+}
@@ -21,9 +21,13 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <errno.h>
 #include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <libcore/arch/thread.h>
 
@@ -43,6 +47,20 @@ void thread_sleep(u64 milliseconds) {
     nanosleep(&ts, NULL);
 }
 
+/// Raises the scheduling priority of the calling thread
+b8 thread_raise_priority(void) {
+    // Real-time scheduling requires privileges, the thread keeps its priority otherwise
+    struct sched_param param = { 0 };
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+/// Retrieves the number of logical processors that are available to the process
+u32 thread_hardware_concurrency(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32) count : 1;
+}
+
 typedef struct Mutex {
     pthread_mutex_t handle;
 } Mutex;
@@ -69,3 +87,77 @@ void mutex_lock(Mutex *self) {
 void mutex_unlock(Mutex *self) {
     pthread_mutex_unlock(&self->handle);
 }
+
+typedef struct Semaphore {
+    sem_t handle;
+} Semaphore;
+
+/// Creates a new counting semaphore
+Semaphore *semaphore_new(u32 count) {
+    Semaphore *self = (Semaphore *) malloc(sizeof(Semaphore));
+    sem_init(&self->handle, 0, count);
+    return self;
+}
+
+/// Frees the semaphore
+void semaphore_free(Semaphore *self) {
+    sem_destroy(&self->handle);
+    free(self);
+}
+
+/// Increments the count and wakes one of the waiting threads
+void semaphore_post(Semaphore *self) {
+    sem_post(&self->handle);
+}
+
+/// Blocks until the count is positive and decrements it
+void semaphore_wait(Semaphore *self) {
+    // Signals interrupt the wait without taking the count
+    while (sem_wait(&self->handle) != 0 && errno == EINTR) {
+    }
+}
+
+/// Blocks until the count is positive or the timeout elapsed
+b8 semaphore_wait_timeout(Semaphore *self, u64 milliseconds) {
+    struct timespec deadline = { 0 };
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t) (milliseconds / 1000);
+    deadline.tv_nsec += (long) (milliseconds % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    for (;;) {
+        if (sem_timedwait(&self->handle, &deadline) == 0) {
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+/// Begins a write, must be paired with seqlock_write_end
+void seqlock_write_begin(SeqLock *self) {
+    u32 sequence = __atomic_load_n(&self->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/// Ends a write and publishes the written data
+void seqlock_write_end(SeqLock *self) {
+    u32 sequence = __atomic_load_n(&self->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+/// Begins a read
+u32 seqlock_read_begin(SeqLock const *self) {
+    return __atomic_load_n(&self->sequence, __ATOMIC_ACQUIRE);
+}
+
+/// Checks whether the read overlapped with a write and must be retried
+b8 seqlock_read_retry(SeqLock const *self, u32 sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (sequence & 1) != 0 || __atomic_load_n(&self->sequence, __ATOMIC_RELAXED) != sequence;
+}
@@ -21,9 +21,11 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <dispatch/dispatch.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <libcore/arch/thread.h>
 
@@ -43,6 +45,17 @@ void thread_sleep(u64 milliseconds) {
     nanosleep(&ts, NULL);
 }
 
+/// Raises the scheduling priority of the calling thread
+b8 thread_raise_priority(void) {
+    return pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0) == 0;
+}
+
+/// Retrieves the number of logical processors that are available to the process
+u32 thread_hardware_concurrency(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32) count : 1;
+}
+
 typedef struct Mutex {
     pthread_mutex_t handle;
 } Mutex;
@@ -69,3 +82,65 @@ void mutex_lock(Mutex *self) {
 void mutex_unlock(Mutex *self) {
     pthread_mutex_unlock(&self->handle);
 }
+
+typedef struct Semaphore {
+    dispatch_semaphore_t handle;
+} Semaphore;
+
+/// Creates a new counting semaphore
+Semaphore *semaphore_new(u32 count) {
+    // Unnamed POSIX semaphores are not supported, and dispatch semaphores must not be released
+    // below their initial count, so the count is added after creating it
+    Semaphore *self = (Semaphore *) malloc(sizeof(Semaphore));
+    self->handle = dispatch_semaphore_create(0);
+    for (u32 i = 0; i < count; ++i) {
+        dispatch_semaphore_signal(self->handle);
+    }
+    return self;
+}
+
+/// Frees the semaphore
+void semaphore_free(Semaphore *self) {
+    dispatch_release(self->handle);
+    free(self);
+}
+
+/// Increments the count and wakes one of the waiting threads
+void semaphore_post(Semaphore *self) {
+    dispatch_semaphore_signal(self->handle);
+}
+
+/// Blocks until the count is positive and decrements it
+void semaphore_wait(Semaphore *self) {
+    dispatch_semaphore_wait(self->handle, DISPATCH_TIME_FOREVER);
+}
+
+/// Blocks until the count is positive or the timeout elapsed
+b8 semaphore_wait_timeout(Semaphore *self, u64 milliseconds) {
+    dispatch_time_t deadline = dispatch_time(DISPATCH_TIME_NOW, (int64_t) (milliseconds * NSEC_PER_MSEC));
+    return dispatch_semaphore_wait(self->handle, deadline) == 0;
+}
+
+/// Begins a write, must be paired with seqlock_write_end
+void seqlock_write_begin(SeqLock *self) {
+    u32 sequence = __atomic_load_n(&self->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/// Ends a write and publishes the written data
+void seqlock_write_end(SeqLock *self) {
+    u32 sequence = __atomic_load_n(&self->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+/// Begins a read
+u32 seqlock_read_begin(SeqLock const *self) {
+    return __atomic_load_n(&self->sequence, __ATOMIC_ACQUIRE);
+}
+
+/// Checks whether the read overlapped with a write and must be retried
+b8 seqlock_read_retry(SeqLock const *self, u32 sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (sequence & 1) != 0 || __atomic_load_n(&self->sequence, __ATOMIC_RELAXED) != sequence;
+}
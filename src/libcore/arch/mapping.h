@@ -0,0 +1,48 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef CORE_MAPPING_H
+#define CORE_MAPPING_H
+
+#include "../types.h"
+
+/// A read-only memory mapping of a whole file
+typedef struct FileMapping {
+    u8 const *data;
+    usize size;
+
+    /// Platform specific handle of the mapping
+    void *handle;
+} FileMapping;
+
+/// Maps the specified file into memory
+/// @param mapping The file mapping
+/// @param path The path of the file
+/// @return Whether the file could be mapped
+b8 file_mapping_open(FileMapping *mapping, const char *path);
+
+/// Unmaps the file
+/// @param mapping The file mapping
+void file_mapping_close(FileMapping *mapping);
+
+#endif// CORE_MAPPING_H
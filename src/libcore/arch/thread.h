@@ -49,6 +49,15 @@ Thread thread_create(ThreadRunner runner, void *arg);
 /// @param milliseconds The time in milliseconds
 void thread_sleep(u64 milliseconds);
 
+/// Raises the scheduling priority of the calling thread, intended for
+/// latency sensitive loops
+/// @return Whether the operating system granted the priority
+b8 thread_raise_priority(void);
+
+/// Retrieves the number of logical processors that are available to the process
+/// @return The number of logical processors, at least one
+u32 thread_hardware_concurrency(void);
+
 typedef struct Mutex Mutex;
 
 /// Creates a new mutex
@@ -67,4 +76,55 @@ void mutex_lock(Mutex *self);
 /// @param self The mutex handle
 void mutex_unlock(Mutex *self);
 
+typedef struct Semaphore Semaphore;
+
+/// Creates a new counting semaphore
+/// @param count The initial count
+/// @return A new semaphore
+Semaphore *semaphore_new(u32 count);
+
+/// Frees the semaphore, no thread may wait on it
+/// @param self The semaphore handle
+void semaphore_free(Semaphore *self);
+
+/// Increments the count and wakes one of the waiting threads
+/// @param self The semaphore handle
+void semaphore_post(Semaphore *self);
+
+/// Blocks until the count is positive and decrements it
+/// @param self The semaphore handle
+void semaphore_wait(Semaphore *self);
+
+/// Blocks until the count is positive or the timeout elapsed, the count is only decremented if it was positive
+/// @param self The semaphore handle
+/// @param milliseconds The timeout in milliseconds
+/// @return Whether the count was decremented
+b8 semaphore_wait_timeout(Semaphore *self, u64 milliseconds);
+
+/// Sequence lock for a single writer and many readers, readers never block the writer
+/// and retry their read if it overlapped with a write
+typedef struct SeqLock {
+    /// Odd while a write is in progress
+    volatile u32 sequence;
+} SeqLock;
+
+/// Begins a write, must be paired with seqlock_write_end
+/// @param self The sequence lock
+void seqlock_write_begin(SeqLock *self);
+
+/// Ends a write and publishes the written data
+/// @param self The sequence lock
+void seqlock_write_end(SeqLock *self);
+
+/// Begins a read
+/// @param self The sequence lock
+/// @return The sequence that must be passed to seqlock_read_retry
+u32 seqlock_read_begin(SeqLock const *self);
+
+/// Checks whether the read overlapped with a write and must be retried
+/// @param self The sequence lock
+/// @param sequence The sequence returned by seqlock_read_begin
+/// @return Whether the read must be retried
+b8 seqlock_read_retry(SeqLock const *self, u32 sequence);
+
 #endif// CORE_THREAD_H
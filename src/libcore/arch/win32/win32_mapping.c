@@ -0,0 +1,68 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <Windows.h>
+
+#include <libcore/arch/mapping.h>
+
+/// Maps the specified file into memory
+b8 file_mapping_open(FileMapping *mapping, const char *path) {
+    *mapping = (FileMapping) { 0 };
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nil, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nil);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size = { 0 };
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE handle = CreateFileMappingA(file, nil, PAGE_READONLY, 0, 0, nil);
+    CloseHandle(file);
+    if (handle == nil) {
+        return false;
+    }
+
+    void *data = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+    if (data == nil) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    mapping->data = (u8 const *) data;
+    mapping->size = (usize) size.QuadPart;
+    mapping->handle = handle;
+    return true;
+}
+
+/// Unmaps the file
+void file_mapping_close(FileMapping *mapping) {
+    if (mapping->data != nil) {
+        UnmapViewOfFile(mapping->data);
+        CloseHandle(mapping->handle);
+    }
+    *mapping = (FileMapping) { 0 };
+}
@@ -37,6 +37,18 @@ void thread_sleep(u64 milliseconds) {
     Sleep((u32) milliseconds);
 }
 
+/// Raises the scheduling priority of the calling thread
+b8 thread_raise_priority(void) {
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST) != 0;
+}
+
+/// Retrieves the number of logical processors that are available to the process
+u32 thread_hardware_concurrency(void) {
+    SYSTEM_INFO info = { 0 };
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (u32) info.dwNumberOfProcessors : 1;
+}
+
 typedef struct Mutex {
     HANDLE handle;
 } Mutex;
@@ -64,3 +76,60 @@ void mutex_lock(Mutex *self) {
 void mutex_unlock(Mutex *self) {
     ReleaseMutex(self->handle);
 }
+
+typedef struct Semaphore {
+    HANDLE handle;
+} Semaphore;
+
+/// Creates a new counting semaphore
+Semaphore *semaphore_new(u32 count) {
+    Semaphore *self = (Semaphore *) malloc(sizeof(Semaphore));
+    self->handle = CreateSemaphoreA(nil, (LONG) count, MAXLONG, nil);
+    return self;
+}
+
+/// Frees the semaphore
+void semaphore_free(Semaphore *self) {
+    CloseHandle(self->handle);
+    self->handle = INVALID_HANDLE_VALUE;
+    free(self);
+}
+
+/// Increments the count and wakes one of the waiting threads
+void semaphore_post(Semaphore *self) {
+    ReleaseSemaphore(self->handle, 1, nil);
+}
+
+/// Blocks until the count is positive and decrements it
+void semaphore_wait(Semaphore *self) {
+    WaitForSingleObject(self->handle, INFINITE);
+}
+
+/// Blocks until the count is positive or the timeout elapsed
+b8 semaphore_wait_timeout(Semaphore *self, u64 milliseconds) {
+    return WaitForSingleObject(self->handle, (DWORD) milliseconds) == WAIT_OBJECT_0;
+}
+
+/// Begins a write, must be paired with seqlock_write_end
+void seqlock_write_begin(SeqLock *self) {
+    // Interlocked operations imply a full memory barrier
+    InterlockedIncrement((volatile LONG *) &self->sequence);
+}
+
+/// Ends a write and publishes the written data
+void seqlock_write_end(SeqLock *self) {
+    InterlockedIncrement((volatile LONG *) &self->sequence);
+}
+
+/// Begins a read
+u32 seqlock_read_begin(SeqLock const *self) {
+    u32 sequence = self->sequence;
+    MemoryBarrier();
+    return sequence;
+}
+
+/// Checks whether the read overlapped with a write and must be retried
+b8 seqlock_read_retry(SeqLock const *self, u32 sequence) {
+    MemoryBarrier();
+    return (sequence & 1) != 0 || self->sequence != sequence;
+}
@@ -0,0 +1,211 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdlib.h>
+
+#include "arch/thread.h"
+#include "jobs.h"
+
+typedef struct Job {
+    JobFunction function;
+    void *arg;
+} Job;
+
+/// Double-ended queue of a worker, the owner works at the back while thieves take from the front
+typedef struct JobQueue {
+    Mutex *mutex;
+    Job jobs[JOB_QUEUE_CAPACITY];
+    usize head;
+    usize count;
+} JobQueue;
+
+/// The state of a single worker
+typedef struct JobWorker {
+    JobPool *pool;
+    u32 index;
+} JobWorker;
+
+typedef struct JobPool {
+    JobQueue *queues;
+    JobWorker *workers;
+    u32 worker_count;
+
+    /// The queue that receives the next submission
+    u32 cursor;
+
+    /// The number of jobs that were submitted but not finished
+    u32 pending;
+
+    /// Idle workers block on it, it is posted for every queued job and once per worker when the pool stops
+    Semaphore *ready;
+
+    /// Controls whether the workers should continue once all jobs are finished
+    b8 running;
+
+    /// The number of workers that did not exit yet
+    u32 alive;
+} JobPool;
+
+/// Appends a job to the back of the queue
+static b8 job_queue_push(JobQueue *queue, Job const *job) {
+    mutex_lock(queue->mutex);
+    b8 const pushed = queue->count < JOB_QUEUE_CAPACITY;
+    if (pushed) {
+        queue->jobs[(queue->head + queue->count) % JOB_QUEUE_CAPACITY] = *job;
+        queue->count++;
+    }
+    mutex_unlock(queue->mutex);
+    return pushed;
+}
+
+/// Takes the newest job from the back of the queue, its data is most likely still in the cache
+static b8 job_queue_pop(JobQueue *queue, Job *job) {
+    mutex_lock(queue->mutex);
+    b8 const popped = queue->count > 0;
+    if (popped) {
+        queue->count--;
+        *job = queue->jobs[(queue->head + queue->count) % JOB_QUEUE_CAPACITY];
+    }
+    mutex_unlock(queue->mutex);
+    return popped;
+}
+
+/// Takes the oldest job from the front of the queue
+static b8 job_queue_steal(JobQueue *queue, Job *job) {
+    mutex_lock(queue->mutex);
+    b8 const stolen = queue->count > 0;
+    if (stolen) {
+        *job = queue->jobs[queue->head];
+        queue->head = (queue->head + 1) % JOB_QUEUE_CAPACITY;
+        queue->count--;
+    }
+    mutex_unlock(queue->mutex);
+    return stolen;
+}
+
+/// Finds the next job of the worker, the own queue comes first
+static b8 job_worker_next(JobWorker *worker, Job *job) {
+    JobPool *pool = worker->pool;
+    if (job_queue_pop(pool->queues + worker->index, job)) {
+        return true;
+    }
+    for (u32 i = 1; i < pool->worker_count; ++i) {
+        if (job_queue_steal(pool->queues + (worker->index + i) % pool->worker_count, job)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *job_worker_task(void *args) {
+    JobWorker *worker = (JobWorker *) args;
+    JobPool *pool = worker->pool;
+
+    // Submitted jobs are always finished, even if the pool is being freed
+    for (;;) {
+        Job job = { 0 };
+        if (job_worker_next(worker, &job)) {
+            job.function(job.arg);
+            __atomic_sub_fetch(&pool->pending, 1, __ATOMIC_RELEASE);
+            continue;
+        }
+        b8 const running = __atomic_load_n(&pool->running, __ATOMIC_ACQUIRE);
+        if (!running && __atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE) == 0) {
+            break;
+        }
+
+        // Jobs are queued before the semaphore is posted, so a woken worker always finds the job unless
+        // another worker took it first
+        semaphore_wait(pool->ready);
+    }
+
+    // A worker that still waits for the jobs of the others is woken up in turn
+    semaphore_post(pool->ready);
+    __atomic_sub_fetch(&pool->alive, 1, __ATOMIC_RELEASE);
+    return nil;
+}
+
+/// Creates a new job pool and starts its workers
+JobPool *job_pool_new(u32 worker_count) {
+    if (worker_count == 0) {
+        u32 const processors = thread_hardware_concurrency();
+        worker_count = processors > 1 ? processors - 1 : 1;
+    }
+
+    JobPool *pool = (JobPool *) calloc(1, sizeof(JobPool));
+    pool->queues = (JobQueue *) calloc(worker_count, sizeof(JobQueue));
+    pool->workers = (JobWorker *) calloc(worker_count, sizeof(JobWorker));
+    pool->worker_count = worker_count;
+    pool->ready = semaphore_new(0);
+    pool->running = true;
+    pool->alive = worker_count;
+    for (u32 i = 0; i < worker_count; ++i) {
+        pool->queues[i].mutex = mutex_new();
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+    }
+    for (u32 i = 0; i < worker_count; ++i) {
+        thread_create(job_worker_task, pool->workers + i);
+    }
+    return pool;
+}
+
+/// Finishes all submitted jobs, stops the workers and frees the pool
+void job_pool_free(JobPool *pool) {
+    __atomic_store_n(&pool->running, false, __ATOMIC_RELEASE);
+    for (u32 i = 0; i < pool->worker_count; ++i) {
+        semaphore_post(pool->ready);
+    }
+    while (__atomic_load_n(&pool->alive, __ATOMIC_ACQUIRE) > 0) {
+        thread_sleep(JOB_POOL_STOP_POLL);
+    }
+    semaphore_free(pool->ready);
+    for (u32 i = 0; i < pool->worker_count; ++i) {
+        mutex_free(pool->queues[i].mutex);
+    }
+    free(pool->workers);
+    free(pool->queues);
+    free(pool);
+}
+
+/// Submits a job, jobs are distributed over the worker queues in turn
+void job_pool_submit(JobPool *pool, JobFunction function, void *arg) {
+    Job const job = { function, arg };
+    u32 const first = __atomic_fetch_add(&pool->cursor, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_RELEASE);
+    for (u32 i = 0; i < pool->worker_count; ++i) {
+        if (job_queue_push(pool->queues + (first + i) % pool->worker_count, &job)) {
+            semaphore_post(pool->ready);
+            return;
+        }
+    }
+
+    // Every queue is full, the caller helps out instead of blocking
+    __atomic_sub_fetch(&pool->pending, 1, __ATOMIC_RELEASE);
+    function(arg);
+}
+
+/// Retrieves the number of workers
+u32 job_pool_worker_count(JobPool const *pool) {
+    return pool->worker_count;
+}
@@ -0,0 +1,65 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef CORE_JOBS_H
+#define CORE_JOBS_H
+
+#include "types.h"
+
+enum {
+    /// Maximum number of jobs that are queued per worker
+    JOB_QUEUE_CAPACITY = 256,
+
+    /// Interval (ms) in which job_pool_free checks whether the workers exited
+    JOB_POOL_STOP_POLL = 1,
+};
+
+/// A function that is executed by one of the workers
+typedef void (*JobFunction)(void *arg);
+
+/// Pool of workers that share their jobs by work stealing. Every worker owns a queue, it takes
+/// its newest job first and steals the oldest jobs of the other workers once its queue ran dry.
+typedef struct JobPool JobPool;
+
+/// Creates a new job pool and starts its workers
+/// @param worker_count The number of workers, zero for one less than the number of processors
+/// @return The job pool
+JobPool *job_pool_new(u32 worker_count);
+
+/// Finishes all submitted jobs, stops the workers and frees the pool
+/// @param pool The job pool
+void job_pool_free(JobPool *pool);
+
+/// Submits a job, jobs are distributed over the worker queues in turn
+/// @note The job is executed on the calling thread if all queues are full
+/// @param pool The job pool
+/// @param function The function of the job
+/// @param arg The argument that is passed to the function
+void job_pool_submit(JobPool *pool, JobFunction function, void *arg);
+
+/// Retrieves the number of workers
+/// @param pool The job pool
+/// @return The number of workers
+u32 job_pool_worker_count(JobPool const *pool);
+
+#endif// CORE_JOBS_H
@@ -0,0 +1,136 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <math.h>
+
+#include "series.h"
+
+/// Creates a new time series
+void time_series_make(TimeSeries *series, MemoryArena *arena, usize capacity) {
+    series->timestamps = (f64 *) memory_arena_alloc(arena, sizeof(f64) * capacity);
+    series->values = (f64 *) memory_arena_alloc(arena, sizeof(f64) * capacity);
+    series->capacity = capacity;
+    series->count = 0;
+    series->offset = 0;
+    series->seqlock = (SeqLock) { 0 };
+}
+
+/// Appends a sample, overwrites the oldest sample if the series is full
+void time_series_push(TimeSeries *series, f64 timestamp, f64 value) {
+    if (series->capacity == 0) {
+        return;
+    }
+
+    usize index = (series->offset + series->count) % series->capacity;
+    series->timestamps[index] = timestamp;
+    series->values[index] = value;
+
+    seqlock_write_begin(&series->seqlock);
+    if (series->count < series->capacity) {
+        series->count++;
+    } else {
+        series->offset = (series->offset + 1) % series->capacity;
+    }
+    seqlock_write_end(&series->seqlock);
+}
+
+/// Retrieves a view onto the samples without taking a lock
+TimeSeriesView time_series_view(TimeSeries const *series) {
+    TimeSeriesView view = { series->timestamps, series->values, 0, 0 };
+    u32 sequence = 0;
+    do {
+        sequence = seqlock_read_begin(&series->seqlock);
+        view.count = series->count;
+        view.offset = series->offset;
+    } while (seqlock_read_retry(&series->seqlock, sequence));
+    return view;
+}
+
+/// Creates a decimation pyramid
+void series_pyramid_make(SeriesPyramid *pyramid, MemoryArena *arena, f64 const *xs, f64 const *ys, usize count) {
+    pyramid->levels[0] = (SeriesPyramidLevel) { xs, ys, count };
+    pyramid->level_count = 1;
+
+    // Buckets of the previous level, the samples are buckets of their own
+    usize buckets = count;
+    usize stride = 1;
+    while (buckets > 1 && pyramid->level_count < SERIES_PYRAMID_LEVELS) {
+        SeriesPyramidLevel const *previous = pyramid->levels + pyramid->level_count - 1;
+        usize const merged = (buckets + 1) / 2;
+        f64 *level_xs = (f64 *) memory_arena_alloc(arena, sizeof(f64) * 2 * merged);
+        f64 *level_ys = (f64 *) memory_arena_alloc(arena, sizeof(f64) * 2 * merged);
+        for (usize i = 0; i < merged; ++i) {
+            usize const left = 2 * i;
+            usize const right = left + 1 < buckets ? left + 1 : left;
+
+            // The minimum of a bucket is its first point and the maximum its last one
+            usize const last = stride - 1;
+            f64 const minimum = fmin(previous->ys[left * stride], previous->ys[right * stride]);
+            f64 const maximum = fmax(previous->ys[left * stride + last], previous->ys[right * stride + last]);
+            level_xs[2 * i] = previous->xs[left * stride];
+            level_xs[2 * i + 1] = previous->xs[left * stride];
+            level_ys[2 * i] = minimum;
+            level_ys[2 * i + 1] = maximum;
+        }
+
+        pyramid->levels[pyramid->level_count++] = (SeriesPyramidLevel) { level_xs, level_ys, 2 * merged };
+        buckets = merged;
+        stride = 2;
+    }
+}
+
+/// Finds the first point of the level whose x value is not less than the specified one
+static usize series_pyramid_lower_bound(SeriesPyramidLevel const *level, f64 x) {
+    usize first = 0;
+    usize last = level->count;
+    while (first < last) {
+        usize const middle = first + (last - first) / 2;
+        if (level->xs[middle] < x) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+/// Selects the finest level that draws the x range with at most two points per pixel
+SeriesPyramidLevel series_pyramid_select(SeriesPyramid const *pyramid, f64 from, f64 to, usize pixels) {
+    SeriesPyramidLevel selected = { 0 };
+    for (usize i = 0; i < pyramid->level_count; ++i) {
+        SeriesPyramidLevel const *level = pyramid->levels + i;
+        usize const margin = i == 0 ? 1 : 2;
+        usize first = series_pyramid_lower_bound(level, from);
+        usize last = series_pyramid_lower_bound(level, to);
+        first = first > margin ? first - margin : 0;
+        last = last + margin < level->count ? last + margin : level->count;
+
+        // Points of a bucket come in pairs, a slice never starts with the maximum
+        first -= first % margin;
+        selected = (SeriesPyramidLevel) { level->xs + first, level->ys + first, last - first };
+        if (selected.count <= 2 * pixels) {
+            break;
+        }
+    }
+    return selected;
+}
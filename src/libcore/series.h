@@ -0,0 +1,111 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef CORE_SERIES_H
+#define CORE_SERIES_H
+
+#include <solaris/arena.h>
+
+#include "arch/thread.h"
+
+/// Fixed capacity ring buffer of timestamped samples, stored as separate timestamp and
+/// value arrays so that plotting libraries can consume them in place. A single thread
+/// pushes while other threads read through a view.
+typedef struct TimeSeries {
+    f64 *timestamps;
+    f64 *values;
+    usize capacity;
+
+    /// Number of valid samples, at most the capacity
+    usize count;
+
+    /// Index of the oldest sample once the buffer wrapped around
+    usize offset;
+
+    /// Guards count and offset
+    SeqLock seqlock;
+} TimeSeries;
+
+/// A consistent view onto a time series, element i is found at (offset + i) % count
+typedef struct TimeSeriesView {
+    f64 const *timestamps;
+    f64 const *values;
+    usize count;
+    usize offset;
+} TimeSeriesView;
+
+/// Creates a new time series
+/// @param series The time series
+/// @param arena The arena for the sample storage
+/// @param capacity The maximum number of samples, older samples are overwritten
+void time_series_make(TimeSeries *series, MemoryArena *arena, usize capacity);
+
+/// Appends a sample, overwrites the oldest sample if the series is full
+/// @param series The time series
+/// @param timestamp The timestamp of the sample
+/// @param value The value of the sample
+void time_series_push(TimeSeries *series, f64 timestamp, f64 value);
+
+/// Retrieves a view onto the samples without taking a lock
+/// @note The writer may overwrite the oldest sample while the view is in use
+/// @param series The time series
+/// @return The view
+TimeSeriesView time_series_view(TimeSeries const *series);
+
+enum {
+    /// Maximum number of levels of a decimation pyramid, enough for 2^23 samples
+    SERIES_PYRAMID_LEVELS = 24,
+};
+
+/// A level of a decimation pyramid. Level zero holds the samples, every higher level holds
+/// the minimum and the maximum of buckets of 2^level samples as two consecutive points.
+typedef struct SeriesPyramidLevel {
+    f64 const *xs;
+    f64 const *ys;
+    usize count;
+} SeriesPyramidLevel;
+
+/// Min/max decimation pyramid over a series with ascending x values, plotting a level instead of
+/// the samples keeps the extremes visible while the cost depends on the pixels rather than the samples
+typedef struct SeriesPyramid {
+    SeriesPyramidLevel levels[SERIES_PYRAMID_LEVELS];
+    usize level_count;
+} SeriesPyramid;
+
+/// Creates a decimation pyramid, the samples are referenced and must outlive the pyramid
+/// @param pyramid The pyramid
+/// @param arena The arena for the higher levels
+/// @param xs The ascending x values of the samples
+/// @param ys The y values of the samples
+/// @param count The number of samples
+void series_pyramid_make(SeriesPyramid *pyramid, MemoryArena *arena, f64 const *xs, f64 const *ys, usize count);
+
+/// Selects the finest level that draws the x range with at most two points per pixel
+/// @param pyramid The pyramid
+/// @param from The start of the visible x range
+/// @param to The end of the visible x range
+/// @param pixels The width of the plot in pixels
+/// @return The part of the level that covers the range, including one bucket on either side
+SeriesPyramidLevel series_pyramid_select(SeriesPyramid const *pyramid, f64 from, f64 to, usize pixels);
+
+#endif// CORE_SERIES_H
@@ -126,3 +126,49 @@ String string_new_empty(MemoryArena *arena, ssize length) {
     memset(result.base, 0, length);
     return result;
 }
+
+/// Creates a new StringBuilder that grows inside the arena
+void string_builder_make(StringBuilder *builder, MemoryArena *arena, ssize capacity) {
+    builder->arena = arena;
+    builder->data = nil;
+    builder->length = 0;
+    builder->capacity = 0;
+    string_builder_reserve(builder, capacity);
+}
+
+/// Ensures that the builder can hold the specified amount of bytes
+void string_builder_reserve(StringBuilder *builder, ssize capacity) {
+    if (capacity <= builder->capacity && builder->data != nil) {
+        return;
+    }
+
+    // One additional byte for the zero terminator
+    char *data = (char *) memory_arena_alloc(builder->arena, capacity + 1);
+    if (builder->length > 0) {
+        memcpy(data, builder->data, builder->length);
+    }
+    data[builder->length] = 0;
+    builder->data = data;
+    builder->capacity = capacity;
+}
+
+/// Appends data to the builder
+void string_builder_append(StringBuilder *builder, const char *data, ssize length) {
+    ssize const required = builder->length + length;
+    if (required > builder->capacity) {
+        ssize capacity = builder->capacity > 0 ? builder->capacity * 2 : 64;
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        string_builder_reserve(builder, capacity);
+    }
+
+    memcpy(builder->data + builder->length, data, length);
+    builder->length = required;
+    builder->data[builder->length] = 0;
+}
+
+/// Retrieves the built String, which references the builder data
+String string_builder_string(StringBuilder const *builder) {
+    return (String){ .base = builder->data, .length = builder->length };
+}
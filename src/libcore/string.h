@@ -105,4 +105,38 @@ String string_new(MemoryArena *arena, const char *data, ssize length);
 ///       strings see StringView
 String string_new_empty(MemoryArena *arena, ssize length);
 
+typedef struct StringBuilder {
+    MemoryArena *arena;
+    char *data;
+    ssize length;
+    ssize capacity;
+} StringBuilder;
+
+/// Creates a new StringBuilder that grows inside the arena
+/// @param builder The builder handle
+/// @param arena The arena for the allocations
+/// @param capacity The initial capacity in bytes
+///
+/// @note The data of the builder is always zero terminated. Growing
+///       the builder leaves the previous block inside the arena until
+///       the arena is cleared, so the initial capacity should be chosen
+///       with care
+void string_builder_make(StringBuilder *builder, MemoryArena *arena, ssize capacity);
+
+/// Ensures that the builder can hold the specified amount of bytes
+/// @param builder The builder handle
+/// @param capacity The capacity in bytes
+void string_builder_reserve(StringBuilder *builder, ssize capacity);
+
+/// Appends data to the builder
+/// @param builder The builder handle
+/// @param data The data
+/// @param length The length of the data
+void string_builder_append(StringBuilder *builder, const char *data, ssize length);
+
+/// Retrieves the built String, which references the builder data
+/// @param builder The builder handle
+/// @return String instance
+String string_builder_string(StringBuilder const *builder);
+
 #endif// CORE_STRING_H
@@ -23,24 +23,45 @@
 
 #include "timer.h"
 
+#ifdef CORE_PLATFORM_WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
 /// Creates a new timer
 void timer_make(Timer *timer) {
-    timer->start = 0;
-    timer->end = 0;
+    timer->start = 0.0;
+    timer->end = 0.0;
 }
 
 /// Starts the timer
 void timer_start(Timer *timer) {
-    timer->start = clock();
+    timer->start = timer_now();
     timer->end = timer->start;
 }
 
 /// Ends the timer
 void timer_end(Timer *timer) {
-    timer->end = clock();
+    timer->end = timer_now();
 }
 
 /// Computes the elapsed milliseconds of the timer
 f64 timer_elapsed(Timer *timer) {
-    return ((f64) (timer->end - timer->start)) / CLOCKS_PER_SEC * 1000.0;
+    return timer->end - timer->start;
+}
+
+/// Retrieves the current time of a monotonic clock
+f64 timer_now(void) {
+#ifdef CORE_PLATFORM_WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (f64) counter.QuadPart / (f64) frequency.QuadPart * 1000.0;
+#else
+    struct timespec ts = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64) ts.tv_sec * 1000.0 + (f64) ts.tv_nsec / 1000000.0;
+#endif
 }
@@ -24,13 +24,12 @@
 #ifndef CORE_TIMER_H
 #define CORE_TIMER_H
 
-#include <time.h>
-
 #include "types.h"
 
+/// Measures wall time on the monotonic clock
 typedef struct Timer {
-    clock_t start;
-    clock_t end;
+    f64 start;
+    f64 end;
 } Timer;
 
 /// Creates a new timer
@@ -50,4 +49,9 @@ void timer_end(Timer *timer);
 /// @return The elapsed milliseconds between start and end
 f64 timer_elapsed(Timer *timer);
 
+/// Retrieves the current time of a monotonic clock, which is not
+/// affected by changes of the system time
+/// @return The time in milliseconds since an unspecified point in the past
+f64 timer_now(void);
+
 #endif// CORE_TIMER_H
@@ -36,7 +36,7 @@ static void *geo_location_fetch_task(void *args) {
     GeoLocation *location = (GeoLocation *) args;
 
     HttpResponse response = { 0 };
-    if (!http_client_get(&response, location->arena, "ip-api.com/json") || response.code != HTTP_OK) {
+    if (!http_client_get(&response, location->arena, "ip-api.com/json", HTTP_FLAGS_NONE) || response.code != HTTP_OK) {
         return nil;
     }
 
@@ -0,0 +1,349 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <math.h>
+#include <string.h>
+
+#include "observe.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define OBSERVE_INSTRUCTION_SET "avx"
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OBSERVE_INSTRUCTION_SET "sse2"
+#else
+#define OBSERVE_INSTRUCTION_SET "scalar"
+#endif
+
+#define OBSERVE_PI 3.14159265358979323846
+#define OBSERVE_RADIANS (OBSERVE_PI / 180.0)
+#define OBSERVE_DEGREES (180.0 / OBSERVE_PI)
+
+/// Seconds since the unix epoch at the J2000 epoch
+#define OBSERVE_J2000 946728000.0
+
+/// Adding and subtracting 1.5 * 2^52 rounds to the nearest integer in the current rounding mode
+#define OBSERVE_ROUND 6755399441055744.0
+
+// The lanes hold as many doubles as the instruction set allows, the kernel below is written
+// once against these helpers. The polynomials are the double precision ones from cephes.
+
+#if defined(__AVX__)
+
+enum { OBSERVE_LANES = 4 };
+typedef __m256d Lanes;
+typedef __m256d LaneMask;
+
+static inline Lanes lanes_set(f64 value) { return _mm256_set1_pd(value); }
+static inline Lanes lanes_load(f64 const *values) { return _mm256_loadu_pd(values); }
+static inline void lanes_store(f64 *values, Lanes lanes) { _mm256_storeu_pd(values, lanes); }
+static inline Lanes lanes_add(Lanes a, Lanes b) { return _mm256_add_pd(a, b); }
+static inline Lanes lanes_sub(Lanes a, Lanes b) { return _mm256_sub_pd(a, b); }
+static inline Lanes lanes_mul(Lanes a, Lanes b) { return _mm256_mul_pd(a, b); }
+static inline Lanes lanes_div(Lanes a, Lanes b) { return _mm256_div_pd(a, b); }
+static inline Lanes lanes_sqrt(Lanes a) { return _mm256_sqrt_pd(a); }
+static inline Lanes lanes_max(Lanes a, Lanes b) { return _mm256_max_pd(a, b); }
+static inline LaneMask lanes_lt(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+static inline LaneMask lanes_neq(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+// The compare masks are all ones or all zeros per lane, so a bitwise select matches _mm256_blendv_pd,
+// which was slower in the benchmarks with GCC
+static inline Lanes lanes_select(LaneMask mask, Lanes a, Lanes b) {
+    return _mm256_or_pd(_mm256_and_pd(mask, a), _mm256_andnot_pd(mask, b));
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+enum { OBSERVE_LANES = 2 };
+typedef __m128d Lanes;
+typedef __m128d LaneMask;
+
+static inline Lanes lanes_set(f64 value) { return _mm_set1_pd(value); }
+static inline Lanes lanes_load(f64 const *values) { return _mm_loadu_pd(values); }
+static inline void lanes_store(f64 *values, Lanes lanes) { _mm_storeu_pd(values, lanes); }
+static inline Lanes lanes_add(Lanes a, Lanes b) { return _mm_add_pd(a, b); }
+static inline Lanes lanes_sub(Lanes a, Lanes b) { return _mm_sub_pd(a, b); }
+static inline Lanes lanes_mul(Lanes a, Lanes b) { return _mm_mul_pd(a, b); }
+static inline Lanes lanes_div(Lanes a, Lanes b) { return _mm_div_pd(a, b); }
+static inline Lanes lanes_sqrt(Lanes a) { return _mm_sqrt_pd(a); }
+static inline Lanes lanes_max(Lanes a, Lanes b) { return _mm_max_pd(a, b); }
+static inline LaneMask lanes_lt(Lanes a, Lanes b) { return _mm_cmplt_pd(a, b); }
+static inline LaneMask lanes_neq(Lanes a, Lanes b) { return _mm_cmpneq_pd(a, b); }
+static inline Lanes lanes_select(LaneMask mask, Lanes a, Lanes b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+#else
+
+enum { OBSERVE_LANES = 1 };
+typedef f64 Lanes;
+typedef b8 LaneMask;
+
+static inline Lanes lanes_set(f64 value) { return value; }
+static inline Lanes lanes_load(f64 const *values) { return *values; }
+static inline void lanes_store(f64 *values, Lanes lanes) { *values = lanes; }
+static inline Lanes lanes_add(Lanes a, Lanes b) { return a + b; }
+static inline Lanes lanes_sub(Lanes a, Lanes b) { return a - b; }
+static inline Lanes lanes_mul(Lanes a, Lanes b) { return a * b; }
+static inline Lanes lanes_div(Lanes a, Lanes b) { return a / b; }
+static inline Lanes lanes_sqrt(Lanes a) { return sqrt(a); }
+static inline Lanes lanes_max(Lanes a, Lanes b) { return a > b ? a : b; }
+static inline LaneMask lanes_lt(Lanes a, Lanes b) { return a < b; }
+static inline LaneMask lanes_neq(Lanes a, Lanes b) { return a != b; }
+static inline Lanes lanes_select(LaneMask mask, Lanes a, Lanes b) { return mask ? a : b; }
+
+#endif
+
+/// Multiply and add, kept separate so that compilers do not contract it differently per lane width
+static inline Lanes lanes_madd(Lanes a, Lanes b, Lanes c) {
+    return lanes_add(lanes_mul(a, b), c);
+}
+
+/// Rounds to the nearest integer, valid for magnitudes below 2^51
+static inline Lanes lanes_round(Lanes x) {
+    Lanes const magic = lanes_set(OBSERVE_ROUND);
+    return lanes_sub(lanes_add(x, magic), magic);
+}
+
+/// Checks which lanes hold an odd integer
+static inline LaneMask lanes_odd(Lanes x) {
+    Lanes const half = lanes_mul(x, lanes_set(0.5));
+    return lanes_neq(half, lanes_round(half));
+}
+
+/// Divides integers by two and rounds towards negative infinity
+static inline Lanes lanes_half_floor(Lanes x) {
+    Lanes const even = lanes_sub(x, lanes_select(lanes_odd(x), lanes_set(1.0), lanes_set(0.0)));
+    return lanes_mul(even, lanes_set(0.5));
+}
+
+/// Computes the sine and cosine of angles in radians, the angles are reduced to a quarter
+/// turn around zero where the polynomials are accurate
+static inline void lanes_sincos(Lanes x, Lanes *sine, Lanes *cosine) {
+    Lanes const quadrant = lanes_round(lanes_mul(x, lanes_set(2.0 / OBSERVE_PI)));
+    Lanes r = lanes_sub(x, lanes_mul(quadrant, lanes_set(1.57079625129699707031)));
+    r = lanes_sub(r, lanes_mul(quadrant, lanes_set(7.54978941586159635336e-8)));
+    r = lanes_sub(r, lanes_mul(quadrant, lanes_set(5.39030285815811905290e-15)));
+    Lanes const z = lanes_mul(r, r);
+
+    Lanes s = lanes_set(1.58962301576546568060e-10);
+    s = lanes_madd(s, z, lanes_set(-2.50507477628578072866e-8));
+    s = lanes_madd(s, z, lanes_set(2.75573136213857245213e-6));
+    s = lanes_madd(s, z, lanes_set(-1.98412698295895385996e-4));
+    s = lanes_madd(s, z, lanes_set(8.33333333332211858878e-3));
+    s = lanes_madd(s, z, lanes_set(-1.66666666666666307295e-1));
+    s = lanes_madd(lanes_mul(s, z), r, r);
+
+    Lanes c = lanes_set(-1.13585365213876817300e-11);
+    c = lanes_madd(c, z, lanes_set(2.08757008419747316778e-9));
+    c = lanes_madd(c, z, lanes_set(-2.75573141792967388112e-7));
+    c = lanes_madd(c, z, lanes_set(2.48015872888517045348e-5));
+    c = lanes_madd(c, z, lanes_set(-1.38888888888730564116e-3));
+    c = lanes_madd(c, z, lanes_set(4.16666666666665929218e-2));
+    c = lanes_madd(lanes_mul(c, z), z, lanes_sub(lanes_set(1.0), lanes_mul(z, lanes_set(0.5))));
+
+    // Odd quadrants swap sine and cosine, the sine is negative in quadrants two and three
+    // and the cosine in quadrants one and two
+    LaneMask const swap = lanes_odd(quadrant);
+    LaneMask const sine_negative = lanes_odd(lanes_half_floor(quadrant));
+    LaneMask const cosine_negative = lanes_odd(lanes_half_floor(lanes_add(quadrant, lanes_set(1.0))));
+    Lanes const sv = lanes_select(swap, c, s);
+    Lanes const cv = lanes_select(swap, s, c);
+    Lanes const zero = lanes_set(0.0);
+    *sine = lanes_select(sine_negative, lanes_sub(zero, sv), sv);
+    *cosine = lanes_select(cosine_negative, lanes_sub(zero, cv), cv);
+}
+
+/// Computes the arc tangent in radians
+static inline Lanes lanes_atan(Lanes x) {
+    Lanes const zero = lanes_set(0.0);
+    Lanes const one = lanes_set(1.0);
+    LaneMask const negative = lanes_lt(x, zero);
+    Lanes const a = lanes_select(negative, lanes_sub(zero, x), x);
+
+    // Arguments above tan(pi / 8) and tan(3 pi / 8) are reflected towards zero
+    LaneMask const middle = lanes_lt(lanes_set(0.66), a);
+    Lanes reduced = lanes_select(middle, lanes_div(lanes_sub(a, one), lanes_add(a, one)), a);
+    Lanes offset = lanes_select(middle, lanes_set(OBSERVE_PI / 4.0), zero);
+    Lanes correction = lanes_select(middle, lanes_set(0.5 * 6.123233995736765886130e-17), zero);
+
+    LaneMask const large = lanes_lt(lanes_set(2.41421356237309504880), a);
+    reduced = lanes_select(large, lanes_div(lanes_sub(zero, one), a), reduced);
+    offset = lanes_select(large, lanes_set(OBSERVE_PI / 2.0), offset);
+    correction = lanes_select(large, lanes_set(6.123233995736765886130e-17), correction);
+
+    Lanes const z = lanes_mul(reduced, reduced);
+    Lanes p = lanes_set(-8.750608600031904122785e-1);
+    p = lanes_madd(p, z, lanes_set(-1.615753718733365076637e1));
+    p = lanes_madd(p, z, lanes_set(-7.500855792314704667340e1));
+    p = lanes_madd(p, z, lanes_set(-1.228866684490136173410e2));
+    p = lanes_madd(p, z, lanes_set(-6.485021904942025371773e1));
+
+    Lanes q = lanes_add(z, lanes_set(2.485846490142306297962e1));
+    q = lanes_madd(q, z, lanes_set(1.650270098316988542046e2));
+    q = lanes_madd(q, z, lanes_set(4.328810604912902668951e2));
+    q = lanes_madd(q, z, lanes_set(4.853903996359136964868e2));
+    q = lanes_madd(q, z, lanes_set(1.945506571482613964425e2));
+
+    Lanes const ratio = lanes_div(lanes_mul(z, p), q);
+    Lanes const result = lanes_add(offset, lanes_add(lanes_madd(reduced, ratio, reduced), correction));
+    return lanes_select(negative, lanes_sub(zero, result), result);
+}
+
+/// Computes the arc tangent of y / x in radians between -pi and pi, zero if both are zero
+static inline Lanes lanes_atan2(Lanes y, Lanes x) {
+    Lanes const zero = lanes_set(0.0);
+    Lanes angle = lanes_atan(lanes_div(y, x));
+    Lanes const half_turn = lanes_select(lanes_lt(y, zero), lanes_set(-OBSERVE_PI), lanes_set(OBSERVE_PI));
+    angle = lanes_select(lanes_lt(x, zero), lanes_add(angle, half_turn), angle);
+    return lanes_select(lanes_neq(angle, angle), zero, angle);
+}
+
+/// The terms of one timestamp that are broadcast into every lane
+typedef struct ObserveLanesTime {
+    Lanes sin_sidereal;
+    Lanes cos_sidereal;
+    Lanes sin_latitude;
+    Lanes cos_latitude;
+} ObserveLanesTime;
+
+/// Transforms one set of lanes, the hour angle terms follow from the angle difference of the
+/// sidereal time and the right ascension so no trigonometric function is evaluated per position
+static inline void observe_lanes(ObserveLanesTime const *time, f64 const *sin_ra, f64 const *cos_ra,
+                                 f64 const *sin_dec, f64 const *cos_dec, f64 *altitudes, f64 *azimuths) {
+    Lanes const sra = lanes_load(sin_ra);
+    Lanes const cra = lanes_load(cos_ra);
+    Lanes const sd = lanes_load(sin_dec);
+    Lanes const cd = lanes_load(cos_dec);
+
+    Lanes const sin_hour = lanes_sub(lanes_mul(time->sin_sidereal, cra), lanes_mul(time->cos_sidereal, sra));
+    Lanes const cos_hour = lanes_madd(time->cos_sidereal, cra, lanes_mul(time->sin_sidereal, sra));
+    Lanes const cd_cos_hour = lanes_mul(cd, cos_hour);
+
+    Lanes const sin_altitude = lanes_madd(sd, time->sin_latitude, lanes_mul(cd_cos_hour, time->cos_latitude));
+    Lanes const cos_altitude =
+            lanes_sqrt(lanes_max(lanes_sub(lanes_set(1.0), lanes_mul(sin_altitude, sin_altitude)), lanes_set(0.0)));
+    Lanes const altitude = lanes_atan2(sin_altitude, cos_altitude);
+
+    lanes_store(altitudes, lanes_mul(altitude, lanes_set(OBSERVE_DEGREES)));
+    if (azimuths == nil) {
+        return;
+    }
+
+    Lanes const east = lanes_sub(lanes_set(0.0), lanes_mul(cd, sin_hour));
+    Lanes const north = lanes_sub(lanes_mul(sd, time->cos_latitude), lanes_mul(cd_cos_hour, time->sin_latitude));
+    Lanes azimuth = lanes_atan2(east, north);
+    azimuth = lanes_select(lanes_lt(azimuth, lanes_set(0.0)), lanes_add(azimuth, lanes_set(2.0 * OBSERVE_PI)),
+                           azimuth);
+
+    lanes_store(azimuths, lanes_mul(azimuth, lanes_set(OBSERVE_DEGREES)));
+}
+
+/// Computes the sine and cosine of angles in degrees
+static void observe_sincos(f64 const *degrees, usize count, f64 *sine, f64 *cosine) {
+    usize i = 0;
+    for (; i + OBSERVE_LANES <= count; i += OBSERVE_LANES) {
+        Lanes s, c;
+        lanes_sincos(lanes_mul(lanes_load(degrees + i), lanes_set(OBSERVE_RADIANS)), &s, &c);
+        lanes_store(sine + i, s);
+        lanes_store(cosine + i, c);
+    }
+    for (; i < count; ++i) {
+        sine[i] = sin(degrees[i] * OBSERVE_RADIANS);
+        cosine[i] = cos(degrees[i] * OBSERVE_RADIANS);
+    }
+}
+
+/// Computes the local mean sidereal time
+f64 observe_sidereal_time(f64 seconds, f64 longitude) {
+    f64 const days = (seconds - OBSERVE_J2000) / 86400.0;
+    f64 const centuries = days / 36525.0;
+    f64 const mean = 280.46061837 + 360.98564736629 * days + 0.000387933 * centuries * centuries -
+                     centuries * centuries * centuries / 38710000.0;
+    f64 const local = fmod(mean + longitude, 360.0);
+    return local < 0.0 ? local + 360.0 : local;
+}
+
+/// Precomputes the sidereal terms of the timestamps
+void observe_batch_make(ObserveBatch *batch, MemoryArena *arena, Geographic const *observer, f64 const *times,
+                        usize time_count) {
+    batch->sin_sidereal = (f64 *) memory_arena_alloc(arena, sizeof(f64) * time_count);
+    batch->cos_sidereal = (f64 *) memory_arena_alloc(arena, sizeof(f64) * time_count);
+    batch->time_count = time_count;
+    batch->sin_latitude = sin(observer->latitude * OBSERVE_RADIANS);
+    batch->cos_latitude = cos(observer->latitude * OBSERVE_RADIANS);
+    for (usize t = 0; t < time_count; ++t) {
+        f64 const sidereal = observe_sidereal_time(times[t], observer->longitude) * OBSERVE_RADIANS;
+        batch->sin_sidereal[t] = sin(sidereal);
+        batch->cos_sidereal[t] = cos(sidereal);
+    }
+}
+
+/// Transforms equatorial positions into horizontal positions at every timestamp of the batch
+void observe_batch_horizontal(ObserveBatch const *batch, MemoryArena *arena, f64 const *right_ascensions,
+                              f64 const *declinations, usize count, f64 *altitudes, f64 *azimuths) {
+    // The object terms are computed once and reused for every timestamp
+    f64 *sin_ra = (f64 *) memory_arena_alloc(arena, sizeof(f64) * count);
+    f64 *cos_ra = (f64 *) memory_arena_alloc(arena, sizeof(f64) * count);
+    f64 *sin_dec = (f64 *) memory_arena_alloc(arena, sizeof(f64) * count);
+    f64 *cos_dec = (f64 *) memory_arena_alloc(arena, sizeof(f64) * count);
+    observe_sincos(right_ascensions, count, sin_ra, cos_ra);
+    observe_sincos(declinations, count, sin_dec, cos_dec);
+
+    usize const whole = count - count % OBSERVE_LANES;
+    for (usize t = 0; t < batch->time_count; ++t) {
+        ObserveLanesTime time = {
+            .sin_sidereal = lanes_set(batch->sin_sidereal[t]),
+            .cos_sidereal = lanes_set(batch->cos_sidereal[t]),
+            .sin_latitude = lanes_set(batch->sin_latitude),
+            .cos_latitude = lanes_set(batch->cos_latitude),
+        };
+        f64 *altitude_row = altitudes + t * count;
+        f64 *azimuth_row = azimuths != nil ? azimuths + t * count : nil;
+        for (usize i = 0; i < whole; i += OBSERVE_LANES) {
+            observe_lanes(&time, sin_ra + i, cos_ra + i, sin_dec + i, cos_dec + i, altitude_row + i,
+                          azimuth_row != nil ? azimuth_row + i : nil);
+        }
+
+        // The remaining positions are padded to a full set of lanes
+        if (whole < count) {
+            usize const rest = count - whole;
+            f64 terms[4][OBSERVE_LANES] = { 0 };
+            f64 outputs[2][OBSERVE_LANES];
+            memcpy(terms[0], sin_ra + whole, sizeof(f64) * rest);
+            memcpy(terms[1], cos_ra + whole, sizeof(f64) * rest);
+            memcpy(terms[2], sin_dec + whole, sizeof(f64) * rest);
+            memcpy(terms[3], cos_dec + whole, sizeof(f64) * rest);
+            observe_lanes(&time, terms[0], terms[1], terms[2], terms[3], outputs[0], outputs[1]);
+            memcpy(altitude_row + whole, outputs[0], sizeof(f64) * rest);
+            if (azimuth_row != nil) {
+                memcpy(azimuth_row + whole, outputs[1], sizeof(f64) * rest);
+            }
+        }
+    }
+}
+
+/// Retrieves the instruction set the batch kernel was compiled for
+const char *observe_batch_instruction_set(void) {
+    return OBSERVE_INSTRUCTION_SET;
+}
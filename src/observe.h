@@ -0,0 +1,75 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef KOPERNIKUS_OBSERVE_H
+#define KOPERNIKUS_OBSERVE_H
+
+#include <solaris/arena.h>
+#include <solaris/object.h>
+
+/// Terms of the horizontal transform that only depend on the observer and the time, they
+/// are shared by every object that is transformed
+typedef struct ObserveBatch {
+    /// Sine and cosine of the local sidereal time of every timestamp
+    f64 *sin_sidereal;
+    f64 *cos_sidereal;
+    usize time_count;
+
+    /// Sine and cosine of the latitude of the observer
+    f64 sin_latitude;
+    f64 cos_latitude;
+} ObserveBatch;
+
+/// Computes the local mean sidereal time
+/// @param seconds The time in seconds since the unix epoch
+/// @param longitude The longitude of the observer in degrees, positive towards east
+/// @return The local sidereal time in degrees between 0 and 360
+f64 observe_sidereal_time(f64 seconds, f64 longitude);
+
+/// Precomputes the sidereal terms of the timestamps
+/// @param batch The batch
+/// @param arena The arena for the terms
+/// @param observer The location of the observer
+/// @param times The timestamps in seconds since the unix epoch
+/// @param time_count The number of timestamps
+void observe_batch_make(ObserveBatch *batch, MemoryArena *arena, Geographic const *observer, f64 const *times,
+                        usize time_count);
+
+/// Transforms equatorial positions into horizontal positions at every timestamp of the batch,
+/// the outputs are laid out by time so position i at timestamp t is found at t * count + i
+/// @param batch The batch
+/// @param arena The arena for the per object terms
+/// @param right_ascensions The right ascensions in degrees
+/// @param declinations The declinations in degrees
+/// @param count The number of positions
+/// @param altitudes The altitudes in degrees, time_count * count values
+/// @param azimuths The azimuths in degrees from north towards east, time_count * count values,
+///                 nil if only the altitudes are needed
+void observe_batch_horizontal(ObserveBatch const *batch, MemoryArena *arena, f64 const *right_ascensions,
+                              f64 const *declinations, usize count, f64 *altitudes, f64 *azimuths);
+
+/// Retrieves the instruction set the batch kernel was compiled for
+/// @return "avx", "sse2" or "scalar"
+const char *observe_batch_instruction_set(void);
+
+#endif// KOPERNIKUS_OBSERVE_H
@@ -24,6 +24,7 @@
 #include "sequencer.h"
 
 #include <assert.h>
+#include <math.h>
 
 #include "browser.h"
 #include "skymap.h"
@@ -46,6 +47,7 @@ static const char *SEQUENCE_NODE_POPUP_ID = "##CreateSequenceNode";
 static const f32 SEQUENCE_NODE_WIDTH = 100.0f;
 static const f32 TIMELINE_PREVIEW_WIDTH = 180.0f;
 static const f32 TIMELINE_PREVIEW_HEIGHT = 90.0f;
+static const usize TIMELINE_PLOT_MIN_SAMPLES = 64;
 static u32 xorshift_state = 1337;
 
 /* The state must be initialized to non-zero */
@@ -78,6 +80,7 @@ SequenceNode *sequence_node_make_track(Sequencer *sequencer, SequenceNodeTrackDa
     node->next = nil;
     node->type = SEQUENCE_NODE_TRACK;
     node->track = *data;
+    node->track.cache = (SequenceTrackCache) { 0 };
     node->id = sequencer->node_count + 1;
     node->previous_id = (s32) xorshift32();
     node->next_id = (s32) xorshift32();
@@ -109,7 +112,7 @@ SequenceLink *sequence_link_make(Sequencer *sequencer, s32 from, s32 to) {
 }
 
 /// Create a new sequencer
-void sequencer_make(Sequencer *sequencer, ObjectBrowser *browser) {
+void sequencer_make(Sequencer *sequencer, ObjectBrowser *browser, JobPool *jobs) {
     sequencer->node_head = nil;
     sequencer->node_tail = nil;
     sequencer->node_count = 0;
@@ -118,30 +121,57 @@ void sequencer_make(Sequencer *sequencer, ObjectBrowser *browser) {
     sequencer->link_count = 0;
     sequencer->has_start_node = false;
     sequencer->arena = memory_arena_identity(ALIGNMENT8);
-    sequencer->position_arena = memory_arena_identity(ALIGNMENT1);
     sequencer->show_editor = true;
     sequencer->show_timeline = true;
     sequencer->browser = browser;
+    sequencer->jobs = jobs;
     renderer_create(&sequencer->renderer, TIMELINE_PREVIEW_WIDTH, TIMELINE_PREVIEW_HEIGHT);
 }
 
+/// Releases the cached positions of a track node
+static void sequence_track_cache_release(SequenceTrackCache *cache) {
+    if (cache->curve != nil) {
+        ephemeris_curve_release(cache->curve);
+        cache->curve = nil;
+    }
+    if (cache->pending != nil) {
+        ephemeris_curve_release(cache->pending);
+        cache->pending = nil;
+    }
+    if (cache->detail != nil) {
+        ephemeris_curve_release(cache->detail);
+        cache->detail = nil;
+    }
+}
+
+/// Releases the cached positions of all track nodes
+static void sequencer_destroy_caches(Sequencer *sequencer) {
+    for (SequenceNode *it = sequencer->node_head; it != nil; it = it->next) {
+        if (it->type == SEQUENCE_NODE_TRACK) {
+            sequence_track_cache_release(&it->track.cache);
+        }
+    }
+}
+
 /// Destroy the sequencer
 void sequencer_destroy(Sequencer *sequencer) {
     // No need to traverse the list and free the nodes individually,
-    // since all live inside the arena which we can free.
+    // since all live inside the arena which we can free. Only the
+    // cached positions live outside.
+    sequencer_destroy_caches(sequencer);
     sequencer->node_head = nil;
     sequencer->node_tail = nil;
     sequencer->node_count = 0;
     sequencer->link_head = nil;
     sequencer->link_tail = nil;
     sequencer->link_count = 0;
-    memory_arena_destroy(&sequencer->position_arena);
     memory_arena_destroy(&sequencer->arena);
     renderer_destroy(&sequencer->renderer);
 }
 
 /// Clear the sequencer
 void sequencer_clear(Sequencer *sequencer) {
+    sequencer_destroy_caches(sequencer);
     sequencer->node_head = nil;
     sequencer->node_tail = nil;
     sequencer->node_count = 0;
@@ -177,6 +207,9 @@ void sequencer_remove_node(Sequencer *sequencer, s32 node_id) {
             if (it->type == SEQUENCE_NODE_START) {
                 sequencer->has_start_node = false;
             }
+            if (it->type == SEQUENCE_NODE_TRACK) {
+                sequence_track_cache_release(&it->track.cache);
+            }
 
             if (it->previous != nil) {
                 it->previous->next = it->next;
@@ -475,20 +508,137 @@ void sequencer_format_date_time(StringBuffer *buffer, Time *time) {
     strftime(buffer->data, buffer->size, "%d.%m.%Y - %H:%M:%S", time_info);// Format the time as a string
 }
 
-/// Retrieves the unit conversion factor
-static f64 unit_conversion_factor(TimeUnit from, TimeUnit to) {
-    // Conversion factors to seconds for each unit
-    static const f64 seconds_per_unit[] = {
-        1.0,      // UNIT_SECONDS
-        60.0,     // UNIT_MINUTES
-        3600.0,   // UNIT_HOURS
-        86400.0,  // UNIT_DAYS
-        2629746.0,// UNIT_MONTHS (average month in seconds)
-        31556952.0// UNIT_YEARS (average year in seconds)
-    };
+/// The step (s) that spreads the specified number of samples over a span, positions are computed in whole seconds
+static usize sequencer_track_step(f64 span, usize samples) {
+    return (usize) fmax(ceil(span / (f64) samples), 1.0);
+}
+
+/// Requests the positions between two offsets (s) from the start of the node, the positions cover
+/// the whole range and their x values are seconds since the unix epoch
+static EphemerisCurve *sequencer_track_request(Sequencer *sequencer,
+                                               SequenceNodeTrackData const *data,
+                                               Time const *start,
+                                               f64 from,
+                                               f64 to,
+                                               usize step_size) {
+    GeoLocation const *location = &sequencer->browser->settings->location;
+    f64 const span = fmax(to - from, 0.0);
+
+    EphemerisRequest request = { 0 };
+    request.object = data->object;
+    request.start = *start;
+    time_add(&request.start, from, UNIT_SECONDS);
+    request.unit = UNIT_SECONDS;
+    request.step_size = step_size;
+    request.steps = (usize) ceil(span / (f64) step_size) + 1;
+    request.offset = (f64) time_unix(start) + from;
+    request.observer.latitude = location->latitude;
+    request.observer.longitude = location->longitude;
+    return ephemeris_curve_request(sequencer->jobs, &request);
+}
+
+/// Requests a coarse curve over the whole node if the object, the duration, the observer, the start
+/// rounded to the step of the curve or the width of the plot changed. The previous curve is shown
+/// until the new one is ready.
+/// @return Whether the object, the duration or the observer changed
+static b8 sequencer_track_update(Sequencer *sequencer,
+                                 SequenceNodeTrackData *data,
+                                 Time *start,
+                                 f64 duration,
+                                 usize pixels) {
+    SequenceTrackCache *cache = &data->cache;
+    GeoLocation const *location = &sequencer->browser->settings->location;
+    void const *target = data->object.classification == CLASSIFICATION_PLANET ? (void const *) data->object.planet
+                                                                              : (void const *) data->object.object;
+
+    // The width is rounded up to a power of two, resizing the window does not recompute every frame
+    usize resolution = TIMELINE_PLOT_MIN_SAMPLES;
+    while (resolution < pixels) {
+        resolution *= 2;
+    }
+
+    usize const step = sequencer_track_step(duration, resolution);
+    f64 const seconds = (f64) time_unix(start);
+    f64 const origin = floor(seconds / (f64) step) * (f64) step;
+
+    b8 const requested = cache->curve != nil || cache->pending != nil;
+    b8 const changed = !requested || cache->target != target || cache->duration.amount != data->duration.amount ||
+                       cache->duration.unit != data->duration.unit || cache->latitude != location->latitude ||
+                       cache->longitude != location->longitude;
+    if (changed || cache->origin != origin || cache->resolution != resolution) {
+        if (cache->pending != nil) {
+            ephemeris_curve_release(cache->pending);
+        }
+
+        // The finer positions describe the previous inputs, they stay valid if only the origin moved
+        if (changed && cache->detail != nil) {
+            ephemeris_curve_release(cache->detail);
+            cache->detail = nil;
+        }
+        cache->pending = sequencer_track_request(sequencer, data, start, origin - seconds, duration, step);
+        cache->target = target;
+        cache->duration = data->duration;
+        cache->latitude = location->latitude;
+        cache->longitude = location->longitude;
+        cache->origin = origin;
+        cache->resolution = resolution;
+    }
+
+    if (cache->pending != nil && ephemeris_curve_ready(cache->pending)) {
+        if (cache->curve != nil) {
+            ephemeris_curve_release(cache->curve);
+        }
+        cache->curve = cache->pending;
+        cache->pending = nil;
+    }
+    return changed;
+}
+
+/// Selects the curve for the visible range, a finer curve is requested once the coarse one has
+/// fewer samples than pixels in the range. The coarse curve is shown until the finer one is ready.
+static EphemerisCurve const *sequencer_track_detail(Sequencer *sequencer,
+                                                    SequenceNodeTrackData *data,
+                                                    Time *start,
+                                                    ImPlotRange const *visible,
+                                                    f64 duration,
+                                                    usize pixels) {
+    SequenceTrackCache *cache = &data->cache;
+    f64 const seconds = (f64) time_unix(start);
+    f64 const from = fmax(visible->Min, seconds);
+    f64 const to = fmin(visible->Max, seconds + duration);
+    f64 const span = fmax(to - from, 0.0);
+
+    // Positions are computed in whole seconds, there is nothing finer to refine to
+    f64 const wanted = fmax(span / (f64) pixels, 1.0);
+    if (cache->curve->step <= wanted) {
+        if (cache->detail != nil) {
+            ephemeris_curve_release(cache->detail);
+            cache->detail = nil;
+        }
+        return cache->curve;
+    }
+
+    EphemerisCurve *detail = cache->detail;
+    b8 const covers = detail != nil && detail->request.offset <= from &&
+                      detail->request.offset + (f64) (detail->count - 1) * detail->step >= to &&
+                      detail->step <= 2.0 * wanted;
+    if (!covers) {
+        if (detail != nil) {
+            ephemeris_curve_release(detail);
+        }
+
+        // Half a window of margin on either side keeps small pans from requesting again
+        f64 const margin_from = fmax(from - span / 2.0, seconds) - seconds;
+        f64 const margin_to = fmin(to + span / 2.0, seconds + duration) - seconds;
+        usize const step = sequencer_track_step(margin_to - margin_from, 2 * pixels);
+        cache->detail = sequencer_track_request(sequencer, data, start, margin_from, margin_to, step);
+    }
+    return ephemeris_curve_ready(cache->detail) ? cache->detail : cache->curve;
+}
 
-    // Conversion factor from 'from' unit to 'to' unit
-    return seconds_per_unit[from] / seconds_per_unit[to];
+/// Formats the time axis in seconds from the start of the node
+static int sequencer_track_format(f64 value, char *buffer, int size, void *data) {
+    return snprintf(buffer, (usize) size, "%g s", value - *(f64 const *) data);
 }
 
 static void sequencer_render_timeline_node_track(Sequencer *sequencer, SequenceNodeTrackData *data, Time *start) {
@@ -542,56 +692,70 @@ static void sequencer_render_timeline_node_track(Sequencer *sequencer, SequenceN
 
     igTableNextColumn();
 
-    memory_arena_clear(&sequencer->position_arena);
-
-    Geographic observer = { 0 };
-    observer.latitude = sequencer->browser->settings->location.latitude;
-    observer.longitude = sequencer->browser->settings->location.longitude;
-
-    ComputeSpecification compute = { 0 };
-    compute.date = *start;
-    compute.unit = data->duration.unit > UNIT_SECONDS ? data->duration.unit - 1 : UNIT_SECONDS;
-    compute.steps = (usize) time_difference(start, &end) * unit_conversion_factor(UNIT_SECONDS, compute.unit);
-    compute.step_size = 1;
-    compute.observer = observer;
-
-    ComputeResult result = { 0 };
-    switch (data->object.classification) {
-        case CLASSIFICATION_PLANET:
-            compute_geographic_planet(&sequencer->position_arena, &result, data->object.planet, &compute);
-            break;
-        default:
-            compute_geographic_fixed(&sequencer->position_arena, &result, data->object.object, &compute);
-            break;
+    ImVec2 plot_size = { 0 };
+    igGetContentRegionAvail(&plot_size);
+    usize const pixels = (usize) fmax(plot_size.x, 1.0);
+
+    f64 const duration = time_difference(start, &end);
+    f64 const seconds = (f64) time_unix(start);
+    b8 const changed = sequencer_track_update(sequencer, data, start, duration, pixels);
+
+    // The time axis can be zoomed, it is reset when the inputs of the node change and pans along when its start moves
+    SequenceTrackCache *cache = &data->cache;
+    if (changed || cache->curve == nil) {
+        cache->view_start = seconds;
+        cache->view_min = seconds;
+        cache->view_max = seconds + duration;
+    }
+    if (cache->curve == nil) {
+        ui_note("Computing positions...");
+        igEndTable();
+        return;
     }
 
     ImPlotFlags plot_flags = ImPlotFlags_NoFrame;
-    ImPlotAxisFlags axis_flags = ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_NoLabel | ImPlotAxisFlags_NoTickLabels;
-    usize count = compute.steps;
+    ImPlotAxisFlags axis_flags = ImPlotAxisFlags_NoLabel | ImPlotAxisFlags_NoTickLabels;
 
     Time now = time_now();
-    f64 now_mark = (f64) time_difference(start, &now);
+    f64 now_mark = (f64) time_unix(&now);
 
     ImVec4 COLOR_RED = (ImVec4) { 1.0f, 0.0f, 0.0f, 1.0f };
     ImVec4 COLOR_GREEN = (ImVec4) { 0.0f, 1.0f, 0.0f, 1.0f };
 
-    ImVec2 plot_size = { 0 };
-    igGetContentRegionAvail(&plot_size);
-
     char plot_title[64];
     snprintf(plot_title, sizeof plot_title, "##idPlot%p", (void *) data);
     if (ImPlot_BeginPlot(plot_title, plot_size, plot_flags)) {
         ImPlot_SetupAxis(ImAxis_X1, "Seconds", axis_flags);
         ImPlot_SetupAxis(ImAxis_Y1, "Angle", ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_Opposite);
-        ImPlot_SetupAxisFormat_Str(ImAxis_X1, "%g s");
+        ImPlot_SetupAxisFormat_PlotFormatter(ImAxis_X1, sequencer_track_format, &cache->view_start);
         ImPlot_SetupAxisFormat_Str(ImAxis_Y1, "%g °");
-        ImPlot_SetupAxesLimits(0.0, count - 1, -90.0, 360.0, ImPlotCond_Always);
+
+        f64 const moved = seconds - cache->view_start;
+        ImPlotCond const condition = changed || moved != 0.0 ? ImPlotCond_Always : ImPlotCond_Once;
+        ImPlot_SetupAxisLimits(ImAxis_X1, cache->view_min + moved, cache->view_max + moved, condition);
+        ImPlot_SetupAxisLimits(ImAxis_Y1, -90.0, 360.0, ImPlotCond_Always);
+
+        ImPlotRect limits = { 0 };
+        ImPlot_GetPlotLimits(&limits, -1, -1);
+        cache->view_start = seconds;
+        cache->view_min = limits.X.Min;
+        cache->view_max = limits.X.Max;
+        EphemerisCurve const *curve = sequencer_track_detail(sequencer, data, start, &limits.X, duration, pixels);
+
+        // At most two points per pixel are plotted, no matter how many positions the curve has
+        f64 const from = limits.X.Min;
+        f64 const to = limits.X.Max;
+        SeriesPyramidLevel azimuths = series_pyramid_select(&curve->azimuth_pyramid, from, to, pixels);
+        SeriesPyramidLevel altitudes = series_pyramid_select(&curve->altitude_pyramid, from, to, pixels);
+
         ImPlot_TagX_Str(now_mark, (ImVec4) { 0.0f, 0.0f, 1.0f, 1.0f }, "Now");
         ImPlot_DragLineX(0, &now_mark, (ImVec4) { 0.33f, 0.33f, 0.33f, 1.0f }, 1, 0, nil, nil, nil);
         ImPlot_SetNextLineStyle(COLOR_RED, 1.0f);
-        ImPlot_PlotLine_doublePtrInt("azimuth(t)", result.azimuths, count, 1, 0, 0, 0, sizeof(f64));
+        ImPlot_PlotLine_doublePtrdoublePtr("azimuth(t)", azimuths.xs, azimuths.ys, (s32) azimuths.count, 0, 0,
+                                           sizeof(f64));
         ImPlot_SetNextLineStyle(COLOR_GREEN, 1.0f);
-        ImPlot_PlotLine_doublePtrInt("altitude(t)", result.altitudes, count, 1, 0, 0, 0, sizeof(f64));
+        ImPlot_PlotLine_doublePtrdoublePtr("altitude(t)", altitudes.xs, altitudes.ys, (s32) altitudes.count, 0, 0,
+                                           sizeof(f64));
         ImPlot_EndPlot();
     }
 
@@ -28,6 +28,7 @@
 #include <libcore/types.h>
 
 #include "browser.h"
+#include "ephemeris.h"
 
 typedef enum SequenceNodeType {
     SEQUENCE_NODE_START,
@@ -45,12 +46,52 @@ typedef struct SequenceNodeStartData {
     b8 now;
 } SequenceNodeStartData;
 
+/// Positions of the tracked object over the duration of a track node, they are only
+/// requested again when one of the inputs changes. The x values of the positions are
+/// seconds since the unix epoch, so curves of different starts share one time axis.
+typedef struct SequenceTrackCache {
+    /// The object or planet the positions were computed for
+    void const *target;
+
+    /// The duration of the node
+    Duration duration;
+
+    /// The location of the observer
+    f64 latitude;
+    f64 longitude;
+
+    /// The first position (s since the unix epoch) of the coarse curve, the start of the node rounded
+    /// down to the step of the curve, a start that moves with the clock only changes it once per step
+    f64 origin;
+
+    /// The number of positions of the coarse curve, derived from the width of the plot
+    usize resolution;
+
+    /// Coarse positions over the whole node, computed in the background, nil if none are ready yet
+    EphemerisCurve *curve;
+
+    /// Coarse positions for the inputs above, they replace the curve once they are ready
+    EphemerisCurve *pending;
+
+    /// Finer positions of the zoomed range, nil if the coarse curve suffices
+    EphemerisCurve *detail;
+
+    /// The start of the node (s since the unix epoch) and the visible time range of the last frame,
+    /// the view follows the start of the node
+    f64 view_start;
+    f64 view_min;
+    f64 view_max;
+} SequenceTrackCache;
+
 typedef struct SequenceNodeTrackData {
     /// The duration of the node
     Duration duration;
 
     /// The object if the node is of an object related type
     ObjectEntry object;
+
+    /// The positions that are shown on the timeline
+    SequenceTrackCache cache;
 } SequenceNodeTrackData;
 
 typedef struct SequenceNodeWaitData {
@@ -151,9 +192,6 @@ typedef struct Sequencer {
     /// Sequencer arena, this stores all the nodes in blocks
     MemoryArena arena;
 
-    /// Position arena that gets cleared every frame
-    MemoryArena position_arena;
-
     /// This flag controls whether the sequencer node editor is displayed
     b8 show_editor;
 
@@ -163,6 +201,9 @@ typedef struct Sequencer {
     /// The object browser
     ObjectBrowser *browser;
 
+    /// Computes the positions of the track nodes in the background
+    JobPool *jobs;
+
     /// The renderer
     Renderer renderer;
 } Sequencer;
@@ -170,7 +211,8 @@ typedef struct Sequencer {
 /// Create a new sequencer
 /// @param sequencer The sequencer handle
 /// @param browser The browser handle
-void sequencer_make(Sequencer *sequencer, ObjectBrowser *browser);
+/// @param jobs The job pool for position computations
+void sequencer_make(Sequencer *sequencer, ObjectBrowser *browser, JobPool *jobs);
 
 /// Destroy the sequencer
 /// @param sequencer The sequencer handle
@@ -21,12 +21,16 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <stdio.h>
+
 #include "settings.h"
 
 /// Initializes the settings
 void settings_make(Settings *settings) {
     settings->arena = memory_arena_identity(ALIGNMENT1);
     geo_location_fetch(&settings->location, &settings->arena);
+    settings->telemetry = false;
+    snprintf(settings->telemetry_directory, sizeof settings->telemetry_directory, ".");
 }
 
 /// Destroys the provided settings
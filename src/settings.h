@@ -30,6 +30,12 @@
 typedef struct Settings {
     MemoryArena arena;
     GeoLocation location;
+
+    /// Whether every gear session records a telemetry log
+    b8 telemetry;
+
+    /// The directory the telemetry logs are written to
+    char telemetry_directory[256];
 } Settings;
 
 /// Initializes the settings
@@ -0,0 +1,596 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libcore/arch/thread.h>
+#include <libcore/timer.h>
+
+#include "telemetry.h"
+
+static const u8 TELEMETRY_MAGIC[4] = { 'K', 'T', 'L', 'M' };
+
+enum {
+    /// Kind and length that precede every record
+    TELEMETRY_RECORD_HEADER_SIZE = 5,
+
+    /// Device, field, sample count and timestamp length of a block
+    TELEMETRY_BLOCK_HEADER_SIZE = 11,
+
+    /// Upper bound of the encoded size of one sample
+    TELEMETRY_SAMPLE_MAX_SIZE = 20,
+};
+
+typedef struct TelemetrySample {
+    f64 timestamp;
+    f64 value;
+    u16 device;
+    u8 field;
+} TelemetrySample;
+
+struct TelemetryWriter {
+    FILE *file;
+
+    /// Monotonic time (s) at which the log was created
+    f64 origin;
+
+    /// Guards the staging buffer and the running flag
+    Mutex *staging_mutex;
+
+    /// Serializes the file writes of the writer thread and the schema writes
+    Mutex *file_mutex;
+
+    /// Samples pushed by the sampler, swapped with the flushing buffer on every flush
+    TelemetrySample *staging;
+    usize staging_count;
+    TelemetrySample *flushing;
+
+    /// Encoding buffer
+    u8 *buffer;
+
+    /// Number of samples that were dropped because the staging buffer was full
+    u64 dropped;
+
+    b8 running;
+};
+
+/// Bit stream over a byte buffer, most significant bit first
+typedef struct TelemetryBits {
+    u8 *data;
+    usize length;
+    usize capacity;
+    u32 used;
+} TelemetryBits;
+
+/// Writes a little endian integer of the specified size
+static void telemetry_put(u8 *out, u64 value, usize size) {
+    for (usize i = 0; i < size; ++i) {
+        out[i] = (u8) (value >> (8 * i));
+    }
+}
+
+/// Reads a little endian integer of the specified size
+static u64 telemetry_get(u8 const *in, usize size) {
+    u64 value = 0;
+    for (usize i = 0; i < size; ++i) {
+        value |= (u64) in[i] << (8 * i);
+    }
+    return value;
+}
+
+/// Writes an unsigned LEB128 varint
+static usize telemetry_put_varint(u8 *out, u64 value) {
+    usize length = 0;
+    do {
+        u8 byte = value & 0x7f;
+        value >>= 7;
+        out[length++] = value != 0 ? (byte | 0x80) : byte;
+    } while (value != 0);
+    return length;
+}
+
+/// Reads an unsigned LEB128 varint
+static b8 telemetry_get_varint(u8 const *in, usize size, usize *cursor, u64 *value) {
+    *value = 0;
+    for (u32 shift = 0; shift < 64 && *cursor < size; shift += 7) {
+        u8 byte = in[(*cursor)++];
+        *value |= (u64) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Maps signed integers to unsigned ones, small magnitudes stay small
+static u64 telemetry_zigzag(s64 value) {
+    return ((u64) value << 1) ^ (u64) (value >> 63);
+}
+
+/// Inverse of telemetry_zigzag
+static s64 telemetry_unzigzag(u64 value) {
+    return (s64) (value >> 1) ^ -(s64) (value & 1);
+}
+
+/// Counts the leading zero bits
+static u32 telemetry_leading_zeros(u64 value) {
+    u32 count = 0;
+    for (u64 mask = 1ull << 63; mask != 0 && (value & mask) == 0; mask >>= 1) {
+        count++;
+    }
+    return count;
+}
+
+/// Counts the trailing zero bits
+static u32 telemetry_trailing_zeros(u64 value) {
+    u32 count = 0;
+    for (u64 mask = 1; mask != 0 && (value & mask) == 0; mask <<= 1) {
+        count++;
+    }
+    return count;
+}
+
+/// Writes the lowest count bits of the value
+static void telemetry_bits_write(TelemetryBits *bits, u64 value, u32 count) {
+    while (count > 0) {
+        u32 free = 8 - bits->used;
+        u32 take = count < free ? count : free;
+        u8 chunk = (u8) ((value >> (count - take)) & ((1u << take) - 1));
+        if (bits->used == 0) {
+            bits->data[bits->length] = 0;
+        }
+        bits->data[bits->length] |= (u8) (chunk << (free - take));
+        bits->used += take;
+        count -= take;
+        if (bits->used == 8) {
+            bits->length++;
+            bits->used = 0;
+        }
+    }
+}
+
+/// Reads count bits, fails if the stream is exhausted
+static b8 telemetry_bits_read(TelemetryBits *bits, u32 count, u64 *value) {
+    *value = 0;
+    while (count > 0) {
+        if (bits->length >= bits->capacity) {
+            return false;
+        }
+        u32 available = 8 - bits->used;
+        u32 take = count < available ? count : available;
+        u8 chunk = (u8) ((bits->data[bits->length] >> (available - take)) & ((1u << take) - 1));
+        *value = (*value << take) | chunk;
+        bits->used += take;
+        count -= take;
+        if (bits->used == 8) {
+            bits->length++;
+            bits->used = 0;
+        }
+    }
+    return true;
+}
+
+/// Reinterprets a f64 as its bits
+static u64 telemetry_f64_bits(f64 value) {
+    u64 bits = 0;
+    memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+/// Reinterprets bits as a f64
+static f64 telemetry_bits_f64(u64 bits) {
+    f64 value = 0.0;
+    memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+/// Encodes the values with XOR compression, unchanged values take a single bit and values
+/// that only differ within the previous window of meaningful bits reuse it
+static usize telemetry_encode_values(u8 *out, TelemetrySample const *samples, usize count) {
+    TelemetryBits bits = { out, 0, 0, 0 };
+    u64 previous = telemetry_f64_bits(samples[0].value);
+    telemetry_bits_write(&bits, previous, 64);
+
+    u32 window_leading = 0;
+    u32 window_trailing = 0;
+    b8 window = false;
+    for (usize i = 1; i < count; ++i) {
+        u64 current = telemetry_f64_bits(samples[i].value);
+        u64 xor = current ^ previous;
+        previous = current;
+        if (xor == 0) {
+            telemetry_bits_write(&bits, 0, 1);
+            continue;
+        }
+
+        telemetry_bits_write(&bits, 1, 1);
+        u32 leading = telemetry_leading_zeros(xor);
+        u32 trailing = telemetry_trailing_zeros(xor);
+        leading = leading > 31 ? 31 : leading;
+        if (window && leading >= window_leading && trailing >= window_trailing) {
+            telemetry_bits_write(&bits, 0, 1);
+            telemetry_bits_write(&bits, xor >> window_trailing, 64 - window_leading - window_trailing);
+        } else {
+            u32 meaningful = 64 - leading - trailing;
+            telemetry_bits_write(&bits, 1, 1);
+            telemetry_bits_write(&bits, leading, 5);
+            telemetry_bits_write(&bits, meaningful - 1, 6);
+            telemetry_bits_write(&bits, xor >> trailing, meaningful);
+            window_leading = leading;
+            window_trailing = trailing;
+            window = true;
+        }
+    }
+    return bits.length + (bits.used > 0 ? 1 : 0);
+}
+
+/// Decodes XOR compressed values
+static b8 telemetry_decode_values(u8 const *in, usize size, f64 *values, usize count) {
+    TelemetryBits bits = { (u8 *) in, 0, size, 0 };
+    u64 previous = 0;
+    if (!telemetry_bits_read(&bits, 64, &previous)) {
+        return false;
+    }
+    values[0] = telemetry_bits_f64(previous);
+
+    u64 window_leading = 0;
+    u64 window_trailing = 0;
+    for (usize i = 1; i < count; ++i) {
+        u64 changed = 0;
+        if (!telemetry_bits_read(&bits, 1, &changed)) {
+            return false;
+        }
+        if (changed) {
+            u64 control = 0;
+            if (!telemetry_bits_read(&bits, 1, &control)) {
+                return false;
+            }
+            if (control) {
+                u64 meaningful = 0;
+                if (!telemetry_bits_read(&bits, 5, &window_leading) || !telemetry_bits_read(&bits, 6, &meaningful)) {
+                    return false;
+                }
+                window_trailing = 64 - window_leading - (meaningful + 1);
+            }
+            u64 xor = 0;
+            if (!telemetry_bits_read(&bits, (u32) (64 - window_leading - window_trailing), &xor)) {
+                return false;
+            }
+            previous ^= xor << window_trailing;
+        }
+        values[i] = telemetry_bits_f64(previous);
+    }
+    return true;
+}
+
+/// Converts a monotonic timestamp in seconds to microseconds since the log origin
+static u64 telemetry_micros(TelemetryWriter const *writer, f64 timestamp) {
+    f64 micros = round((timestamp - writer->origin) * 1e6);
+    return micros > 0.0 ? (u64) micros : 0;
+}
+
+/// Encodes the timestamps as delta of deltas, regular sampling yields single byte samples
+static usize telemetry_encode_timestamps(TelemetryWriter const *writer,
+                                         u8 *out,
+                                         TelemetrySample const *samples,
+                                         usize count) {
+    usize length = 0;
+    s64 previous = (s64) telemetry_micros(writer, samples[0].timestamp);
+    s64 previous_delta = 0;
+    length += telemetry_put_varint(out + length, (u64) previous);
+    for (usize i = 1; i < count; ++i) {
+        s64 current = (s64) telemetry_micros(writer, samples[i].timestamp);
+        s64 delta = current - previous;
+        length += telemetry_put_varint(out + length, telemetry_zigzag(delta - previous_delta));
+        previous = current;
+        previous_delta = delta;
+    }
+    return length;
+}
+
+/// Decodes delta of delta encoded timestamps
+static b8 telemetry_decode_timestamps(u8 const *in, usize size, f64 *timestamps, usize count) {
+    usize cursor = 0;
+    u64 first = 0;
+    if (!telemetry_get_varint(in, size, &cursor, &first)) {
+        return false;
+    }
+
+    s64 previous = (s64) first;
+    s64 previous_delta = 0;
+    timestamps[0] = (f64) previous / 1e6;
+    for (usize i = 1; i < count; ++i) {
+        u64 encoded = 0;
+        if (!telemetry_get_varint(in, size, &cursor, &encoded)) {
+            return false;
+        }
+        previous_delta += telemetry_unzigzag(encoded);
+        previous += previous_delta;
+        timestamps[i] = (f64) previous / 1e6;
+    }
+    return true;
+}
+
+/// Orders samples by device, field and time
+static int telemetry_sample_compare(const void *left, const void *right) {
+    TelemetrySample const *a = (TelemetrySample const *) left;
+    TelemetrySample const *b = (TelemetrySample const *) right;
+    if (a->device != b->device) {
+        return a->device < b->device ? -1 : 1;
+    }
+    if (a->field != b->field) {
+        return a->field < b->field ? -1 : 1;
+    }
+    if (a->timestamp != b->timestamp) {
+        return a->timestamp < b->timestamp ? -1 : 1;
+    }
+    return 0;
+}
+
+/// Encodes one block record for samples of the same field
+static usize telemetry_encode_block(TelemetryWriter const *writer,
+                                    u8 *out,
+                                    TelemetrySample const *samples,
+                                    usize count) {
+    u8 *block = out + TELEMETRY_RECORD_HEADER_SIZE;
+    usize timestamp_length = telemetry_encode_timestamps(writer, block + TELEMETRY_BLOCK_HEADER_SIZE, samples, count);
+    usize value_length =
+            telemetry_encode_values(block + TELEMETRY_BLOCK_HEADER_SIZE + timestamp_length, samples, count);
+
+    telemetry_put(block, samples[0].device, 2);
+    telemetry_put(block + 2, samples[0].field, 1);
+    telemetry_put(block + 3, count, 4);
+    telemetry_put(block + 7, timestamp_length, 4);
+
+    usize length = TELEMETRY_BLOCK_HEADER_SIZE + timestamp_length + value_length;
+    telemetry_put(out, TELEMETRY_RECORD_BLOCK, 1);
+    telemetry_put(out + 1, length, 4);
+    return TELEMETRY_RECORD_HEADER_SIZE + length;
+}
+
+/// Writes all staged samples, the file mutex must be held by the caller
+static void telemetry_writer_flush(TelemetryWriter *writer) {
+    mutex_lock(writer->staging_mutex);
+    TelemetrySample *samples = writer->staging;
+    usize count = writer->staging_count;
+    writer->staging = writer->flushing;
+    writer->staging_count = 0;
+    writer->flushing = samples;
+    mutex_unlock(writer->staging_mutex);
+
+    if (count == 0) {
+        return;
+    }
+
+    // One block per field keeps the compression effective
+    qsort(samples, count, sizeof(TelemetrySample), telemetry_sample_compare);
+    usize length = 0;
+    for (usize begin = 0; begin < count;) {
+        usize end = begin + 1;
+        while (end < count && samples[end].device == samples[begin].device &&
+               samples[end].field == samples[begin].field) {
+            end++;
+        }
+        length += telemetry_encode_block(writer, writer->buffer + length, samples + begin, end - begin);
+        begin = end;
+    }
+
+    fwrite(writer->buffer, 1, length, writer->file);
+    fflush(writer->file);
+}
+
+/// Periodically writes the staged samples, frees the writer once it was closed
+static void *telemetry_writer_task(void *args) {
+    TelemetryWriter *writer = (TelemetryWriter *) args;
+
+    for (;;) {
+        thread_sleep(TELEMETRY_FLUSH_INTERVAL);
+
+        mutex_lock(writer->file_mutex);
+        mutex_lock(writer->staging_mutex);
+        b8 running = writer->running;
+        mutex_unlock(writer->staging_mutex);
+        if (!running) {
+            mutex_unlock(writer->file_mutex);
+            break;
+        }
+        telemetry_writer_flush(writer);
+        mutex_unlock(writer->file_mutex);
+    }
+
+    fclose(writer->file);
+    mutex_free(writer->staging_mutex);
+    mutex_free(writer->file_mutex);
+    free(writer->staging);
+    free(writer->flushing);
+    free(writer->buffer);
+    free(writer);
+    return nil;
+}
+
+/// Creates a new telemetry log and starts the writer thread
+TelemetryWriter *telemetry_writer_open(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == nil) {
+        return nil;
+    }
+
+    u8 header[TELEMETRY_HEADER_SIZE] = { 0 };
+    memcpy(header, TELEMETRY_MAGIC, sizeof TELEMETRY_MAGIC);
+    telemetry_put(header + 4, TELEMETRY_VERSION, 4);
+    telemetry_put(header + 8, (u64) time(nil), 8);
+    fwrite(header, 1, sizeof header, file);
+
+    TelemetryWriter *writer = (TelemetryWriter *) calloc(1, sizeof(TelemetryWriter));
+    writer->file = file;
+    writer->origin = timer_now() / 1000.0;
+    writer->staging_mutex = mutex_new();
+    writer->file_mutex = mutex_new();
+    writer->staging = (TelemetrySample *) malloc(sizeof(TelemetrySample) * TELEMETRY_STAGING_CAPACITY);
+    writer->flushing = (TelemetrySample *) malloc(sizeof(TelemetrySample) * TELEMETRY_STAGING_CAPACITY);
+    usize const record_size = TELEMETRY_SAMPLE_MAX_SIZE + TELEMETRY_RECORD_HEADER_SIZE + TELEMETRY_BLOCK_HEADER_SIZE;
+    writer->buffer = (u8 *) malloc(TELEMETRY_STAGING_CAPACITY * record_size);
+    writer->running = true;
+    thread_create(telemetry_writer_task, writer);
+    return writer;
+}
+
+/// Writes the schema of a device, samples that were pushed before are written first
+void telemetry_writer_schema(TelemetryWriter *writer, u16 device, AlpacaDevice const *alpaca) {
+    usize name_length = (usize) alpaca->name.length;
+    usize length = 4 + name_length;
+    u8 *record = (u8 *) malloc(TELEMETRY_RECORD_HEADER_SIZE + length);
+    telemetry_put(record, TELEMETRY_RECORD_SCHEMA, 1);
+    telemetry_put(record + 1, length, 4);
+    telemetry_put(record + 5, device, 2);
+    telemetry_put(record + 7, alpaca->type, 1);
+    telemetry_put(record + 8, alpaca_device_field_count(alpaca), 1);
+    memcpy(record + 9, alpaca->name.base, name_length);
+
+    // Staged samples could belong to a previous device with the same index
+    mutex_lock(writer->file_mutex);
+    telemetry_writer_flush(writer);
+    fwrite(record, 1, TELEMETRY_RECORD_HEADER_SIZE + length, writer->file);
+    fflush(writer->file);
+    mutex_unlock(writer->file_mutex);
+    free(record);
+}
+
+/// Stages a sample, samples are dropped if the writer cannot keep up
+void telemetry_writer_push(TelemetryWriter *writer, u16 device, u8 field, f64 timestamp, f64 value) {
+    mutex_lock(writer->staging_mutex);
+    if (writer->staging_count < TELEMETRY_STAGING_CAPACITY) {
+        writer->staging[writer->staging_count++] = (TelemetrySample) { timestamp, value, device, field };
+    } else {
+        writer->dropped++;
+    }
+    mutex_unlock(writer->staging_mutex);
+}
+
+/// Writes all staged samples and closes the log
+void telemetry_writer_close(TelemetryWriter *writer) {
+    mutex_lock(writer->file_mutex);
+    telemetry_writer_flush(writer);
+    mutex_lock(writer->staging_mutex);
+    writer->running = false;
+    mutex_unlock(writer->staging_mutex);
+    mutex_unlock(writer->file_mutex);
+}
+
+/// Opens a telemetry log for reading
+b8 telemetry_log_open(TelemetryLog *log, const char *path) {
+    *log = (TelemetryLog) { 0 };
+    if (!file_mapping_open(&log->mapping, path)) {
+        return false;
+    }
+
+    u8 const *header = log->mapping.data;
+    if (log->mapping.size < TELEMETRY_HEADER_SIZE || memcmp(header, TELEMETRY_MAGIC, sizeof TELEMETRY_MAGIC) != 0 ||
+        telemetry_get(header + 4, 4) != TELEMETRY_VERSION) {
+        file_mapping_close(&log->mapping);
+        return false;
+    }
+
+    log->created = (s64) telemetry_get(header + 8, 8);
+    log->cursor = TELEMETRY_HEADER_SIZE;
+    return true;
+}
+
+/// Decodes a block record
+static b8 telemetry_log_decode_block(u8 const *payload, usize length, MemoryArena *arena, TelemetryRecord *record) {
+    if (length < TELEMETRY_BLOCK_HEADER_SIZE) {
+        return false;
+    }
+
+    record->device = (u16) telemetry_get(payload, 2);
+    record->field = (u8) telemetry_get(payload + 2, 1);
+    record->count = (usize) telemetry_get(payload + 3, 4);
+    usize timestamp_length = (usize) telemetry_get(payload + 7, 4);
+    if (record->count == 0 || record->field >= ALPACA_DEVICE_PAYLOAD_CAPACITY ||
+        timestamp_length > length - TELEMETRY_BLOCK_HEADER_SIZE) {
+        return false;
+    }
+
+    record->timestamps = (f64 *) memory_arena_alloc(arena, sizeof(f64) * record->count);
+    record->values = (f64 *) memory_arena_alloc(arena, sizeof(f64) * record->count);
+    u8 const *timestamps = payload + TELEMETRY_BLOCK_HEADER_SIZE;
+    u8 const *values = timestamps + timestamp_length;
+    usize value_length = length - TELEMETRY_BLOCK_HEADER_SIZE - timestamp_length;
+    return telemetry_decode_timestamps(timestamps, timestamp_length, record->timestamps, record->count) &&
+           telemetry_decode_values(values, value_length, record->values, record->count);
+}
+
+/// Decodes the next record of the log
+b8 telemetry_log_next(TelemetryLog *log, MemoryArena *arena, TelemetryRecord *record) {
+    *record = (TelemetryRecord) { 0 };
+    usize size = log->mapping.size;
+    if (size - log->cursor < TELEMETRY_RECORD_HEADER_SIZE) {
+        return false;
+    }
+
+    u8 const *header = log->mapping.data + log->cursor;
+    TelemetryRecordKind kind = (TelemetryRecordKind) telemetry_get(header, 1);
+    usize length = (usize) telemetry_get(header + 1, 4);
+    if (size - log->cursor - TELEMETRY_RECORD_HEADER_SIZE < length) {
+        return false;
+    }
+
+    u8 const *payload = header + TELEMETRY_RECORD_HEADER_SIZE;
+    record->kind = kind;
+    switch (kind) {
+        case TELEMETRY_RECORD_SCHEMA:
+            if (length < 4) {
+                return false;
+            }
+            record->device = (u16) telemetry_get(payload, 2);
+            record->type = (AlpacaDeviceType) telemetry_get(payload + 2, 1);
+            record->field_count = (u8) telemetry_get(payload + 3, 1);
+            record->name = string_view_make((const char *) payload + 4, (ssize) (length - 4));
+            break;
+        case TELEMETRY_RECORD_BLOCK:
+            if (!telemetry_log_decode_block(payload, length, arena, record)) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    log->cursor += TELEMETRY_RECORD_HEADER_SIZE + length;
+    return true;
+}
+
+/// Moves back to the first record of the log
+void telemetry_log_rewind(TelemetryLog *log) {
+    log->cursor = TELEMETRY_HEADER_SIZE;
+}
+
+/// Closes the telemetry log
+void telemetry_log_close(TelemetryLog *log) {
+    file_mapping_close(&log->mapping);
+    *log = (TelemetryLog) { 0 };
+}
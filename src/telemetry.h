@@ -0,0 +1,127 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef KOPERNIKUS_TELEMETRY_H
+#define KOPERNIKUS_TELEMETRY_H
+
+#include <libascom/device.h>
+#include <libcore/arch/mapping.h>
+
+/// Telemetry logs are append-only binary files. A fixed header is followed by records,
+/// schema records describe a device, block records carry a batch of samples of one
+/// payload field with delta-of-delta encoded timestamps and XOR compressed values.
+enum {
+    TELEMETRY_VERSION = 1,
+    TELEMETRY_HEADER_SIZE = 32,
+
+    /// Maximum number of samples that are staged between two flushes
+    TELEMETRY_STAGING_CAPACITY = 16384,
+
+    /// Interval (ms) in which staged samples are written
+    TELEMETRY_FLUSH_INTERVAL = 2000,
+};
+
+typedef enum TelemetryRecordKind {
+    TELEMETRY_RECORD_NONE = 0,
+    TELEMETRY_RECORD_SCHEMA,
+    TELEMETRY_RECORD_BLOCK,
+} TelemetryRecordKind;
+
+/// Writes telemetry logs, the encoding and the file writes happen on a dedicated thread
+typedef struct TelemetryWriter TelemetryWriter;
+
+/// Creates a new telemetry log and starts the writer thread
+/// @param path The path of the log file
+/// @return The writer, or nil if the file could not be created
+TelemetryWriter *telemetry_writer_open(const char *path);
+
+/// Writes the schema of a device, samples that were pushed before are written first
+/// @param writer The telemetry writer
+/// @param device The index of the device within the log
+/// @param alpaca The alpaca device
+void telemetry_writer_schema(TelemetryWriter *writer, u16 device, AlpacaDevice const *alpaca);
+
+/// Stages a sample, samples are dropped if the writer cannot keep up
+/// @param writer The telemetry writer
+/// @param device The index of the device within the log
+/// @param field The index of the field within the device payload
+/// @param timestamp The monotonic timestamp of the sample in seconds
+/// @param value The value of the sample
+void telemetry_writer_push(TelemetryWriter *writer, u16 device, u8 field, f64 timestamp, f64 value);
+
+/// Writes all staged samples and closes the log, the writer must not be used afterwards
+/// @param writer The telemetry writer
+void telemetry_writer_close(TelemetryWriter *writer);
+
+/// A decoded record of a telemetry log
+typedef struct TelemetryRecord {
+    TelemetryRecordKind kind;
+
+    /// The index of the device within the log
+    u16 device;
+
+    /// Schema records only
+    AlpacaDeviceType type;
+    u8 field_count;
+    StringView name;
+
+    /// Block records only, the timestamps are seconds since the log was created
+    u8 field;
+    usize count;
+    f64 *timestamps;
+    f64 *values;
+} TelemetryRecord;
+
+/// Memory mapped reader for telemetry logs
+typedef struct TelemetryLog {
+    FileMapping mapping;
+
+    /// Unix time at which the log was created
+    s64 created;
+
+    /// Offset of the next record
+    usize cursor;
+} TelemetryLog;
+
+/// Opens a telemetry log for reading
+/// @param log The telemetry log
+/// @param path The path of the log file
+/// @return Whether the file is a valid telemetry log
+b8 telemetry_log_open(TelemetryLog *log, const char *path);
+
+/// Decodes the next record of the log
+/// @param log The telemetry log
+/// @param arena The arena for the decoded samples
+/// @param record The record that will be filled
+/// @return Whether a record was decoded, false at the end of the log or for a truncated record
+b8 telemetry_log_next(TelemetryLog *log, MemoryArena *arena, TelemetryRecord *record);
+
+/// Moves back to the first record of the log
+/// @param log The telemetry log
+void telemetry_log_rewind(TelemetryLog *log);
+
+/// Closes the telemetry log
+/// @param log The telemetry log
+void telemetry_log_close(TelemetryLog *log);
+
+#endif// KOPERNIKUS_TELEMETRY_H
@@ -0,0 +1,114 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libcore/arch/thread.h>
+#include <libcore/timer.h>
+
+#include "simulator.h"
+
+/// Prints the usage of the simulator
+static void alpaca_sim_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --port <port>                   Port on localhost, 0 picks a free port (default 11111)\n"
+            "  --telescopes <count>            Number of simulated telescopes (default 1)\n"
+            "  --observing-conditions <count>  Number of simulated observing conditions (default 1)\n"
+            "  --latency <ms>                  Base latency of every response (default 0)\n"
+            "  --jitter <ms>                   Maximum deviation from the base latency (default 0)\n"
+            "  --error-rate <0..1>             Probability of an injected alpaca error (default 0)\n"
+            "  --seed <seed>                   Seed for jitter and error injection (default 1)\n"
+            "  --discovery <port>              Answer alpaca discovery requests, 0 disables it (default 32227)\n"
+            "  --duration <s>                  Stop after the specified time, 0 runs forever (default 0)\n",
+            program);
+}
+
+int main(int argc, char **argv) {
+    AlpacaSimulatorConfig config = {
+        .port = 11111,
+        .telescopes = 1,
+        .observing_conditions = 1,
+        .seed = 1,
+        .discovery_port = 32227,
+    };
+    f64 duration = 0.0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *option = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nil;
+        if (value == nil) {
+            alpaca_sim_usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(option, "--port") == 0) {
+            config.port = (u16) strtoul(value, nil, 10);
+        } else if (strcmp(option, "--telescopes") == 0) {
+            config.telescopes = (u32) strtoul(value, nil, 10);
+        } else if (strcmp(option, "--observing-conditions") == 0) {
+            config.observing_conditions = (u32) strtoul(value, nil, 10);
+        } else if (strcmp(option, "--latency") == 0) {
+            config.latency = (u32) strtoul(value, nil, 10);
+        } else if (strcmp(option, "--jitter") == 0) {
+            config.jitter = (u32) strtoul(value, nil, 10);
+        } else if (strcmp(option, "--error-rate") == 0) {
+            config.error_rate = strtod(value, nil);
+        } else if (strcmp(option, "--seed") == 0) {
+            config.seed = strtoull(value, nil, 10);
+        } else if (strcmp(option, "--discovery") == 0) {
+            config.discovery_port = (u16) strtoul(value, nil, 10);
+        } else if (strcmp(option, "--duration") == 0) {
+            duration = strtod(value, nil);
+        } else {
+            alpaca_sim_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    AlpacaSimulator *simulator = alpaca_simulator_start(&config);
+    if (simulator == nil) {
+        fprintf(stderr, "Could not bind to 127.0.0.1:%u or the discovery port %u\n", config.port,
+                config.discovery_port);
+        return 1;
+    }
+    printf("Alpaca simulator listening on http://127.0.0.1:%u\n", alpaca_simulator_port(simulator));
+    fflush(stdout);
+
+    // Report the throughput once per second
+    f64 const start = timer_now();
+    u64 previous = 0;
+    while (duration <= 0.0 || timer_now() - start < duration * 1000.0) {
+        thread_sleep(1000);
+        u64 requests = alpaca_simulator_requests(simulator);
+        printf("{\"requests\":%llu,\"requests_per_second\":%llu}\n", (unsigned long long) requests,
+               (unsigned long long) (requests - previous));
+        fflush(stdout);
+        previous = requests;
+    }
+
+    alpaca_simulator_stop(simulator);
+    return 0;
+}
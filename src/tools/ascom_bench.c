@@ -0,0 +1,269 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libascom/alpaca.h>
+#include <libascom/client.h>
+#include <libascom/http/client.h>
+#include <libcore/timer.h>
+
+#include "simulator.h"
+
+enum {
+    BENCH_DEFAULT_ITERATIONS = 2000,
+    BENCH_WARMUP_ITERATIONS = 50,
+};
+
+// Heap allocations of the benchmark thread are counted by interposing the allocator,
+// which is only possible with glibc
+#if defined(__GLIBC__)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+
+static _Thread_local u64 bench_allocations = 0;
+
+void *malloc(size_t size) {
+    bench_allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    bench_allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+    bench_allocations++;
+    return __libc_realloc(pointer, size);
+}
+
+#define BENCH_ALLOCATIONS_AVAILABLE 1
+#else
+static u64 bench_allocations = 0;
+#define BENCH_ALLOCATIONS_AVAILABLE 0
+#endif
+
+/// Latency samples of one stage in microseconds
+typedef struct BenchSamples {
+    f64 *data;
+    usize count;
+} BenchSamples;
+
+static int bench_compare(const void *left, const void *right) {
+    f64 a = *(f64 const *) left;
+    f64 b = *(f64 const *) right;
+    return (a > b) - (a < b);
+}
+
+/// Creates samples for the specified number of iterations
+static BenchSamples bench_samples_make(usize iterations) {
+    return (BenchSamples) { (f64 *) malloc(sizeof(f64) * iterations), 0 };
+}
+
+/// Retrieves a percentile of sorted samples
+static f64 bench_percentile(BenchSamples const *samples, f64 percentile) {
+    if (samples->count == 0) {
+        return 0.0;
+    }
+    usize index = (usize) (percentile / 100.0 * (f64) (samples->count - 1) + 0.5);
+    return samples->data[index];
+}
+
+/// Prints the statistics of one stage as a JSON line and frees the samples
+static void bench_report(const char *operation,
+                         const char *stage,
+                         BenchSamples *samples,
+                         f64 total_ms,
+                         u64 allocations) {
+    qsort(samples->data, samples->count, sizeof(f64), bench_compare);
+    f64 const count = (f64) samples->count;
+    printf("{\"bench\":\"ascom\",\"op\":\"%s\",\"stage\":\"%s\",\"requests\":%zu,\"p50_us\":%.2f,\"p90_us\":%.2f,"
+           "\"p99_us\":%.2f,\"max_us\":%.2f,\"requests_per_second\":%.1f,\"allocs_per_request\":",
+           operation, stage, samples->count, bench_percentile(samples, 50.0), bench_percentile(samples, 90.0),
+           bench_percentile(samples, 99.0), bench_percentile(samples, 100.0),
+           total_ms > 0.0 ? count / (total_ms / 1000.0) : 0.0);
+    if (BENCH_ALLOCATIONS_AVAILABLE) {
+        printf("%.2f}\n", (f64) allocations / count);
+    } else {
+        printf("null}\n");
+    }
+    free(samples->data);
+}
+
+/// Measures the stages of a GET request: URL lookup, HTTP transfer, parsing and extraction
+static void bench_get_stages(AlpacaDevice *device, usize iterations) {
+    BenchSamples url_samples = bench_samples_make(iterations);
+    BenchSamples http_samples = bench_samples_make(iterations);
+    BenchSamples parse_samples = bench_samples_make(iterations);
+    BenchSamples extract_samples = bench_samples_make(iterations);
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+
+    f64 sink = 0.0;
+    for (usize i = 0; i < iterations; ++i) {
+        f64 const begin = timer_now();
+        const char *url = alpaca_device_url(device, &arena, "altitude");
+        f64 const formatted = timer_now();
+
+        HttpResponse http = { 0 };
+        http_client_get(&http, &arena, url, HTTP_FLAGS_NONE);
+        f64 const transferred = timer_now();
+
+        AlpacaResponse response = { 0 };
+        alpaca_response_make(&response, &arena, &http);
+        f64 const parsed = timer_now();
+
+        sink += alpaca_response_f64(&response);
+        f64 const extracted = timer_now();
+        alpaca_response_destroy(&response);
+        memory_arena_clear(&arena);
+
+        url_samples.data[url_samples.count++] = (formatted - begin) * 1000.0;
+        http_samples.data[http_samples.count++] = (transferred - formatted) * 1000.0;
+        parse_samples.data[parse_samples.count++] = (parsed - transferred) * 1000.0;
+        extract_samples.data[extract_samples.count++] = (extracted - parsed) * 1000.0;
+    }
+    memory_arena_destroy(&arena);
+
+    (void) sink;
+    bench_report("get_f64", "url", &url_samples, 0.0, 0);
+    bench_report("get_f64", "http", &http_samples, 0.0, 0);
+    bench_report("get_f64", "parse", &parse_samples, 0.0, 0);
+    bench_report("get_f64", "extract", &extract_samples, 0.0, 0);
+}
+
+/// Measures alpaca_device_get_f64 end to end
+static void bench_get_f64(AlpacaDevice *device, usize iterations) {
+    BenchSamples samples = bench_samples_make(iterations);
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+
+    u64 const allocations = bench_allocations;
+    f64 const start = timer_now();
+    for (usize i = 0; i < iterations; ++i) {
+        f64 const begin = timer_now();
+        f64 value = 0.0;
+        alpaca_device_get_f64(device, &arena, "altitude", &value);
+        memory_arena_clear(&arena);
+        samples.data[samples.count++] = (timer_now() - begin) * 1000.0;
+    }
+    f64 const total = timer_now() - start;
+    u64 const allocated = bench_allocations - allocations;
+
+    memory_arena_destroy(&arena);
+    bench_report("get_f64", "total", &samples, total, allocated);
+}
+
+/// Measures alpaca_device_put end to end
+static void bench_put(AlpacaDevice *device, usize iterations) {
+    BenchSamples samples = bench_samples_make(iterations);
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+
+    u64 const allocations = bench_allocations;
+    f64 const start = timer_now();
+    for (usize i = 0; i < iterations; ++i) {
+        f64 const begin = timer_now();
+        alpaca_device_update_connected(device, &arena, true);
+        memory_arena_clear(&arena);
+        samples.data[samples.count++] = (timer_now() - begin) * 1000.0;
+    }
+    f64 const total = timer_now() - start;
+    u64 const allocated = bench_allocations - allocations;
+
+    memory_arena_destroy(&arena);
+    bench_report("put", "total", &samples, total, allocated);
+}
+
+/// Measures alpaca_client_devices end to end, which includes connecting every device
+static void bench_client_devices(AlpacaClient *client, usize iterations) {
+    BenchSamples samples = bench_samples_make(iterations);
+
+    u64 const allocations = bench_allocations;
+    f64 const start = timer_now();
+    for (usize i = 0; i < iterations; ++i) {
+        f64 const begin = timer_now();
+        AlpacaDeviceList devices = { 0 };
+        alpaca_device_list_make(&devices);
+        alpaca_client_devices(client, &devices);
+        alpaca_device_list_destroy(&devices);
+        samples.data[samples.count++] = (timer_now() - begin) * 1000.0;
+    }
+    f64 const total = timer_now() - start;
+    u64 const allocated = bench_allocations - allocations;
+
+    bench_report("client_devices", "total", &samples, total, allocated);
+}
+
+int main(int argc, char **argv) {
+    usize iterations = BENCH_DEFAULT_ITERATIONS;
+    AlpacaSimulatorConfig config = { .telescopes = 1, .observing_conditions = 1, .seed = 1 };
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--iterations") == 0) {
+            iterations = (usize) strtoull(argv[i + 1], nil, 10);
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            config.latency = (u32) strtoul(argv[i + 1], nil, 10);
+        } else if (strcmp(argv[i], "--devices") == 0) {
+            config.telescopes = (u32) strtoul(argv[i + 1], nil, 10);
+            config.observing_conditions = config.telescopes;
+        }
+    }
+
+    AlpacaSimulator *simulator = alpaca_simulator_start(&config);
+    if (simulator == nil) {
+        fprintf(stderr, "Could not start the alpaca simulator\n");
+        return 1;
+    }
+    http_client_init();
+
+    char server[64];
+    snprintf(server, sizeof server, "http://127.0.0.1:%u", alpaca_simulator_port(simulator));
+    StringView address = string_view_from_native(server);
+    AlpacaClient client = { 0 };
+    alpaca_client_make(&client, &address);
+
+    AlpacaDevice device = { 0 };
+    StringView name = string_view_from_native("Simulated Telescope 0");
+    alpaca_device_make(&device, ALPACA_DEVICE_TYPE_TELESCOPE, &address, &name, 0);
+
+    // Warm up the connection pool
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+    for (usize i = 0; i < BENCH_WARMUP_ITERATIONS; ++i) {
+        f64 value = 0.0;
+        alpaca_device_get_f64(&device, &arena, "altitude", &value);
+        memory_arena_clear(&arena);
+    }
+    memory_arena_destroy(&arena);
+
+    bench_get_stages(&device, iterations);
+    bench_get_f64(&device, iterations);
+    bench_put(&device, iterations);
+    bench_client_devices(&client, iterations / 10 > 0 ? iterations / 10 : 1);
+
+    alpaca_device_destroy(&device);
+    alpaca_client_destroy(&client);
+    http_client_destroy();
+    alpaca_simulator_stop(simulator);
+    return 0;
+}
@@ -0,0 +1,137 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <libascom/utils/cJSON.h>
+#include <libascom/utils/cJSON_Helper.h>
+#include <libcore/timer.h>
+
+enum {
+    BENCH_ITERATIONS = 20000,
+    BENCH_DEVICE_COUNT = 16,
+};
+
+typedef struct BenchResult {
+    f64 milliseconds;
+    cJSON_ArenaStatistics allocations;
+} BenchResult;
+
+/// Builds a configureddevices response with the specified number of devices
+static void bench_make_devices_body(char *buffer, usize size, usize count) {
+    usize length = (usize) snprintf(buffer, size, "{\"Value\":[");
+    for (usize i = 0; i < count; ++i) {
+        length += (usize) snprintf(buffer + length, size - length,
+                                   "%s{\"DeviceName\":\"Device %zu\",\"DeviceType\":\"%s\",\"DeviceNumber\":%zu,"
+                                   "\"UniqueID\":\"b3f5e3c2-0000-4000-8000-%012zu\"}",
+                                   i == 0 ? "" : ",", i, i % 2 ? "Telescope" : "ObservingConditions", i, i);
+    }
+    snprintf(buffer + length, size - length,
+             "],\"ClientTransactionID\":1,\"ServerTransactionID\":42,\"ErrorNumber\":0,\"ErrorMessage\":\"\"}");
+}
+
+/// Computes the difference between two allocation counts
+static cJSON_ArenaStatistics bench_statistics_delta(cJSON_ArenaStatistics const *begin,
+                                                    cJSON_ArenaStatistics const *end) {
+    return (cJSON_ArenaStatistics) {
+        .heap_allocations = end->heap_allocations - begin->heap_allocations,
+        .arena_allocations = end->arena_allocations - begin->arena_allocations,
+    };
+}
+
+/// The previous path, the whole body is parsed and the value is duplicated on the heap
+static BenchResult bench_heap(const char *body, usize length) {
+    Timer timer = { 0 };
+    timer_make(&timer);
+
+    cJSON_ArenaStatistics begin = cJSON_GetArenaStatistics();
+    timer_start(&timer);
+    for (usize i = 0; i < BENCH_ITERATIONS; ++i) {
+        cJSON *data = cJSON_ParseWithLength(body, length);
+        cJSON *value = cJSON_Duplicate(cJSON_GetObjectItem(data, "Value"), true);
+        cJSON_Delete(data);
+        cJSON_Delete(value);
+    }
+    timer_end(&timer);
+    cJSON_ArenaStatistics end = cJSON_GetArenaStatistics();
+
+    return (BenchResult) { .milliseconds = timer_elapsed(&timer), .allocations = bench_statistics_delta(&begin, &end) };
+}
+
+/// The arena path, the value is parsed into the request arena which is cleared afterwards
+static BenchResult bench_arena(const char *body, usize length) {
+    Timer timer = { 0 };
+    timer_make(&timer);
+
+    // Locate the value once, this is what the envelope parser hands to cJSON
+    const char *value_begin = strstr(body, "\"Value\":") + strlen("\"Value\":");
+    const char *value_end = strstr(body, ",\"ClientTransactionID\"");
+    usize value_length = (usize) (value_end - value_begin);
+    (void) length;
+
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+    cJSON_ArenaStatistics begin = cJSON_GetArenaStatistics();
+    timer_start(&timer);
+    for (usize i = 0; i < BENCH_ITERATIONS; ++i) {
+        MemoryArena *previous = cJSON_BindArena(&arena);
+        cJSON *value = cJSON_ParseWithLength(value_begin, value_length);
+        cJSON_Delete(value);
+        cJSON_BindArena(previous);
+        memory_arena_clear(&arena);
+    }
+    timer_end(&timer);
+    cJSON_ArenaStatistics end = cJSON_GetArenaStatistics();
+    memory_arena_destroy(&arena);
+
+    return (BenchResult) { .milliseconds = timer_elapsed(&timer), .allocations = bench_statistics_delta(&begin, &end) };
+}
+
+/// Prints a result as a JSON line
+static void bench_report(const char *payload, const char *path, BenchResult const *result) {
+    printf("{\"bench\":\"cjson\",\"payload\":\"%s\",\"path\":\"%s\",\"iterations\":%d,"
+           "\"us_per_parse\":%.3f,\"heap_allocs_per_parse\":%.2f,\"arena_allocs_per_parse\":%.2f}\n",
+           payload, path, BENCH_ITERATIONS, 1000.0 * result->milliseconds / BENCH_ITERATIONS,
+           (f64) result->allocations.heap_allocations / BENCH_ITERATIONS,
+           (f64) result->allocations.arena_allocations / BENCH_ITERATIONS);
+}
+
+int main(void) {
+    cJSON_InitArenaHooks();
+
+    static char devices[16384];
+    bench_make_devices_body(devices, sizeof devices, BENCH_DEVICE_COUNT);
+    const char *array = "{\"Value\":[12.5],\"ClientTransactionID\":1,\"ServerTransactionID\":42,\"ErrorNumber\":0,"
+                        "\"ErrorMessage\":\"\"}";
+
+    BenchResult result = bench_heap(devices, strlen(devices));
+    bench_report("configureddevices", "heap", &result);
+    result = bench_arena(devices, strlen(devices));
+    bench_report("configureddevices", "arena", &result);
+
+    result = bench_heap(array, strlen(array));
+    bench_report("array", "heap", &result);
+    result = bench_arena(array, strlen(array));
+    bench_report("array", "arena", &result);
+    return 0;
+}
@@ -0,0 +1,181 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libcore/timer.h>
+#include <solaris/catalog.h>
+
+#include "observe.h"
+
+enum {
+    BENCH_DEFAULT_TIMES = 96,
+    BENCH_DEFAULT_REPETITIONS = 5,
+
+    /// Minutes between two timestamps
+    BENCH_TIME_STEP = 15,
+};
+
+/// Largest accepted separation between the per call and the batch position, the batch
+/// timestamps are whole unix seconds so up to one second of hour angle is tolerated
+#define BENCH_DEFAULT_TOLERANCE 30.0
+
+/// The positions of the catalog and the timestamps they are transformed at
+typedef struct BenchInput {
+    Object *objects;
+    f64 *right_ascensions;
+    f64 *declinations;
+    usize count;
+
+    Time *times;
+    f64 *seconds;
+    usize time_count;
+
+    Geographic observer;
+} BenchInput;
+
+/// Transforms every position at every timestamp with one call per position
+static f64 bench_per_call(BenchInput const *input, f64 *altitudes, f64 *azimuths) {
+    f64 const start = timer_now();
+    for (usize t = 0; t < input->time_count; ++t) {
+        for (usize i = 0; i < input->count; ++i) {
+            Horizontal horizontal = observe_geographic(&input->objects[i].position, &input->observer, &input->times[t]);
+            altitudes[t * input->count + i] = horizontal.altitude;
+            azimuths[t * input->count + i] = horizontal.azimuth;
+        }
+    }
+    return timer_now() - start;
+}
+
+/// Transforms every position at every timestamp with the batch kernel, including the sidereal terms
+static f64 bench_batch(BenchInput const *input, MemoryArena *arena, f64 *altitudes, f64 *azimuths) {
+    f64 const start = timer_now();
+    ObserveBatch batch = { 0 };
+    observe_batch_make(&batch, arena, &input->observer, input->seconds, input->time_count);
+    observe_batch_horizontal(&batch, arena, input->right_ascensions, input->declinations, input->count, altitudes,
+                             azimuths);
+    f64 const elapsed = timer_now() - start;
+    memory_arena_clear(arena);
+    return elapsed;
+}
+
+/// Computes the angular separation of two horizontal positions in arc seconds, the haversine
+/// keeps small separations accurate
+static f64 bench_separation(f64 altitude, f64 azimuth, f64 other_altitude, f64 other_azimuth) {
+    f64 const radians = 3.14159265358979323846 / 180.0;
+    f64 const altitude_sine = sin((other_altitude - altitude) * radians * 0.5);
+    f64 const azimuth_sine = sin((other_azimuth - azimuth) * radians * 0.5);
+    f64 const haversine = altitude_sine * altitude_sine +
+                          cos(altitude * radians) * cos(other_altitude * radians) * azimuth_sine * azimuth_sine;
+    return 2.0 * asin(sqrt(fmin(haversine, 1.0))) / radians * 3600.0;
+}
+
+/// Prints the timing of one path as a JSON line
+static void bench_report(BenchInput const *input, const char *path, f64 best_ms, f64 baseline_ms) {
+    f64 const positions = (f64) (input->count * input->time_count);
+    printf("{\"bench\":\"ephemeris\",\"path\":\"%s\",\"isa\":\"%s\",\"objects\":%zu,\"times\":%zu,\"best_ms\":%.3f,"
+           "\"ns_per_position\":%.2f,\"speedup\":%.2f}\n",
+           path, observe_batch_instruction_set(), input->count, input->time_count, best_ms,
+           best_ms * 1.0e6 / positions, best_ms > 0.0 ? baseline_ms / best_ms : 0.0);
+}
+
+int main(int argc, char **argv) {
+    usize time_count = BENCH_DEFAULT_TIMES;
+    usize repetitions = BENCH_DEFAULT_REPETITIONS;
+    f64 tolerance = BENCH_DEFAULT_TOLERANCE;
+    Geographic observer = { .latitude = 48.2, .longitude = 16.37 };
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--times") == 0) {
+            time_count = (usize) strtoull(argv[i + 1], nil, 10);
+        } else if (strcmp(argv[i], "--repetitions") == 0) {
+            repetitions = (usize) strtoull(argv[i + 1], nil, 10);
+        } else if (strcmp(argv[i], "--tolerance") == 0) {
+            tolerance = strtod(argv[i + 1], nil);
+        } else if (strcmp(argv[i], "--latitude") == 0) {
+            observer.latitude = strtod(argv[i + 1], nil);
+        } else if (strcmp(argv[i], "--longitude") == 0) {
+            observer.longitude = strtod(argv[i + 1], nil);
+        }
+    }
+    if (time_count == 0 || repetitions == 0) {
+        fprintf(stderr, "The number of timestamps and repetitions must be positive\n");
+        return 1;
+    }
+
+    Catalog catalog = catalog_acquire();
+    MemoryArena arena = memory_arena_identity(ALIGNMENT8);
+    BenchInput input = { .objects = catalog.objects, .count = catalog.object_count, .observer = observer };
+    input.right_ascensions = (f64 *) memory_arena_alloc(&arena, sizeof(f64) * input.count);
+    input.declinations = (f64 *) memory_arena_alloc(&arena, sizeof(f64) * input.count);
+    for (usize i = 0; i < input.count; ++i) {
+        input.right_ascensions[i] = input.objects[i].position.right_ascension;
+        input.declinations[i] = input.objects[i].position.declination;
+    }
+
+    input.time_count = time_count;
+    input.times = (Time *) memory_arena_alloc(&arena, sizeof(Time) * time_count);
+    input.seconds = (f64 *) memory_arena_alloc(&arena, sizeof(f64) * time_count);
+    Time const start = time_now();
+    for (usize t = 0; t < time_count; ++t) {
+        input.times[t] = start;
+        time_add(&input.times[t], (f64) (t * BENCH_TIME_STEP), UNIT_MINUTES);
+        input.seconds[t] = (f64) time_unix(&input.times[t]);
+    }
+
+    usize const total = input.count * time_count;
+    f64 *call_altitudes = (f64 *) memory_arena_alloc(&arena, sizeof(f64) * total);
+    f64 *call_azimuths = (f64 *) memory_arena_alloc(&arena, sizeof(f64) * total);
+    f64 *batch_altitudes = (f64 *) memory_arena_alloc(&arena, sizeof(f64) * total);
+    f64 *batch_azimuths = (f64 *) memory_arena_alloc(&arena, sizeof(f64) * total);
+
+    // The kernel scratch is kept apart so that clearing it leaves the inputs intact
+    MemoryArena scratch = memory_arena_identity(ALIGNMENT8);
+    f64 best_call = INFINITY;
+    f64 best_batch = INFINITY;
+    for (usize r = 0; r < repetitions; ++r) {
+        best_call = fmin(best_call, bench_per_call(&input, call_altitudes, call_azimuths));
+        best_batch = fmin(best_batch, bench_batch(&input, &scratch, batch_altitudes, batch_azimuths));
+    }
+    bench_report(&input, "per_call", best_call, best_call);
+    bench_report(&input, "batch", best_batch, best_call);
+
+    // The separation is compared rather than the azimuth, which is unstable close to the zenith
+    f64 max_separation = 0.0;
+    f64 max_altitude = 0.0;
+    for (usize i = 0; i < total; ++i) {
+        max_separation = fmax(max_separation, bench_separation(call_altitudes[i], call_azimuths[i],
+                                                               batch_altitudes[i], batch_azimuths[i]));
+        max_altitude = fmax(max_altitude, fabs(call_altitudes[i] - batch_altitudes[i]) * 3600.0);
+    }
+    b8 const passed = max_separation <= tolerance;
+    printf("{\"bench\":\"ephemeris\",\"check\":\"accuracy\",\"positions\":%zu,\"max_separation_arcsec\":%.4f,"
+           "\"max_altitude_error_arcsec\":%.4f,\"tolerance_arcsec\":%.1f,\"passed\":%s}\n",
+           total, max_separation, max_altitude, tolerance, passed ? "true" : "false");
+
+    memory_arena_destroy(&scratch);
+    memory_arena_destroy(&arena);
+    return passed ? 0 : 1;
+}
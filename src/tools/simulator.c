@@ -0,0 +1,641 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <libcore/arch/thread.h>
+#include <libcore/timer.h>
+
+#include "simulator.h"
+
+enum {
+    SIMULATOR_BUFFER_SIZE = 16384,
+    SIMULATOR_VALUE_SIZE = 4096,
+
+    /// Interval (ms) in which blocked sockets check whether the simulator stops
+    SIMULATOR_POLL_INTERVAL = 100,
+
+    /// Alpaca error numbers
+    SIMULATOR_ERROR_NOT_IMPLEMENTED = 0x400,
+    SIMULATOR_ERROR_INVALID_VALUE = 0x401,
+    SIMULATOR_ERROR_INJECTED = 0x500,
+};
+
+struct AlpacaSimulator {
+    AlpacaSimulatorConfig config;
+    int socket;
+    u16 port;
+
+    /// Monotonic time (ms) at which the simulator was started, drives the simulated sky
+    f64 start;
+
+    /// Connected state of every device, telescopes first, shared by the connection threads
+    b8 *connected;
+
+    /// Socket of the discovery responder, -1 if it is disabled
+    int discovery_socket;
+
+    b8 running;
+    b8 accepting;
+    b8 responding;
+    u32 connections;
+    u64 connection_count;
+    u64 requests;
+    u32 server_tx_id;
+};
+
+typedef struct SimulatorConnection {
+    AlpacaSimulator *simulator;
+    int socket;
+
+    /// State of the pseudo random generator for jitter and error injection
+    u64 random;
+} SimulatorConnection;
+
+/// A parsed HTTP request
+typedef struct SimulatorRequest {
+    b8 put;
+    char path[256];
+    char query[512];
+    const char *body;
+    usize body_length;
+    b8 close;
+} SimulatorRequest;
+
+/// Produces the next pseudo random number
+static u64 simulator_random(SimulatorConnection *connection) {
+    u64 z = (connection->random += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/// Produces a pseudo random number in [0, 1)
+static f64 simulator_random_unit(SimulatorConnection *connection) {
+    return (f64) (simulator_random(connection) >> 11) / (f64) (1ull << 53);
+}
+
+/// Seconds since the simulator was started
+static f64 simulator_time(AlpacaSimulator const *simulator) {
+    return (timer_now() - simulator->start) / 1000.0;
+}
+
+/// Retrieves a form or query parameter, names are case-insensitive
+static u32 simulator_parameter_u32(const char *data, usize length, const char *name) {
+    usize name_length = strlen(name);
+    for (usize i = 0; i + name_length < length; ++i) {
+        b8 begin = i == 0 || data[i - 1] == '&' || data[i - 1] == '?';
+        if (begin && strncasecmp(data + i, name, name_length) == 0 && data[i + name_length] == '=') {
+            return (u32) strtoul(data + i + name_length + 1, nil, 10);
+        }
+    }
+    return 0;
+}
+
+/// Checks whether a form parameter is set to true
+static b8 simulator_parameter_true(const char *data, usize length, const char *name) {
+    usize name_length = strlen(name);
+    for (usize i = 0; i + name_length + 5 <= length; ++i) {
+        if (strncasecmp(data + i, name, name_length) == 0 && data[i + name_length] == '=') {
+            return strncasecmp(data + i + name_length + 1, "true", 4) == 0;
+        }
+    }
+    return false;
+}
+
+/// Simulated mount position, the mount slews 60° in azimuth within ten seconds once per minute
+static void simulator_telescope_position(AlpacaSimulator const *simulator, u32 number, f64 *altitude, f64 *azimuth,
+                                         b8 *slewing) {
+    f64 t = simulator_time(simulator);
+    f64 cycle = floor(t / 60.0);
+    f64 phase = t - cycle * 60.0;
+    f64 progress = fmin(phase / 10.0, 1.0);
+    f64 from = 30.0 + 20.0 * sin(cycle * 0.7 + number);
+    f64 to = 30.0 + 20.0 * sin((cycle + 1.0) * 0.7 + number);
+    *altitude = from + (to - from) * progress;
+    *azimuth = fmod(number * 40.0 + cycle * 60.0 + 60.0 * progress + 0.004 * phase, 360.0);
+    *slewing = progress < 1.0;
+}
+
+/// Simulated local sidereal time (hours), starts at zero and runs at the sidereal rate
+static f64 simulator_sidereal_time(AlpacaSimulator const *simulator) {
+    return fmod(simulator_time(simulator) * 1.00273791 / 3600.0, 24.0);
+}
+
+/// Telescope methods that are accepted without changing the simulated sky
+static b8 simulator_telescope_method(const char *attribute) {
+    static const char *const methods[] = {
+        "tracking", "slewtocoordinatesasync", "moveaxis", "pulseguide", "abortslew", "park", "unpark",
+    };
+    for (usize i = 0; i < sizeof methods / sizeof methods[0]; ++i) {
+        if (strcasecmp(attribute, methods[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Formats the value of a telescope attribute, returns the alpaca error number
+static u32 simulator_telescope_value(AlpacaSimulator const *simulator, u32 number, const char *attribute,
+                                     char *value, usize size) {
+    f64 altitude = 0.0;
+    f64 azimuth = 0.0;
+    b8 slewing = false;
+    simulator_telescope_position(simulator, number, &altitude, &azimuth, &slewing);
+
+    if (strcasecmp(attribute, "altitude") == 0) {
+        snprintf(value, size, "%.6f", altitude);
+    } else if (strcasecmp(attribute, "azimuth") == 0) {
+        snprintf(value, size, "%.6f", azimuth);
+    } else if (strcasecmp(attribute, "siderealtime") == 0) {
+        snprintf(value, size, "%.6f", simulator_sidereal_time(simulator));
+    } else if (strcasecmp(attribute, "rightascension") == 0) {
+        snprintf(value, size, "%.6f", fmod(simulator_sidereal_time(simulator) + (180.0 - azimuth) / 15.0 + 24.0, 24.0));
+    } else if (strcasecmp(attribute, "declination") == 0) {
+        snprintf(value, size, "%.6f", altitude - 41.8);
+    } else if (strcasecmp(attribute, "slewing") == 0) {
+        snprintf(value, size, "%s", slewing ? "true" : "false");
+    } else if (strcasecmp(attribute, "tracking") == 0) {
+        snprintf(value, size, "%s", slewing ? "false" : "true");
+    } else if (strcasecmp(attribute, "atpark") == 0 || strcasecmp(attribute, "athome") == 0) {
+        snprintf(value, size, "false");
+    } else if (strcasecmp(attribute, "canslew") == 0 || strcasecmp(attribute, "canslewaltaz") == 0) {
+        snprintf(value, size, "true");
+    } else if (strcasecmp(attribute, "alignmentmode") == 0) {
+        snprintf(value, size, "1");
+    } else if (strcasecmp(attribute, "sitelatitude") == 0) {
+        snprintf(value, size, "48.2");
+    } else if (strcasecmp(attribute, "sitelongitude") == 0) {
+        snprintf(value, size, "16.37");
+    } else {
+        return SIMULATOR_ERROR_NOT_IMPLEMENTED;
+    }
+    return 0;
+}
+
+/// Formats the value of an observing conditions attribute, returns the alpaca error number
+static u32 simulator_observing_conds_value(AlpacaSimulator const *simulator, u32 number, const char *attribute,
+                                           char *value, usize size) {
+    // Slow daily drifts with faster variations on top, different for every device
+    f64 t = simulator_time(simulator) + number * 1000.0;
+    f64 slow = sin(t / 3600.0);
+    f64 fast = sin(t / 7.0) * sin(t / 13.0);
+
+    static const struct {
+        const char *name;
+        f64 base;
+        f64 slow;
+        f64 fast;
+    } attributes[] = {
+        { "averageperiod", 0.0, 0.0, 0.0 },       { "cloudcover", 30.0, 20.0, 5.0 },
+        { "dewpoint", 4.0, 2.0, 0.1 },            { "humidity", 70.0, 10.0, 1.0 },
+        { "pressure", 1013.0, 5.0, 0.2 },         { "rainrate", 0.0, 0.0, 0.0 },
+        { "skybrightness", 0.1, 0.05, 0.01 },     { "skyquality", 20.5, 0.5, 0.05 },
+        { "skytemperature", -20.0, 3.0, 0.5 },    { "starfwhm", 2.5, 0.5, 0.3 },
+        { "temperature", 8.0, 4.0, 0.2 },         { "winddirection", 180.0, 90.0, 20.0 },
+        { "windgust", 6.0, 3.0, 2.0 },            { "windspeed", 3.0, 2.0, 1.0 },
+    };
+
+    for (usize i = 0; i < sizeof attributes / sizeof attributes[0]; ++i) {
+        if (strcasecmp(attribute, attributes[i].name) == 0) {
+            snprintf(value, size, "%.6f", attributes[i].base + attributes[i].slow * slow + attributes[i].fast * fast);
+            return 0;
+        }
+    }
+    return SIMULATOR_ERROR_NOT_IMPLEMENTED;
+}
+
+/// Formats the configured devices
+static void simulator_configured_devices(AlpacaSimulator const *simulator, char *value, usize size) {
+    usize length = (usize) snprintf(value, size, "[");
+    u32 count = simulator->config.telescopes + simulator->config.observing_conditions;
+    for (u32 i = 0; i < count && length < size; ++i) {
+        b8 telescope = i < simulator->config.telescopes;
+        u32 number = telescope ? i : i - simulator->config.telescopes;
+        length += (usize) snprintf(value + length, size - length,
+                                   "%s{\"DeviceName\":\"Simulated %s %u\",\"DeviceType\":\"%s\",\"DeviceNumber\":%u,"
+                                   "\"UniqueID\":\"00000000-0000-4000-8000-%012u\"}",
+                                   i == 0 ? "" : ",", telescope ? "Telescope" : "Observatory", number,
+                                   telescope ? "Telescope" : "ObservingConditions", number, i);
+    }
+    if (length < size) {
+        snprintf(value + length, size - length, "]");
+    }
+}
+
+/// Resolves the index of a device within the connected states, or -1 for unknown devices
+static ssize simulator_device_index(AlpacaSimulator const *simulator, const char *type, u32 number) {
+    if (strcasecmp(type, "telescope") == 0 && number < simulator->config.telescopes) {
+        return (ssize) number;
+    }
+    if (strcasecmp(type, "observingconditions") == 0 && number < simulator->config.observing_conditions) {
+        return (ssize) (simulator->config.telescopes + number);
+    }
+    return -1;
+}
+
+/// Answers a device request, returns the alpaca error number
+static u32 simulator_device(AlpacaSimulator *simulator, SimulatorRequest const *request, char *value, usize size,
+                            const char **message) {
+    char type[32] = { 0 };
+    char attribute[64] = { 0 };
+    u32 number = 0;
+    if (sscanf(request->path, "/api/v1/%31[^/]/%u/%63s", type, &number, attribute) != 3) {
+        *message = "Unknown device";
+        return SIMULATOR_ERROR_INVALID_VALUE;
+    }
+
+    ssize index = simulator_device_index(simulator, type, number);
+    if (index < 0) {
+        *message = "Unknown device";
+        return SIMULATOR_ERROR_INVALID_VALUE;
+    }
+
+    if (strcasecmp(attribute, "connected") == 0) {
+        if (request->put) {
+            b8 const connected = simulator_parameter_true(request->body, request->body_length, "Connected");
+            __atomic_store_n(&simulator->connected[index], connected, __ATOMIC_RELAXED);
+        } else {
+            b8 const connected = __atomic_load_n(&simulator->connected[index], __ATOMIC_RELAXED);
+            snprintf(value, size, "%s", connected ? "true" : "false");
+        }
+        return 0;
+    }
+    if (request->put && index < (ssize) simulator->config.telescopes && simulator_telescope_method(attribute)) {
+        return 0;
+    }
+    if (request->put) {
+        *message = "Property is read-only";
+        return SIMULATOR_ERROR_NOT_IMPLEMENTED;
+    }
+    if (strcasecmp(attribute, "name") == 0 || strcasecmp(attribute, "description") == 0) {
+        snprintf(value, size, "\"Simulated %s %u\"", type, number);
+        return 0;
+    }
+
+    u32 error = index < (ssize) simulator->config.telescopes
+                        ? simulator_telescope_value(simulator, number, attribute, value, size)
+                        : simulator_observing_conds_value(simulator, number, attribute, value, size);
+    if (error != 0) {
+        *message = "Property is not implemented";
+    }
+    return error;
+}
+
+/// Sends the whole buffer
+static b8 simulator_send(int socket, const char *data, usize length) {
+    while (length > 0) {
+        ssize sent = send(socket, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        length -= (usize) sent;
+    }
+    return true;
+}
+
+/// Answers a parsed request
+static b8 simulator_respond(SimulatorConnection *connection, SimulatorRequest const *request) {
+    AlpacaSimulator *simulator = connection->simulator;
+    AlpacaSimulatorConfig const *config = &simulator->config;
+
+    // Latency and jitter are applied before the response is produced
+    f64 delay = (f64) config->latency;
+    if (config->jitter > 0) {
+        delay += (simulator_random_unit(connection) * 2.0 - 1.0) * config->jitter;
+    }
+    if (delay > 0.0) {
+        thread_sleep((u64) delay);
+    }
+
+    char value[SIMULATOR_VALUE_SIZE] = "null";
+
+    const char *message = "";
+    u32 error = 0;
+    b8 found = true;
+    if (config->error_rate > 0.0 && simulator_random_unit(connection) < config->error_rate) {
+        error = SIMULATOR_ERROR_INJECTED;
+        message = "Injected error";
+    } else if (strcmp(request->path, "/management/apiversions") == 0) {
+        snprintf(value, sizeof value, "[1]");
+    } else if (strcmp(request->path, "/management/v1/description") == 0) {
+        snprintf(value, sizeof value,
+                 "{\"ServerName\":\"Kopernikus Simulator\",\"Manufacturer\":\"Kopernikus\","
+                 "\"ManufacturerVersion\":\"1.0\",\"Location\":\"localhost\"}");
+    } else if (strcmp(request->path, "/management/v1/configureddevices") == 0) {
+        simulator_configured_devices(simulator, value, sizeof value);
+    } else if (strncmp(request->path, "/api/v1/", 8) == 0) {
+        error = simulator_device(simulator, request, value, sizeof value, &message);
+    } else {
+        found = false;
+    }
+
+    const char *query = request->put ? request->body : request->query;
+    usize query_length = request->put ? request->body_length : strlen(request->query);
+    u32 client_tx_id = simulator_parameter_u32(query, query_length, "ClientTransactionID");
+    u32 server_tx_id = __atomic_add_fetch(&simulator->server_tx_id, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&simulator->requests, 1, __ATOMIC_RELAXED);
+
+    char body[SIMULATOR_VALUE_SIZE + 256];
+    int body_length = 0;
+    if (request->put) {
+        body_length = snprintf(body, sizeof body,
+                               "{\"ClientTransactionID\":%u,\"ServerTransactionID\":%u,\"ErrorNumber\":%u,"
+                               "\"ErrorMessage\":\"%s\"}",
+                               client_tx_id, server_tx_id, error, message);
+    } else {
+        body_length = snprintf(body, sizeof body,
+                               "{\"Value\":%s,\"ClientTransactionID\":%u,\"ServerTransactionID\":%u,"
+                               "\"ErrorNumber\":%u,\"ErrorMessage\":\"%s\"}",
+                               error == 0 ? value : "null", client_tx_id, server_tx_id, error, message);
+    }
+
+    char header[256];
+    int header_length = snprintf(header, sizeof header,
+                                 "HTTP/1.1 %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\n"
+                                 "Connection: %s\r\n\r\n",
+                                 found ? "200 OK" : "404 Not Found", found ? body_length : 0,
+                                 request->close ? "close" : "keep-alive");
+    return simulator_send(connection->socket, header, (usize) header_length) &&
+           (!found || simulator_send(connection->socket, body, (usize) body_length));
+}
+
+/// Finds the end of the request header, returns zero if it is incomplete
+static usize simulator_header_end(const char *buffer, usize length) {
+    for (usize i = 0; i + 3 < length; ++i) {
+        if (memcmp(buffer + i, "\r\n\r\n", 4) == 0) {
+            return i + 4;
+        }
+    }
+    return 0;
+}
+
+/// Parses the request header, returns the content length or -1 for malformed requests
+static ssize simulator_parse(const char *buffer, usize header_length, SimulatorRequest *request) {
+    *request = (SimulatorRequest) { 0 };
+    char method[8] = { 0 };
+    char target[768] = { 0 };
+    if (sscanf(buffer, "%7s %767s", method, target) != 2) {
+        return -1;
+    }
+    request->put = strcmp(method, "PUT") == 0;
+
+    char *query = strchr(target, '?');
+    if (query != nil) {
+        *query = '\0';
+        snprintf(request->query, sizeof request->query, "%s", query + 1);
+    }
+    snprintf(request->path, sizeof request->path, "%s", target);
+
+    ssize content_length = 0;
+    for (const char *line = strstr(buffer, "\r\n"); line != nil && line < buffer + header_length;
+         line = strstr(line + 2, "\r\n")) {
+        const char *field = line + 2;
+        if (strncasecmp(field, "Content-Length:", 15) == 0) {
+            content_length = (ssize) strtol(field + 15, nil, 10);
+        } else if (strncasecmp(field, "Connection:", 11) == 0) {
+            request->close = strncasecmp(field + 11 + strspn(field + 11, " "), "close", 5) == 0;
+        }
+    }
+    return content_length;
+}
+
+/// Serves the requests of one connection until it is closed
+static void *simulator_connection_task(void *args) {
+    SimulatorConnection connection = *(SimulatorConnection *) args;
+    free(args);
+    AlpacaSimulator *simulator = connection.simulator;
+
+    char *buffer = (char *) malloc(SIMULATOR_BUFFER_SIZE + 1);
+    usize length = 0;
+    while (__atomic_load_n(&simulator->running, __ATOMIC_ACQUIRE)) {
+        usize header_length = simulator_header_end(buffer, length);
+        SimulatorRequest request = { 0 };
+        ssize content_length = 0;
+        if (header_length > 0) {
+            buffer[length] = '\0';
+            content_length = simulator_parse(buffer, header_length, &request);
+            if (content_length < 0 || header_length + (usize) content_length > SIMULATOR_BUFFER_SIZE) {
+                break;
+            }
+        }
+
+        // Wait for the complete request
+        if (header_length == 0 || length < header_length + (usize) content_length) {
+            if (length == SIMULATOR_BUFFER_SIZE) {
+                break;
+            }
+            ssize received = recv(connection.socket, buffer + length, SIMULATOR_BUFFER_SIZE - length, 0);
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                continue;
+            }
+            if (received <= 0) {
+                break;
+            }
+            length += (usize) received;
+            continue;
+        }
+
+        request.body = buffer + header_length;
+        request.body_length = (usize) content_length;
+        if (!simulator_respond(&connection, &request) || request.close) {
+            break;
+        }
+
+        // Keep pipelined requests
+        usize consumed = header_length + (usize) content_length;
+        memmove(buffer, buffer + consumed, length - consumed);
+        length -= consumed;
+    }
+
+    free(buffer);
+    close(connection.socket);
+    __atomic_sub_fetch(&simulator->connections, 1, __ATOMIC_RELEASE);
+    return nil;
+}
+
+/// Accepts connections and serves each of them on its own thread
+static void *simulator_accept_task(void *args) {
+    AlpacaSimulator *simulator = (AlpacaSimulator *) args;
+    while (__atomic_load_n(&simulator->running, __ATOMIC_ACQUIRE)) {
+        struct pollfd descriptor = { .fd = simulator->socket, .events = POLLIN };
+        if (poll(&descriptor, 1, SIMULATOR_POLL_INTERVAL) <= 0) {
+            continue;
+        }
+
+        int client = accept(simulator->socket, nil, nil);
+        if (client < 0) {
+            continue;
+        }
+
+        // Responses are small, do not wait for more data to fill a segment
+        int enable = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof enable);
+        struct timeval timeout = { .tv_sec = 0, .tv_usec = SIMULATOR_POLL_INTERVAL * 1000 };
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+
+        SimulatorConnection *connection = (SimulatorConnection *) malloc(sizeof(SimulatorConnection));
+        connection->simulator = simulator;
+        connection->socket = client;
+        connection->random = simulator->config.seed ^ (++simulator->connection_count * 0x9e3779b97f4a7c15ull);
+        __atomic_add_fetch(&simulator->connections, 1, __ATOMIC_RELEASE);
+        thread_create(simulator_connection_task, connection);
+    }
+
+    __atomic_store_n(&simulator->accepting, false, __ATOMIC_RELEASE);
+    return nil;
+}
+
+/// Answers alpaca discovery requests with the port of the simulator
+static void *simulator_discovery_task(void *args) {
+    AlpacaSimulator *simulator = (AlpacaSimulator *) args;
+    while (__atomic_load_n(&simulator->running, __ATOMIC_ACQUIRE)) {
+        struct pollfd descriptor = { .fd = simulator->discovery_socket, .events = POLLIN };
+        if (poll(&descriptor, 1, SIMULATOR_POLL_INTERVAL) <= 0) {
+            continue;
+        }
+
+        char request[64] = { 0 };
+        struct sockaddr_in source = { 0 };
+        socklen_t source_length = sizeof source;
+        ssize received = recvfrom(simulator->discovery_socket, request, sizeof request - 1, 0,
+                                  (struct sockaddr *) &source, &source_length);
+        if (received <= 0 || strncmp(request, "alpacadiscovery1", 16) != 0) {
+            continue;
+        }
+
+        char response[64];
+        int length = snprintf(response, sizeof response, "{\"AlpacaPort\":%u}", simulator->port);
+        sendto(simulator->discovery_socket, response, (usize) length, 0, (struct sockaddr *) &source, source_length);
+    }
+
+    __atomic_store_n(&simulator->responding, false, __ATOMIC_RELEASE);
+    return nil;
+}
+
+/// Binds the UDP socket of the discovery responder, returns -1 on failure
+static int simulator_discovery_bind(u16 port) {
+    int responder = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (responder < 0) {
+        return -1;
+    }
+
+    // Broadcasts only reach sockets that are bound to the wildcard address
+    int enable = 1;
+    setsockopt(responder, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof enable);
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(responder, (struct sockaddr *) &address, sizeof address) != 0) {
+        close(responder);
+        return -1;
+    }
+    return responder;
+}
+
+/// Starts the simulator on a background thread
+AlpacaSimulator *alpaca_simulator_start(AlpacaSimulatorConfig const *config) {
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server < 0) {
+        return nil;
+    }
+
+    int enable = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof enable);
+
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config->port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof address;
+    if (bind(server, (struct sockaddr *) &address, sizeof address) != 0 || listen(server, SOMAXCONN) != 0 ||
+        getsockname(server, (struct sockaddr *) &address, &address_length) != 0) {
+        close(server);
+        return nil;
+    }
+
+    int responder = -1;
+    if (config->discovery_port != 0) {
+        responder = simulator_discovery_bind(config->discovery_port);
+        if (responder < 0) {
+            close(server);
+            return nil;
+        }
+    }
+
+    AlpacaSimulator *simulator = (AlpacaSimulator *) calloc(1, sizeof(AlpacaSimulator));
+    simulator->config = *config;
+    simulator->socket = server;
+    simulator->discovery_socket = responder;
+    simulator->port = ntohs(address.sin_port);
+    simulator->start = timer_now();
+    simulator->connected = (b8 *) calloc(config->telescopes + config->observing_conditions + 1, sizeof(b8));
+    simulator->running = true;
+    simulator->accepting = true;
+    thread_create(simulator_accept_task, simulator);
+    if (responder >= 0) {
+        simulator->responding = true;
+        thread_create(simulator_discovery_task, simulator);
+    }
+    return simulator;
+}
+
+/// Retrieves the port the simulator listens on
+u16 alpaca_simulator_port(AlpacaSimulator const *simulator) {
+    return simulator->port;
+}
+
+/// Retrieves the number of requests that were answered so far
+u64 alpaca_simulator_requests(AlpacaSimulator const *simulator) {
+    return __atomic_load_n(&simulator->requests, __ATOMIC_RELAXED);
+}
+
+/// Stops the simulator, waits for all connections to close and frees it
+void alpaca_simulator_stop(AlpacaSimulator *simulator) {
+    __atomic_store_n(&simulator->running, false, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&simulator->accepting, __ATOMIC_ACQUIRE) ||
+           __atomic_load_n(&simulator->responding, __ATOMIC_ACQUIRE) ||
+           __atomic_load_n(&simulator->connections, __ATOMIC_ACQUIRE) > 0) {
+        thread_sleep(SIMULATOR_POLL_INTERVAL / 2);
+    }
+
+    close(simulator->socket);
+    if (simulator->discovery_socket >= 0) {
+        close(simulator->discovery_socket);
+    }
+    free(simulator->connected);
+    free(simulator);
+}
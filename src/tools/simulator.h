@@ -0,0 +1,80 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef KOPERNIKUS_SIMULATOR_H
+#define KOPERNIKUS_SIMULATOR_H
+
+#include <libcore/types.h>
+
+/// Configuration of the local alpaca simulator
+typedef struct AlpacaSimulatorConfig {
+    /// The port on localhost, zero picks a free port
+    u16 port;
+
+    /// Number of simulated telescopes
+    u32 telescopes;
+
+    /// Number of simulated observing conditions devices
+    u32 observing_conditions;
+
+    /// Base latency (ms) of every response
+    u32 latency;
+
+    /// Maximum random deviation (ms) from the base latency
+    u32 jitter;
+
+    /// Probability (0 to 1) that a request fails with an alpaca error
+    f64 error_rate;
+
+    /// UDP port of the alpaca discovery responder, zero disables it
+    u16 discovery_port;
+
+    /// Seed for latency jitter and error injection, the n-th connection always
+    /// sees the same sequence for the same seed
+    u64 seed;
+} AlpacaSimulatorConfig;
+
+/// Minimal alpaca server that serves the management API and simulated
+/// telescope and observing conditions devices
+typedef struct AlpacaSimulator AlpacaSimulator;
+
+/// Starts the simulator on a background thread
+/// @param config The simulator configuration
+/// @return The simulator, or nil if the socket could not be bound
+AlpacaSimulator *alpaca_simulator_start(AlpacaSimulatorConfig const *config);
+
+/// Retrieves the port the simulator listens on
+/// @param simulator The simulator
+/// @return The port
+u16 alpaca_simulator_port(AlpacaSimulator const *simulator);
+
+/// Retrieves the number of requests that were answered so far
+/// @param simulator The simulator
+/// @return The request count
+u64 alpaca_simulator_requests(AlpacaSimulator const *simulator);
+
+/// Stops the simulator, waits for all connections to close and frees it
+/// @param simulator The simulator
+void alpaca_simulator_stop(AlpacaSimulator *simulator);
+
+#endif// KOPERNIKUS_SIMULATOR_H
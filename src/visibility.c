@@ -0,0 +1,334 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <libcore/arch/thread.h>
+#include <libcore/timer.h>
+#include <solaris/arena.h>
+
+#include "observe.h"
+#include "visibility.h"
+
+/// Seconds that rise, transit, set and the duration look ahead
+#define VISIBILITY_HORIZON (24.0 * 3600.0)
+
+/// Sort key of an object in one order
+typedef struct VisibilityKey {
+    f64 key;
+    u32 index;
+} VisibilityKey;
+
+/// Creates a new visibility index
+void visibility_index_make(VisibilityIndex *index, Catalog const *catalog, JobPool *pool) {
+    usize const count = catalog->object_count;
+    index->catalog = catalog;
+    index->pool = pool;
+    index->arena = memory_arena_identity(ALIGNMENT8);
+    index->scratch = memory_arena_identity(ALIGNMENT8);
+    for (usize s = 0; s < 2; ++s) {
+        VisibilitySnapshot *snapshot = index->snapshots + s;
+        snapshot->entries = (VisibilityEntry *) memory_arena_alloc(&index->arena, sizeof(VisibilityEntry) * count);
+        snapshot->count = count;
+        for (usize order = 0; order < VISIBILITY_ORDER_COUNT; ++order) {
+            snapshot->orders[order] = (u32 *) memory_arena_alloc(&index->arena, sizeof(u32) * count);
+        }
+    }
+    index->front = 0;
+    index->published = false;
+    index->pending = false;
+    index->busy = false;
+    index->refreshed = 0.0;
+    index->threshold = 0.0;
+
+    index->right_ascensions = (f64 *) memory_arena_alloc(&index->arena, sizeof(f64) * count);
+    index->declinations = (f64 *) memory_arena_alloc(&index->arena, sizeof(f64) * count);
+    index->sampled = false;
+    index->altitudes = (f64 *) memory_arena_alloc(&index->arena, sizeof(f64) * count * VISIBILITY_SAMPLES);
+    index->head = 0;
+    index->start = 0.0;
+    index->current_altitudes = (f64 *) memory_arena_alloc(&index->arena, sizeof(f64) * count);
+    index->current_azimuths = (f64 *) memory_arena_alloc(&index->arena, sizeof(f64) * count);
+    index->transit_samples = (u32 *) memory_arena_alloc(&index->arena, sizeof(u32) * count);
+}
+
+/// Destroys the index
+void visibility_index_destroy(VisibilityIndex *index) {
+    while (__atomic_load_n(&index->busy, __ATOMIC_ACQUIRE)) {
+        thread_sleep(1);
+    }
+    memory_arena_destroy(&index->scratch);
+    memory_arena_destroy(&index->arena);
+}
+
+/// Samples the altitudes of every object at the specified times into consecutive rows
+static void visibility_index_sample(VisibilityIndex *index, f64 const *times, usize time_count, f64 *altitudes) {
+    ObserveBatch batch = { 0 };
+    observe_batch_make(&batch, &index->scratch, &index->observer, times, time_count);
+    observe_batch_horizontal(&batch, &index->scratch, index->right_ascensions, index->declinations,
+                             index->catalog->object_count, altitudes, nil);
+}
+
+/// Recomputes the equatorial positions and samples the whole window starting at the current step
+static void visibility_index_rebuild(VisibilityIndex *index, f64 now) {
+    // Precession moves the positions so slowly that they are only refreshed along with the samples
+    for (usize i = 0; i < index->catalog->object_count; ++i) {
+        Equatorial position = object_position(index->catalog->objects + i, &index->time);
+        index->right_ascensions[i] = position.right_ascension;
+        index->declinations[i] = position.declination;
+    }
+    index->epoch = now;
+    index->sampled_observer = index->observer;
+    index->sampled = true;
+    index->start = now - fmod(now, VISIBILITY_STEP);
+    index->head = 0;
+
+    f64 *times = (f64 *) memory_arena_alloc(&index->scratch, sizeof(f64) * VISIBILITY_SAMPLES);
+    for (usize k = 0; k < VISIBILITY_SAMPLES; ++k) {
+        times[k] = index->start + (f64) (k * VISIBILITY_STEP);
+    }
+    visibility_index_sample(index, times, VISIBILITY_SAMPLES, index->altitudes);
+}
+
+/// Samples the rows that entered the window since the last refresh in place of the oldest rows
+static void visibility_index_advance(VisibilityIndex *index, f64 now) {
+    usize const count = index->catalog->object_count;
+    while (index->start + VISIBILITY_STEP <= now) {
+        f64 const time = index->start + (f64) (VISIBILITY_SAMPLES * VISIBILITY_STEP);
+        visibility_index_sample(index, &time, 1, index->altitudes + index->head * count);
+        index->head = (index->head + 1) % VISIBILITY_SAMPLES;
+        index->start += VISIBILITY_STEP;
+    }
+}
+
+/// Derives rise, transit, set and duration of every object from the current positions and the samples
+static void visibility_index_derive(VisibilityIndex *index, VisibilitySnapshot *snapshot, f64 now) {
+    usize const count = index->catalog->object_count;
+    f64 const threshold = index->threshold;
+    VisibilityEntry *entries = snapshot->entries;
+    for (usize i = 0; i < count; ++i) {
+        entries[i] = (VisibilityEntry) {
+            .altitude = index->current_altitudes[i],
+            .azimuth = index->current_azimuths[i],
+            .culmination = index->current_altitudes[i],
+            .rise = -1.0,
+            .transit = 0.0,
+            .set = -1.0,
+            .duration = 0.0,
+        };
+        index->transit_samples[i] = 0;
+    }
+
+    // The rows are scanned in time order for all objects at once, which keeps the memory access
+    // sequential. Crossings of the threshold are interpolated linearly between two samples.
+    f64 const *previous = index->current_altitudes;
+    f64 previous_time = 0.0;
+    for (usize k = 1; k < VISIBILITY_SAMPLES && previous_time < VISIBILITY_HORIZON; ++k) {
+        f64 const sample_time = index->start + (f64) (k * VISIBILITY_STEP) - now;
+        if (sample_time <= previous_time) {
+            continue;
+        }
+        f64 const *row = index->altitudes + ((index->head + k) % VISIBILITY_SAMPLES) * count;
+        f64 const time = fmin(sample_time, VISIBILITY_HORIZON);
+        f64 const span = time - previous_time;
+        f64 const fraction = span / (sample_time - previous_time);
+        b8 const clipped = sample_time > VISIBILITY_HORIZON;
+
+        for (usize i = 0; i < count; ++i) {
+            VisibilityEntry *entry = entries + i;
+            f64 const from = previous[i];
+            f64 const to = clipped ? from + (row[i] - from) * fraction : row[i];
+            b8 const was_above = from >= threshold;
+            b8 const above = to >= threshold;
+            if (was_above != above) {
+                f64 const crossing = previous_time + span * (threshold - from) / (to - from);
+                if (above) {
+                    entry->rise = entry->rise < 0.0 ? crossing : entry->rise;
+                    entry->duration += time - crossing;
+                } else {
+                    entry->set = entry->set < 0.0 ? crossing : entry->set;
+                    entry->duration += crossing - previous_time;
+                }
+            } else if (above) {
+                entry->duration += span;
+            }
+            if (to > entry->culmination) {
+                entry->culmination = to;
+                entry->transit = time;
+                index->transit_samples[i] = clipped ? 0 : (u32) k;
+            }
+        }
+        previous = row;
+        previous_time = time;
+    }
+
+    // A parabola through the highest sample and its neighbours refines the transit
+    for (usize i = 0; i < count; ++i) {
+        usize const k = index->transit_samples[i];
+        if (k == 0 || k + 1 >= VISIBILITY_SAMPLES) {
+            continue;
+        }
+        f64 const before = index->altitudes[((index->head + k - 1) % VISIBILITY_SAMPLES) * count + i];
+        f64 const at = index->altitudes[((index->head + k) % VISIBILITY_SAMPLES) * count + i];
+        f64 const after = index->altitudes[((index->head + k + 1) % VISIBILITY_SAMPLES) * count + i];
+        f64 const curvature = before - 2.0 * at + after;
+        if (curvature >= 0.0) {
+            continue;
+        }
+        f64 const offset = 0.5 * (before - after) / curvature;
+        VisibilityEntry *entry = entries + i;
+        entry->transit = fmin(fmax(entry->transit + offset * VISIBILITY_STEP, 0.0), VISIBILITY_HORIZON);
+        entry->culmination = at - 0.25 * (before - after) * offset;
+    }
+}
+
+static int visibility_key_compare(const void *left, const void *right) {
+    VisibilityKey const *a = (VisibilityKey const *) left;
+    VisibilityKey const *b = (VisibilityKey const *) right;
+    if (a->key != b->key) {
+        return a->key < b->key ? -1 : 1;
+    }
+    return (a->index > b->index) - (a->index < b->index);
+}
+
+/// Retrieves the ascending sort key of an entry
+static f64 visibility_order_key(VisibilityEntry const *entry, VisibilityOrder order) {
+    switch (order) {
+        case VISIBILITY_ORDER_ALTITUDE:
+            return -entry->altitude;
+        case VISIBILITY_ORDER_RISE:
+            return entry->rise < 0.0 ? INFINITY : entry->rise;
+        case VISIBILITY_ORDER_TRANSIT:
+            return entry->transit;
+        case VISIBILITY_ORDER_SET:
+            return entry->set < 0.0 ? INFINITY : entry->set;
+        case VISIBILITY_ORDER_DURATION:
+            return -entry->duration;
+        default:
+            return 0.0;
+    }
+}
+
+/// Sorts the objects of the snapshot in every order
+static void visibility_index_sort(VisibilityIndex *index, VisibilitySnapshot *snapshot) {
+    usize const count = snapshot->count;
+    VisibilityKey *keys = (VisibilityKey *) memory_arena_alloc(&index->scratch, sizeof(VisibilityKey) * count);
+    for (usize order = 0; order < VISIBILITY_ORDER_COUNT; ++order) {
+        for (usize i = 0; i < count; ++i) {
+            keys[i] = (VisibilityKey) { visibility_order_key(snapshot->entries + i, (VisibilityOrder) order), (u32) i };
+        }
+        qsort(keys, count, sizeof(VisibilityKey), visibility_key_compare);
+        for (usize i = 0; i < count; ++i) {
+            snapshot->orders[order][i] = keys[i].index;
+        }
+    }
+}
+
+/// Computes the next snapshot into the back buffer, runs on the job pool
+static void visibility_index_refresh(void *arg) {
+    VisibilityIndex *index = (VisibilityIndex *) arg;
+    f64 const now = (f64) time_unix(&index->time);
+
+    // Advancing the samples row by row only pays off for small steps in time
+    b8 const moved = index->sampled_observer.latitude != index->observer.latitude ||
+                     index->sampled_observer.longitude != index->observer.longitude;
+    b8 const stale = now - index->epoch >= VISIBILITY_POSITION_AGE || now < index->start ||
+                     now - index->start >= (f64) (VISIBILITY_SAMPLES * VISIBILITY_STEP / 2);
+    if (!index->sampled || moved || stale) {
+        visibility_index_rebuild(index, now);
+    } else {
+        visibility_index_advance(index, now);
+    }
+
+    ObserveBatch batch = { 0 };
+    observe_batch_make(&batch, &index->scratch, &index->observer, &now, 1);
+    observe_batch_horizontal(&batch, &index->scratch, index->right_ascensions, index->declinations,
+                             index->catalog->object_count, index->current_altitudes, index->current_azimuths);
+
+    VisibilitySnapshot *snapshot = index->snapshots + (1 - index->front);
+    visibility_index_derive(index, snapshot, now);
+    visibility_index_sort(index, snapshot);
+    snapshot->time = index->time;
+    snapshot->threshold = index->threshold;
+
+    memory_arena_clear(&index->scratch);
+    __atomic_store_n(&index->busy, false, __ATOMIC_RELEASE);
+}
+
+/// Publishes a finished refresh and starts the next one once it is due
+void visibility_index_update(VisibilityIndex *index, Geographic const *observer, f64 threshold) {
+    if (__atomic_load_n(&index->busy, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    if (index->pending) {
+        index->front = 1 - index->front;
+        index->published = true;
+        index->pending = false;
+    }
+
+    b8 const changed = observer->latitude != index->observer.latitude ||
+                       observer->longitude != index->observer.longitude || threshold != index->threshold;
+    f64 const now = timer_now();
+    if (index->published && !changed && now - index->refreshed < VISIBILITY_REFRESH) {
+        return;
+    }
+
+    index->observer = *observer;
+    index->threshold = threshold;
+    index->time = time_now();
+    index->refreshed = now;
+    index->pending = true;
+    __atomic_store_n(&index->busy, true, __ATOMIC_RELEASE);
+    job_pool_submit(index->pool, visibility_index_refresh, index);
+}
+
+/// Retrieves the latest snapshot
+VisibilitySnapshot const *visibility_index_snapshot(VisibilityIndex const *index) {
+    return index->published ? index->snapshots + index->front : nil;
+}
+
+/// Collects the catalog indices of the objects that pass the query
+usize visibility_snapshot_query(VisibilitySnapshot const *snapshot, VisibilityQuery const *query, u32 *results,
+                                usize capacity) {
+    u32 const *order = snapshot->orders[query->order];
+    usize found = 0;
+    for (usize i = 0; i < snapshot->count && found < capacity; ++i) {
+        VisibilityEntry const *entry = snapshot->entries + order[i];
+        if (entry->altitude < query->min_altitude) {
+            // The objects that follow in altitude order are lower still
+            if (query->order == VISIBILITY_ORDER_ALTITUDE) {
+                break;
+            }
+            continue;
+        }
+        if (entry->duration < query->min_duration) {
+            if (query->order == VISIBILITY_ORDER_DURATION) {
+                break;
+            }
+            continue;
+        }
+        results[found++] = order[i];
+    }
+    return found;
+}
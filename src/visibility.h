@@ -0,0 +1,198 @@
+//
+// MIT License
+//
+// Copyright (c) 2024 Elias Engelbert Plank
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef KOPERNIKUS_VISIBILITY_H
+#define KOPERNIKUS_VISIBILITY_H
+
+#include <libcore/jobs.h>
+#include <solaris/catalog.h>
+
+enum {
+    /// Seconds between two altitude samples of the index
+    VISIBILITY_STEP = 900,
+
+    /// Number of altitude samples, enough to look one day ahead from any time within the first step
+    VISIBILITY_SAMPLES = 24 * 3600 / VISIBILITY_STEP + 2,
+
+    /// Time (ms) between two refreshes of the current positions
+    VISIBILITY_REFRESH = 15000,
+
+    /// Time (s) after which the equatorial positions are recomputed and the samples are rebuilt
+    VISIBILITY_POSITION_AGE = 24 * 3600,
+};
+
+/// The orders in which the objects of a snapshot can be listed
+typedef enum VisibilityOrder {
+    /// Highest current altitude first
+    VISIBILITY_ORDER_ALTITUDE = 0,
+
+    /// Earliest rise first, objects that do not rise come last
+    VISIBILITY_ORDER_RISE,
+
+    /// Earliest transit first
+    VISIBILITY_ORDER_TRANSIT,
+
+    /// Earliest set first, objects that do not set come last
+    VISIBILITY_ORDER_SET,
+
+    /// Longest time above the threshold first
+    VISIBILITY_ORDER_DURATION,
+
+    VISIBILITY_ORDER_COUNT,
+} VisibilityOrder;
+
+/// The visibility of one object, the times are seconds after the time of the snapshot and
+/// refer to the next day
+typedef struct VisibilityEntry {
+    /// The horizontal position at the time of the snapshot in degrees
+    f64 altitude;
+    f64 azimuth;
+
+    /// The highest altitude in degrees
+    f64 culmination;
+
+    /// The time the object crosses the threshold upwards, negative if it does not
+    f64 rise;
+
+    /// The time the object reaches its highest altitude
+    f64 transit;
+
+    /// The time the object crosses the threshold downwards, negative if it does not
+    f64 set;
+
+    /// The time the object spends above the threshold
+    f64 duration;
+} VisibilityEntry;
+
+/// The visibility of the whole catalog at one time
+typedef struct VisibilitySnapshot {
+    /// The time the snapshot was computed for
+    Time time;
+
+    /// The horizon threshold in degrees that rise, set and duration refer to
+    f64 threshold;
+
+    /// One entry per catalog object, in catalog order
+    VisibilityEntry *entries;
+    usize count;
+
+    /// The catalog indices of the objects in every order
+    u32 *orders[VISIBILITY_ORDER_COUNT];
+} VisibilitySnapshot;
+
+/// Filters the objects of a snapshot
+typedef struct VisibilityQuery {
+    /// The order of the results
+    VisibilityOrder order;
+
+    /// The lowest current altitude in degrees
+    f64 min_altitude;
+
+    /// The shortest time above the threshold in seconds
+    f64 min_duration;
+} VisibilityQuery;
+
+/// Visibility of every catalog object, the altitudes are sampled over the next day and the
+/// samples are advanced in the background as time goes on. Only the samples that enter the
+/// window and the current positions are computed on a refresh, everything else is derived.
+typedef struct VisibilityIndex {
+    /// The catalog whose objects are indexed
+    Catalog const *catalog;
+
+    /// The job pool that computes the refreshes
+    JobPool *pool;
+
+    /// Arena of the samples and snapshots, scratch holds the terms of a single refresh
+    MemoryArena arena;
+    MemoryArena scratch;
+
+    /// The snapshot at front is read by the render thread, the other one is written by the job
+    VisibilitySnapshot snapshots[2];
+    u32 front;
+    b8 published;
+
+    /// Whether the back snapshot is published once the refresh is done
+    b8 pending;
+
+    /// Whether a refresh is computed right now, only the job touches the fields below meanwhile
+    b8 busy;
+
+    /// The monotonic time (ms) of the last refresh
+    f64 refreshed;
+
+    /// The parameters of the next refresh
+    Geographic observer;
+    f64 threshold;
+    Time time;
+
+    /// Equatorial positions of the objects and when and where they were sampled
+    f64 *right_ascensions;
+    f64 *declinations;
+    f64 epoch;
+    Geographic sampled_observer;
+    b8 sampled;
+
+    /// Ring of altitude rows, one row per sample holds the altitude of every object. The
+    /// oldest row is found at head and is sampled at start.
+    f64 *altitudes;
+    usize head;
+    f64 start;
+
+    /// Per object working memory of a refresh
+    f64 *current_altitudes;
+    f64 *current_azimuths;
+    u32 *transit_samples;
+} VisibilityIndex;
+
+/// Creates a new visibility index, nothing is computed until it is updated
+/// @param index The index
+/// @param catalog The catalog, it must outlive the index
+/// @param pool The job pool for the refreshes
+void visibility_index_make(VisibilityIndex *index, Catalog const *catalog, JobPool *pool);
+
+/// Destroys the index, waits for a refresh that is still computed
+/// @param index The index
+void visibility_index_destroy(VisibilityIndex *index);
+
+/// Publishes a finished refresh and starts the next one once it is due or the parameters
+/// changed, cheap enough to be called every frame
+/// @param index The index
+/// @param observer The location of the observer
+/// @param threshold The horizon threshold in degrees
+void visibility_index_update(VisibilityIndex *index, Geographic const *observer, f64 threshold);
+
+/// Retrieves the latest snapshot
+/// @param index The index
+/// @return The snapshot, nil until the first refresh is done
+VisibilitySnapshot const *visibility_index_snapshot(VisibilityIndex const *index);
+
+/// Collects the catalog indices of the objects that pass the query, in the order of the query
+/// @param snapshot The snapshot
+/// @param query The query
+/// @param results The catalog indices
+/// @param capacity The maximum number of results
+/// @return The number of results
+usize visibility_snapshot_query(VisibilitySnapshot const *snapshot, VisibilityQuery const *query, u32 *results,
+                                usize capacity);
+
+#endif// KOPERNIKUS_VISIBILITY_H